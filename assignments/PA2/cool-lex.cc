@@ -699,6 +699,10 @@ char *yytext;
 #include <stringtab.h>
 #include <utilities.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <scan-skip.h>
 
 /* The compiler assumes these identifiers. */
 #define yylval cool_yylval
@@ -722,6 +726,38 @@ extern FILE *fin; /* we read from this file */
 char string_buf[MAX_STR_CONST]; /* to assemble string constants */
 char *string_buf_ptr;
 
+/* The position yyinput() reads from next, for skipping runs of
+ * characters with the functions in scan-skip.h.  Flex keeps the
+ * character there in yy_hold_char while it is overwritten. */
+static char *scan_position() {
+  *yy_c_buf_p = yy_hold_char;
+  return yy_c_buf_p;
+}
+
+static void set_scan_position(char *p) {
+  yy_c_buf_p = p;
+  yy_hold_char = *p;
+}
+
+/* Add the ordinary characters at the scan position to the string
+ * constant of length *len in string_buf, as the string rule would
+ * one at a time: past MAX_STR_CONST only the last one is kept. */
+static void append_string_run(int *len) {
+  char *run = scan_position();
+  char *end = skip_string_run(run);
+  int n = end - run;
+  int room = MAX_STR_CONST - *len;
+  if(n <= room) {
+    memcpy(string_buf + *len, run, n);
+    *len += n;
+  } else {
+    memcpy(string_buf + *len, run, room);
+    *len = MAX_STR_CONST;
+    string_buf[MAX_STR_CONST - 1] = end[-1];
+  }
+  set_scan_position(end);
+}
+
 extern int curr_lineno;
 extern int verbose_flag;
 
@@ -736,7 +772,7 @@ int comment_match();
  * Define names for regular expressions here.
  */
 /*bool_const      true|false */
-#line 740 "cool-lex.cc"
+#line 776 "cool-lex.cc"
 
 #define INITIAL 0
 #define Class 1
@@ -1022,10 +1058,10 @@ YY_DECL
 
 	{
 /* %% [7.0] user's declarations go here */
-#line 89 "cool.flex"
+#line 125 "cool.flex"
 
 
-#line 1029 "cool-lex.cc"
+#line 1065 "cool-lex.cc"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -1108,7 +1144,7 @@ do_action:	/* This label is used only to access EOF actions. */
 case 1:
 /* rule 1 can match eol */
 YY_RULE_SETUP
-#line 91 "cool.flex"
+#line 127 "cool.flex"
 {
   for(unsigned int i = 0; i < yyleng; i++) {
     if(yytext[i] == '\n') {
@@ -1119,10 +1155,12 @@ YY_RULE_SETUP
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 98 "cool.flex"
+#line 134 "cool.flex"
 {
   char c;
-  while((c = yyinput()) != '\n' && c!=EOF); 
+  do {
+    set_scan_position(skip_line_run(scan_position()));
+  } while((c = yyinput()) != '\n' && c!=EOF);
   if(c == '\n') {
     curr_lineno++;
   }
@@ -1130,7 +1168,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 3:
 YY_RULE_SETUP
-#line 105 "cool.flex"
+#line 143 "cool.flex"
 {
   int result = comment_match();
   if(result != -1) { /**return error**/
@@ -1140,11 +1178,24 @@ YY_RULE_SETUP
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 111 "cool.flex"
+#line 149 "cool.flex"
 { /**str_const**/
+  /* Most string constants have no escapes, so look for the closing
+   * quote in place and intern the characters between the quotes
+   * without assembling them in string_buf.  flex always ends its
+   * buffer with a NUL, which stops the search. */
+  char *str_start = scan_position();
+  char *str_end = skip_string_run(str_start);
+  if(*str_end == '\"' && str_end - str_start < MAX_STR_CONST) {
+    cool_yylval.symbol = stringtable.add_string(str_start, str_end - str_start);
+    set_scan_position(str_end + 1);
+    return (STR_CONST);
+  }
+
   int curr_strlen = 0;
   int null_flag = 0;
   char c;
+  append_string_run(&curr_strlen);
   while((c = yyinput()) != '\n' && c != '\"' && c != EOF) {
     if(curr_strlen < MAX_STR_CONST) {
       curr_strlen++;
@@ -1174,6 +1225,7 @@ YY_RULE_SETUP
     } else {
       string_buf[curr_strlen - 1] = c;
     } 
+    append_string_run(&curr_strlen);
   } 
   if(c == '\n') {
     curr_lineno++;
@@ -1200,105 +1252,105 @@ YY_RULE_SETUP
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 167 "cool.flex"
+#line 219 "cool.flex"
 { return (CLASS); }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 168 "cool.flex"
+#line 220 "cool.flex"
 { return (ELSE); }    
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 169 "cool.flex"
+#line 221 "cool.flex"
 { return (FI); } 
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 170 "cool.flex"
+#line 222 "cool.flex"
 { return (IF); } 
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 171 "cool.flex"
+#line 223 "cool.flex"
 { return (IN); } 
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 172 "cool.flex"
+#line 224 "cool.flex"
 { return (INHERITS); }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 173 "cool.flex"
+#line 225 "cool.flex"
 { return (LET); }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 174 "cool.flex"
+#line 226 "cool.flex"
 { return (LOOP); }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 175 "cool.flex"
+#line 227 "cool.flex"
 { return (POOL); }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 176 "cool.flex"
+#line 228 "cool.flex"
 { return (THEN); }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 177 "cool.flex"
+#line 229 "cool.flex"
 { return (WHILE); }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 178 "cool.flex"
+#line 230 "cool.flex"
 { return (CASE); }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 179 "cool.flex"
+#line 231 "cool.flex"
 { return (ESAC); }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 180 "cool.flex"
+#line 232 "cool.flex"
 { return (OF); }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 181 "cool.flex"
+#line 233 "cool.flex"
 { return (NEW); }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 182 "cool.flex"
+#line 234 "cool.flex"
 { return (ISVOID); }
 	YY_BREAK
 case 21:
 YY_RULE_SETUP
-#line 183 "cool.flex"
+#line 235 "cool.flex"
 { return (ASSIGN); }
 	YY_BREAK
 case 22:
 YY_RULE_SETUP
-#line 184 "cool.flex"
+#line 236 "cool.flex"
 { return (NOT); }
 	YY_BREAK
 case 23:
 YY_RULE_SETUP
-#line 185 "cool.flex"
+#line 237 "cool.flex"
 { 
-  cool_yylval.symbol = inttable.add_string(yytext);
+  cool_yylval.symbol = inttable.add_string(yytext, yyleng);
   return (INT_CONST); 
 }
 	YY_BREAK
 case 24:
 YY_RULE_SETUP
-#line 189 "cool.flex"
+#line 241 "cool.flex"
 {
   if(yytext[0] == 't') {
     cool_yylval.boolean = true;
@@ -1310,113 +1362,113 @@ YY_RULE_SETUP
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 197 "cool.flex"
+#line 249 "cool.flex"
 {
-  cool_yylval.symbol = idtable.add_string(yytext);
+  cool_yylval.symbol = idtable.add_string(yytext, yyleng);
   return (OBJECTID); 
 }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 201 "cool.flex"
+#line 253 "cool.flex"
 {
-  cool_yylval.symbol = idtable.add_string(yytext);
+  cool_yylval.symbol = idtable.add_string(yytext, yyleng);
   return (TYPEID);
 }
 	YY_BREAK
 case 27:
 YY_RULE_SETUP
-#line 205 "cool.flex"
+#line 257 "cool.flex"
 { return '+'; }
 	YY_BREAK
 case 28:
 YY_RULE_SETUP
-#line 206 "cool.flex"
+#line 258 "cool.flex"
 { return '/'; }
 	YY_BREAK
 case 29:
 YY_RULE_SETUP
-#line 207 "cool.flex"
+#line 259 "cool.flex"
 { return '-'; }
 	YY_BREAK
 case 30:
 YY_RULE_SETUP
-#line 208 "cool.flex"
+#line 260 "cool.flex"
 { return '*'; }
 	YY_BREAK
 case 31:
 YY_RULE_SETUP
-#line 209 "cool.flex"
+#line 261 "cool.flex"
 { return '='; }
 	YY_BREAK
 case 32:
 YY_RULE_SETUP
-#line 210 "cool.flex"
+#line 262 "cool.flex"
 { return '<'; }
 	YY_BREAK
 case 33:
 YY_RULE_SETUP
-#line 211 "cool.flex"
+#line 263 "cool.flex"
 { return '.'; }
 	YY_BREAK
 case 34:
 YY_RULE_SETUP
-#line 212 "cool.flex"
+#line 264 "cool.flex"
 { return '~'; }
 	YY_BREAK
 case 35:
 YY_RULE_SETUP
-#line 213 "cool.flex"
+#line 265 "cool.flex"
 { return ','; }
 	YY_BREAK
 case 36:
 YY_RULE_SETUP
-#line 214 "cool.flex"
+#line 266 "cool.flex"
 { return ';'; }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 215 "cool.flex"
+#line 267 "cool.flex"
 { return ':'; }
 	YY_BREAK
 case 38:
 YY_RULE_SETUP
-#line 216 "cool.flex"
+#line 268 "cool.flex"
 { return '('; }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 217 "cool.flex"
+#line 269 "cool.flex"
 { return ')'; }
 	YY_BREAK
 case 40:
 YY_RULE_SETUP
-#line 218 "cool.flex"
+#line 270 "cool.flex"
 { return '@'; }
 	YY_BREAK
 case 41:
 YY_RULE_SETUP
-#line 219 "cool.flex"
+#line 271 "cool.flex"
 { return '{'; }
 	YY_BREAK
 case 42:
 YY_RULE_SETUP
-#line 220 "cool.flex"
+#line 272 "cool.flex"
 { return '}'; }
 	YY_BREAK
 case 43:
 YY_RULE_SETUP
-#line 221 "cool.flex"
+#line 273 "cool.flex"
 { return (LE); }
 	YY_BREAK
 case 44:
 YY_RULE_SETUP
-#line 222 "cool.flex"
+#line 274 "cool.flex"
 { return (DARROW); }
 	YY_BREAK
 case 45:
 YY_RULE_SETUP
-#line 223 "cool.flex"
+#line 275 "cool.flex"
 {
   cool_yylval.error_msg = "Unmatched *)";
   return (ERROR);
@@ -1424,7 +1476,7 @@ YY_RULE_SETUP
 	YY_BREAK
 case 46:
 YY_RULE_SETUP
-#line 227 "cool.flex"
+#line 279 "cool.flex"
 {
   cool_yylval.error_msg = yytext;
   return (ERROR); 
@@ -1432,10 +1484,10 @@ YY_RULE_SETUP
 	YY_BREAK
 case 47:
 YY_RULE_SETUP
-#line 232 "cool.flex"
+#line 284 "cool.flex"
 ECHO;
 	YY_BREAK
-#line 1439 "cool-lex.cc"
+#line 1491 "cool-lex.cc"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(Class):
 	yyterminate();
@@ -2583,12 +2635,13 @@ void yyfree (void * ptr )
 
 /* %ok-for-header */
 
-#line 232 "cool.flex"
+#line 284 "cool.flex"
 
 
 
 int comment_match() {
   char c;
+  set_scan_position(skip_comment_run(scan_position(), &curr_lineno));
   while((c = yyinput()) != EOF) {
     if(c == '\n') {
       curr_lineno++;
@@ -2631,6 +2684,7 @@ int comment_match() {
         return (ERROR);
       }
     }
+    set_scan_position(skip_comment_run(scan_position(), &curr_lineno));
   }
   if(c == EOF) {
     cool_yylval.error_msg = "EOF in comment";
@@ -2638,3 +2692,62 @@ int comment_match() {
   }
 }
 
+/*
+ *  Memory-mapped input.
+ *
+ *  cool_map_file(f) makes the scanner read the file f is open on
+ *  straight out of a private mapping of it, instead of having YY_INPUT
+ *  copy it into flex's buffer.  yytext then points into the mapping,
+ *  and since the string tables are given (pointer,length) pairs,
+ *  identifiers, integers and strings without escapes are interned
+ *  without any intermediate copy.  The mapping is copy-on-write because
+ *  flex terminates yytext in place, and is two bytes longer than the
+ *  file, since flex wants two NULs at the end of a buffer it does not
+ *  fill itself.
+ *
+ *  Call it after opening each input file.  The previous file's mapping
+ *  is released.  If f cannot be mapped (a pipe, say) the scanner goes
+ *  back to reading it through YY_INPUT.  Returns 1 if f was mapped.
+ */
+static YY_BUFFER_STATE map_buffer = NULL;  /* flex's buffer over the mapping */
+static char *map_base;
+static size_t map_size;
+
+int cool_map_file(FILE *f) {
+  YY_BUFFER_STATE old_buffer = map_buffer;
+  char *old_base = map_base;
+  size_t old_size = map_size;
+  struct stat st;
+  char *base = (char *) MAP_FAILED;
+  size_t size = 0;
+
+  if(fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+    size = st.st_size + 2;
+    base = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base != MAP_FAILED && st.st_size > 0 &&
+       mmap(base, st.st_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED, fileno(f), 0) == MAP_FAILED) {
+      munmap(base, size);
+      base = (char *) MAP_FAILED;
+    }
+  }
+
+  map_buffer = NULL;
+  if(base != MAP_FAILED) {
+    map_buffer = yy_scan_buffer(base, size);
+    map_base = base;
+    map_size = size;
+    /* flex falls back on YY_INPUT after an unterminated string or
+     * comment; make that see the end of the file, as it would have. */
+    fseek(f, 0, SEEK_END);
+  } else if(old_buffer != NULL) {
+    yy_switch_to_buffer(yy_create_buffer(yyin, YY_BUF_SIZE));
+  }
+
+  if(old_buffer != NULL) {
+    yy_delete_buffer(old_buffer);
+    munmap(old_base, old_size);
+  }
+  return map_buffer != NULL;
+}
@@ -0,0 +1,508 @@
+/*
+ *  A hand-written scanner for COOL.
+ *
+ *  This is a drop-in replacement for the flex scanner in cool.flex:
+ *  it defines cool_yylex and cool_map_file and returns exactly the
+ *  same tokens, line numbers and error messages.  Build it with
+ *
+ *      make lexer SCANNER=hand
+ *
+ *  Instead of flex's tables it dispatches on the first character of
+ *  each token and recognizes identifiers, integers and white space
+ *  with tight loops.  Keywords are found by a perfect hash on the
+ *  lowercased lexeme.
+ *
+ *  The whole of each input file is scanned in memory, either from a
+ *  mapping made by cool_map_file or, failing that, from a copy read
+ *  from fin.  The buffer is always followed by a NUL, which stops the
+ *  loops at the end of the file.  Comments and string constants with
+ *  escapes are read with input(), which behaves like flex's yyinput(),
+ *  so those rules are the ones in cool.flex; as there, runs of
+ *  characters they need not look at are skipped with scan-skip.h.
+ */
+
+#include <cool-parse.h>
+#include <stringtab.h>
+#include <utilities.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <scan-skip.h>
+
+/* Max size of string constants */
+#define MAX_STR_CONST 1025
+
+extern FILE *fin; /* we read from this file */
+
+extern "C" int yywrap(void);
+
+/* handle_flags sets this for the flex scanner; there is nothing to trace here */
+int yy_flex_debug;
+
+char string_buf[MAX_STR_CONST]; /* to assemble string constants */
+
+extern int curr_lineno;
+extern YYSTYPE cool_yylval;
+int comment_match();
+
+/*
+ *  The input buffer.  [buf_start, buf_end) is the current file and
+ *  *buf_end is a NUL.  buf_mapped says whether it has to be unmapped
+ *  or freed, and buf_serial counts the files installed, so that the
+ *  scanner can tell whether yywrap() opened a file with cool_map_file.
+ */
+static char *buf_start = NULL;
+static char *buf_end;
+static char *cur;
+static size_t buf_size;
+static int buf_mapped;
+static int buf_serial = 0;
+
+static char error_text[2]; /* the text of a one-character ERROR token */
+
+static void release_buffer() {
+  if(buf_start == NULL) {
+    return;
+  }
+  if(buf_mapped) {
+    munmap(buf_start, buf_size);
+  } else {
+    free(buf_start);
+  }
+  buf_start = NULL;
+}
+
+/*
+ *  Read the rest of fin into memory, for input that cannot be mapped.
+ */
+static void read_fin() {
+  /* room after the input for the NUL and a vector load past it */
+  const size_t pad = 64;
+  size_t len = 0, cap = 64 * 1024;
+  char *buf = (char *) malloc(cap + pad);
+  size_t n;
+  while(buf != NULL && (n = fread(buf + len, 1, cap - len, fin)) > 0) {
+    len += n;
+    if(len == cap) {
+      cap *= 2;
+      buf = (char *) realloc(buf, cap + pad);
+    }
+  }
+  if(buf == NULL) {
+    fatal_error("out of memory in scanner\n");
+  }
+  buf[len] = '\0';
+
+  release_buffer();
+  buf_start = cur = buf;
+  buf_end = buf + len;
+  buf_size = cap + pad;
+  buf_mapped = 0;
+  buf_serial++;
+}
+
+/*
+ *  Memory-mapped input, as in cool.flex.  The mapping is one byte
+ *  longer than the file so that the terminating NUL is there; it is
+ *  read-only, since this scanner never writes into its buffer.
+ *  Returns 1 if f was mapped; otherwise f is read when scanning starts.
+ */
+int cool_map_file(FILE *f) {
+  struct stat st;
+  char *base = (char *) MAP_FAILED;
+  size_t size = 0;
+
+  if(fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+    size = st.st_size + 1;
+    base = (char *) mmap(NULL, size, PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(base != MAP_FAILED && st.st_size > 0 &&
+       mmap(base, st.st_size, PROT_READ,
+            MAP_PRIVATE | MAP_FIXED, fileno(f), 0) == MAP_FAILED) {
+      munmap(base, size);
+      base = (char *) MAP_FAILED;
+    }
+  }
+
+  release_buffer();
+  if(base == MAP_FAILED) {
+    buf_serial++;      /* read f when scanning starts */
+    return 0;
+  }
+  buf_start = cur = base;
+  buf_end = base + size - 1;
+  buf_size = size;
+  buf_mapped = 1;
+  buf_serial++;
+  return 1;
+}
+
+/*
+ *  Called at the end of a file.  Returns 1 if the scanner should stop,
+ *  and 0 if yywrap() has given it another file.
+ */
+static int end_of_file() {
+  int serial = buf_serial;
+  if(yywrap()) {
+    return 1;
+  }
+  if(buf_serial == serial) {
+    read_fin();     /* the next file was opened on fin without mapping it */
+  }
+  return 0;
+}
+
+/*
+ *  The next character of the input, or EOF, like flex's yyinput().
+ */
+static int input() {
+  if(buf_start == NULL) {
+    read_fin();
+  }
+  while(cur == buf_end) {
+    if(end_of_file()) {
+      return EOF;
+    }
+  }
+  return (unsigned char) *cur++;
+}
+
+/*
+ *  The keywords, by perfect hash.  KEYWORD_HASH is collision-free on
+ *  the lowercased keywords; a lexeme is a keyword only if it also
+ *  matches the table entry ignoring case.  true and false are only
+ *  keywords when they start with a lowercase letter.
+ */
+#define KEYWORD_HASH(s, len) \
+  ((((s)[0] | 0x20) + 2 * ((s)[(len) - 1] | 0x20) + 26 * (len)) & 31)
+
+struct keyword {
+  const char *name;
+  int token;
+};
+
+static struct keyword keywords[32];
+static int keywords_ready = 0;
+
+static void init_keywords() {
+  static const struct keyword list[] = {
+    { "class", CLASS }, { "else", ELSE }, { "fi", FI }, { "if", IF },
+    { "in", IN }, { "inherits", INHERITS }, { "let", LET },
+    { "loop", LOOP }, { "pool", POOL }, { "then", THEN },
+    { "while", WHILE }, { "case", CASE }, { "esac", ESAC }, { "of", OF },
+    { "new", NEW }, { "isvoid", ISVOID }, { "not", NOT },
+    { "true", BOOL_CONST }, { "false", BOOL_CONST }
+  };
+  for(unsigned int i = 0; i < sizeof(list) / sizeof(list[0]); i++) {
+    const char *s = list[i].name;
+    keywords[KEYWORD_HASH(s, (int) strlen(s))] = list[i];
+  }
+  keywords_ready = 1;
+}
+
+/*
+ *  Returns the keyword token for the lexeme s of length len, or 0.
+ */
+static int keyword_token(const char *s, int len) {
+  if(len < 2 || len > 8) {
+    return 0;
+  }
+  const struct keyword &k = keywords[KEYWORD_HASH(s, len)];
+  if(k.name == NULL) {
+    return 0;
+  }
+  for(int i = 0; i < len; i++) {
+    if((s[i] | 0x20) != k.name[i]) {
+      return 0;
+    }
+  }
+  if(k.name[len] != '\0') {
+    return 0;
+  }
+  if(k.token == BOOL_CONST) {
+    if(s[0] != k.name[0]) {
+      return 0;    /* True and False are type names */
+    }
+    cool_yylval.boolean = (s[0] == 't');
+  }
+  return k.token;
+}
+
+/* character classes */
+#define IS_DIGIT(c)  ((c) >= '0' && (c) <= '9')
+#define IS_LETTER(c) (((c) | 0x20) >= 'a' && ((c) | 0x20) <= 'z')
+#define IS_IDENT(c)  (IS_LETTER(c) || IS_DIGIT(c) || (c) == '_')
+
+static int string_const();
+
+int cool_yylex() {
+  if(!keywords_ready) {
+    init_keywords();
+  }
+  if(buf_start == NULL) {
+    read_fin();
+  }
+
+  for(;;) {
+    char *p = cur;
+    if(p == buf_end) {
+      if(end_of_file()) {
+        return 0;
+      }
+      continue;
+    }
+
+    unsigned char c = *p;
+    switch(c) {
+    case ' ': case '\n': case '\f': case '\r': case '\t': case '\v':
+      for(; *p == ' ' || *p == '\n' || *p == '\f' || *p == '\r' ||
+            *p == '\t' || *p == '\v'; p++) {
+        if(*p == '\n') {
+          curr_lineno++;
+        }
+      }
+      cur = p;
+      continue;
+
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      while(IS_DIGIT(*p)) {
+        p++;
+      }
+      cool_yylval.symbol = inttable.add_string(cur, p - cur);
+      cur = p;
+      return (INT_CONST);
+
+    case '\"':
+      cur = p + 1;
+      return string_const();
+
+    case '-':
+      if(p[1] == '-') {
+        cur = p + 2;
+        char c;
+        do {
+          cur = skip_line_run(cur);
+        } while((c = input()) != '\n' && c!=EOF);
+        if(c == '\n') {
+          curr_lineno++;
+        }
+        continue;
+      }
+      break;
+
+    case '(':
+      if(p[1] == '*') {
+        cur = p + 2;
+        int result = comment_match();
+        if(result != -1) { /**return error**/
+          return result;
+        }
+        continue;
+      }
+      break;
+
+    case '*':
+      if(p[1] == ')') {
+        cur = p + 2;
+        cool_yylval.error_msg = "Unmatched *)";
+        return (ERROR);
+      }
+      break;
+
+    case '<':
+      if(p[1] == '-') {
+        cur = p + 2;
+        return (ASSIGN);
+      }
+      if(p[1] == '=') {
+        cur = p + 2;
+        return (LE);
+      }
+      break;
+
+    case '=':
+      if(p[1] == '>') {
+        cur = p + 2;
+        return (DARROW);
+      }
+      break;
+
+    default:
+      if(IS_LETTER(c)) {
+        while(IS_IDENT(*p)) {
+          p++;
+        }
+        int len = p - cur;
+        char *s = cur;
+        cur = p;
+        int token = keyword_token(s, len);
+        if(token != 0) {
+          return token;
+        }
+        cool_yylval.symbol = idtable.add_string(s, len);
+        return (c <= 'Z') ? TYPEID : OBJECTID;
+      }
+      break;
+    }
+
+    /* a single character */
+    cur = p + 1;
+    switch(c) {
+    case '+': case '/': case '-': case '*': case '=': case '<': case '.':
+    case '~': case ',': case ';': case ':': case '(': case ')': case '@':
+    case '{': case '}':
+      return c;
+    default:
+      error_text[0] = c;
+      error_text[1] = '\0';
+      cool_yylval.error_msg = error_text;
+      return (ERROR);
+    }
+  }
+}
+
+/*
+ *  Add the ordinary characters at cur to the string constant of length
+ *  *len in string_buf, as the loop in string_const would one at a time:
+ *  past MAX_STR_CONST only the last one is kept.
+ */
+static void append_string_run(int *len) {
+  char *end = skip_string_run(cur);
+  int n = end - cur;
+  int room = MAX_STR_CONST - *len;
+  if(n <= room) {
+    memcpy(string_buf + *len, cur, n);
+    *len += n;
+  } else {
+    memcpy(string_buf + *len, cur, room);
+    *len = MAX_STR_CONST;
+    string_buf[MAX_STR_CONST - 1] = end[-1];
+  }
+  cur = end;
+}
+
+/*
+ *  The body of a string constant, after the opening quote.  The search
+ *  for the closing quote is the fast path of the rule in cool.flex; the
+ *  loop after it is that rule's action.
+ */
+static int string_const() {
+  char *str_start = cur;
+  char *str_end = skip_string_run(str_start);
+  if(*str_end == '\"' && str_end - str_start < MAX_STR_CONST) {
+    cool_yylval.symbol = stringtable.add_string(str_start, str_end - str_start);
+    cur = str_end + 1;
+    return (STR_CONST);
+  }
+
+  int curr_strlen = 0;
+  int null_flag = 0;
+  char c;
+  append_string_run(&curr_strlen);
+  while((c = input()) != '\n' && c != '\"' && c != EOF) {
+    if(curr_strlen < MAX_STR_CONST) {
+      curr_strlen++;
+    }
+    if(c == '\\') {
+      if((c = input()) == 'b') {
+        string_buf[curr_strlen - 1] = '\b';
+      } else if(c == 't') {
+        string_buf[curr_strlen - 1] = '\t';
+      } else if(c == 'n') {
+        string_buf[curr_strlen - 1] = '\n';
+      } else if(c == 'f') {
+        string_buf[curr_strlen - 1] = '\f';
+      } else if(c == '\0') { // eat up all other valid/invalid character in quote
+        null_flag = 1;
+      } else if(c == EOF) {
+        cool_yylval.error_msg = "EOF in string constant";
+        return (ERROR);
+      } else {
+        if(c == '\n') {
+          curr_lineno++;
+        }
+        string_buf[curr_strlen - 1] = c;
+      }
+    } else if(c == '\0') {
+      null_flag = 1;
+    } else {
+      string_buf[curr_strlen - 1] = c;
+    }
+    append_string_run(&curr_strlen);
+  }
+  if(c == '\n') {
+    curr_lineno++;
+    cool_yylval.error_msg = "Unterminated string constant";
+    return (ERROR);
+  }
+  if(c == EOF) {
+    cool_yylval.error_msg = "EOF in string constant";
+    return (ERROR);
+  }
+  if(null_flag == 1) {
+    cool_yylval.error_msg = "String contains null value";
+    return (ERROR);
+  } else if(curr_strlen >= MAX_STR_CONST) {
+    cool_yylval.error_msg = "String constant too long";
+    return (ERROR);
+  }
+  cool_yylval.symbol = stringtable.add_string(string_buf, curr_strlen);
+  return (STR_CONST);
+}
+
+/*
+ *  Nested comments, as in cool.flex.
+ */
+int comment_match() {
+  char c;
+  cur = skip_comment_run(cur, &curr_lineno);
+  while((c = input()) != EOF) {
+    if(c == '\n') {
+      curr_lineno++;
+    }
+    if(c == '\\') { /**deal with escape in comments*/
+      if((c = input()) == EOF) {
+        cool_yylval.error_msg = "EOF in comment";
+        return (ERROR);
+      }
+    }
+    if(c == '(') {
+      while((c = input()) == '(') {}
+      if(c == '*') { /**start a new comment match*/
+        comment_match();
+      } else if(c == '\n') {
+        curr_lineno++;
+      } else if(c == '\\') { /**deal with escape in comments*/
+        if((c = input()) == EOF) {
+          cool_yylval.error_msg = "EOF in comment";
+          return (ERROR);
+        }
+      } else if(c == EOF) {
+        cool_yylval.error_msg = "EOF in comment";
+        return (ERROR);
+      }
+    }
+    if(c == '*') {
+      while((c = input()) == '*') {}
+      if(c == ')') { /**end comment*/
+        return -1;
+      } else if(c == '\n') {
+        curr_lineno++;
+      } else if(c == '\\') { /**deal with escape in comments*/
+        if((c = input()) == EOF) {
+          cool_yylval.error_msg = "EOF in comment";
+          return (ERROR);
+        }
+      } else if(c == EOF) {
+        cool_yylval.error_msg = "EOF in comment";
+        return (ERROR);
+      }
+    }
+    cur = skip_comment_run(cur, &curr_lineno);
+  }
+  cool_yylval.error_msg = "EOF in comment";
+  return (ERROR);
+}
@@ -32,6 +32,7 @@ FILE *fin;   // This is the file pointer from which the lexer reads its input.
 //  token each time it is called.
 //
 extern int cool_yylex();
+extern int cool_map_file(FILE *f); // scan f from a mapping of it
 YYSTYPE cool_yylval;           // Not compiled with parser, so must define this.
 
 extern int optind;  // used for option processing (man 3 getopt for more info)
@@ -73,6 +74,7 @@ int main(int argc, char** argv) {
             // this counter, so let's make the stand-alone lexer
             // do the same thing
             curr_lineno = 1;
+            cool_map_file(fin);
 
 	    //
 	    // Scan and print all tokens.
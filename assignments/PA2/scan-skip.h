@@ -0,0 +1,143 @@
+/*
+ *  Skipping runs of ordinary characters in the scanners.
+ *
+ *  Inside a string constant or a comment most characters need no
+ *  attention, and the scanners' rules only have to look at the few
+ *  that do.  These functions find the next such character with SSE2
+ *  or AVX2 compares, 16 or 32 bytes at a time, or a byte at a time
+ *  where neither is available.
+ *
+ *  The input must contain a NUL at or after p, which stops every
+ *  search; both scanners keep one at the end of their buffers.  The
+ *  vector loads are aligned, so they never cross into a page the
+ *  buffer does not reach, though they may read a little past the NUL.
+ *
+ *  A 0xff byte also stops every search.  The scanners read characters
+ *  into a plain `char' and compare them with EOF, so that byte ends a
+ *  string or comment just as the end of the file does.
+ */
+
+#ifndef SCAN_SKIP_H
+#define SCAN_SKIP_H
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+typedef __m256i skip_vec;
+#define SKIP_WIDTH 32
+#define skip_load(p)   _mm256_load_si256((const __m256i *) (p))
+#define skip_set1(c)   _mm256_set1_epi8(c)
+#define skip_eq(a, b)  _mm256_cmpeq_epi8(a, b)
+#define skip_or(a, b)  _mm256_or_si256(a, b)
+#define skip_mask(a)   ((unsigned) _mm256_movemask_epi8(a))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128i skip_vec;
+#define SKIP_WIDTH 16
+#define skip_load(p)   _mm_load_si128((const __m128i *) (p))
+#define skip_set1(c)   _mm_set1_epi8(c)
+#define skip_eq(a, b)  _mm_cmpeq_epi8(a, b)
+#define skip_or(a, b)  _mm_or_si128(a, b)
+#define skip_mask(a)   ((unsigned) _mm_movemask_epi8(a))
+#endif
+
+/*
+ *  The first of `"', `\\', newline, NUL or 0xff at or after p: the
+ *  characters the string constant rule has to handle itself.
+ */
+static inline char *skip_string_run(char *p) {
+#ifdef SKIP_WIDTH
+  const skip_vec quote = skip_set1('\"'), backslash = skip_set1('\\');
+  const skip_vec newline = skip_set1('\n'), nul = skip_set1('\0');
+  const skip_vec ff = skip_set1((char) 0xff);
+  unsigned off = (uintptr_t) p & (SKIP_WIDTH - 1);
+  char *block = p - off;
+  unsigned mask = ~0u << off;
+  for(;;) {
+    skip_vec v = skip_load(block);
+    mask &= skip_mask(skip_or(skip_or(skip_eq(v, quote), skip_eq(v, backslash)),
+                              skip_or(skip_or(skip_eq(v, newline), skip_eq(v, nul)),
+                                      skip_eq(v, ff))));
+    if(mask != 0) {
+      return block + __builtin_ctz(mask);
+    }
+    block += SKIP_WIDTH;
+    mask = ~0u;
+  }
+#else
+  while(*p != '\"' && *p != '\\' && *p != '\n' && *p != '\0' && *p != (char) 0xff) {
+    p++;
+  }
+  return p;
+#endif
+}
+
+/*
+ *  The first newline, NUL or 0xff at or after p, which is where a
+ *  `--' comment might end.
+ */
+static inline char *skip_line_run(char *p) {
+#ifdef SKIP_WIDTH
+  const skip_vec newline = skip_set1('\n'), nul = skip_set1('\0');
+  const skip_vec ff = skip_set1((char) 0xff);
+  unsigned off = (uintptr_t) p & (SKIP_WIDTH - 1);
+  char *block = p - off;
+  unsigned mask = ~0u << off;
+  for(;;) {
+    skip_vec v = skip_load(block);
+    mask &= skip_mask(skip_or(skip_eq(v, newline), skip_or(skip_eq(v, nul), skip_eq(v, ff))));
+    if(mask != 0) {
+      return block + __builtin_ctz(mask);
+    }
+    block += SKIP_WIDTH;
+    mask = ~0u;
+  }
+#else
+  while(*p != '\n' && *p != '\0' && *p != (char) 0xff) {
+    p++;
+  }
+  return p;
+#endif
+}
+
+/*
+ *  The first `(', `*', `\\', NUL or 0xff at or after p: the characters
+ *  that can matter inside a (* comment *).  Newlines are skipped too,
+ *  but counted into *lines.
+ */
+static inline char *skip_comment_run(char *p, int *lines) {
+#ifdef SKIP_WIDTH
+  const skip_vec lparen = skip_set1('('), star = skip_set1('*');
+  const skip_vec backslash = skip_set1('\\'), nul = skip_set1('\0');
+  const skip_vec ff = skip_set1((char) 0xff), newline = skip_set1('\n');
+  unsigned off = (uintptr_t) p & (SKIP_WIDTH - 1);
+  char *block = p - off;
+  unsigned live = ~0u << off;
+  for(;;) {
+    skip_vec v = skip_load(block);
+    unsigned stops = live & skip_mask(skip_or(skip_or(skip_eq(v, lparen), skip_eq(v, star)),
+                                              skip_or(skip_or(skip_eq(v, backslash), skip_eq(v, nul)),
+                                                      skip_eq(v, ff))));
+    unsigned newlines = live & skip_mask(skip_eq(v, newline));
+    if(stops != 0) {
+      int at = __builtin_ctz(stops);
+      *lines += __builtin_popcount(newlines & ((1u << at) - 1));
+      return block + at;
+    }
+    *lines += __builtin_popcount(newlines);
+    block += SKIP_WIDTH;
+    live = ~0u;
+  }
+#else
+  while(*p != '(' && *p != '*' && *p != '\\' && *p != '\0' && *p != (char) 0xff) {
+    if(*p == '\n') {
+      (*lines)++;
+    }
+    p++;
+  }
+  return p;
+#endif
+}
+
+#endif
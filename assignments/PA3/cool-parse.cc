@@ -83,6 +83,7 @@
   
   /* Locations */
   #define YYLTYPE int              /* the type of locations */
+  #define YYINITDEPTH 10000        /* bison never grows the stacks in C++ */
   #define cool_yylloc curr_lineno  /* use the curr_lineno from the lexer
   for the location of tokens */
     
@@ -153,8 +154,82 @@
     Classes parse_results;        /* for use in semantic analysis */
     int omerrs = 0;               /* number of errors in lexing and parsing */
     
+    
+    /* Lists under construction.  The value of a list nonterminal is a
+    ListBuffer that its rules add elements to, and the rule that uses
+    the whole list turns it into one array_node with to_list.  Buffers
+    go back on a free list once they have been turned into lists, so
+    the space they have grown stays in use for the next list. */
+    class ListBuffer {
+    private:
+      tree_node **elems;
+      int length;
+      int capacity;
+      ListBuffer *next_free;
+      static ListBuffer *free_list;
+      
+      void grow() {
+        capacity = capacity ? 2 * capacity : 8;
+        elems = (tree_node **) realloc(elems, capacity * sizeof(tree_node *));
+      }
+    public:
+      /* an empty buffer */
+      static ListBuffer *start() {
+        ListBuffer *b = free_list;
+        if (b != NULL)
+          free_list = b->next_free;
+        else {
+          b = new ListBuffer;
+          b->elems = NULL;
+          b->capacity = 0;
+        }
+        b->length = 0;
+        return b;
+      }
+      
+      ListBuffer *add(tree_node *e) {
+        if (length == capacity)
+          grow();
+        elems[length++] = e;
+        return this;
+      }
+      
+      /* the elements as a list; the buffer is free again afterwards */
+      template <class Elem> list_node<Elem> *to_list() {
+        Elem *out = (Elem *) node_arena.alloc((length ? length : 1) * sizeof(Elem));
+        for (int i = 0; i < length; i++)
+          out[i] = static_cast<Elem>(elems[i]);
+        list_node<Elem> *l = list_node<Elem>::array(out, length);
+        next_free = free_list;
+        free_list = this;
+        return l;
+      }
+    };
+    ListBuffer *ListBuffer::free_list = NULL;
+    
+    /* Symbols the actions supply themselves, entered once. */
+    static Symbol self_sym() {
+      static Symbol sym = idtable.add_string("self");
+      return sym;
+    }
+    static Symbol object_sym() {
+      static Symbol sym = idtable.add_string("Object");
+      return sym;
+    }
+    
+    /* the file name of every class, entered once per file */
+    static Symbol filename_sym() {
+      static char *name = NULL;
+      static Symbol sym;
+      if (name != curr_filename) {
+        name = curr_filename;
+        sym = stringtable.add_string(curr_filename);
+      }
+      return sym;
+    }
+    
 
-#line 158 "cool.tab.c" /* yacc.c:339  */
+#line 233 "cool.tab.c" /* yacc.c:339  */
 
 # ifndef YY_NULLPTR
 #  if defined __cplusplus && 201103L <= __cplusplus
@@ -250,7 +325,7 @@ extern int cool_yydebug;
 
 union YYSTYPE
 {
-#line 89 "cool.y" /* yacc.c:355  */
+#line 164 "cool.y" /* yacc.c:355  */
 
       Boolean boolean;
       Symbol symbol;
@@ -266,10 +341,11 @@ union YYSTYPE
       Expression expression;
       Expressions plain_expressions;
       Expressions param_expressions;
+      ListBuffer *buffer;
       char *error_msg;
     
 
-#line 273 "cool.tab.c" /* yacc.c:355  */
+#line 349 "cool.tab.c" /* yacc.c:355  */
 };
 
 typedef union YYSTYPE YYSTYPE;
@@ -300,7 +376,7 @@ int cool_yyparse (void);
 
 /* Copy the second part of user declarations.  */
 
-#line 304 "cool.tab.c" /* yacc.c:358  */
+#line 380 "cool.tab.c" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -602,13 +678,13 @@ static const yytype_uint8 yytranslate[] =
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint16 yyrline[] =
 {
-       0,   168,   168,   172,   177,   182,   186,   191,   196,   201,
-     205,   213,   219,   223,   227,   231,   236,   240,   245,   250,
-     257,   263,   267,   274,   280,   284,   291,   298,   302,   309,
-     313,   317,   324,   329,   334,   339,   344,   349,   354,   359,
-     364,   369,   374,   379,   384,   388,   392,   396,   400,   404,
-     408,   412,   416,   420,   424,   428,   432,   436,   440,   444,
-     451,   455,   459,   463,   467
+       0,   243,   243,   252,   256,   260,   264,   272,   276,   281,
+     285,   293,   299,   303,   307,   311,   318,   322,   327,   332,
+     339,   345,   349,   356,   362,   366,   373,   380,   384,   391,
+     395,   399,   406,   411,   416,   421,   426,   431,   436,   441,
+     446,   451,   456,   461,   466,   470,   474,   478,   482,   486,
+     490,   494,   498,   502,   506,   510,   514,   518,   522,   526,
+     533,   537,   541,   545,   549
 };
 #endif
 
@@ -1620,503 +1696,514 @@ yyreduce:
   switch (yyn)
     {
         case 2:
-#line 168 "cool.y" /* yacc.c:1646  */
-    { (yyloc) = (yylsp[0]); ast_root = program((yyvsp[0].classes)); }
-#line 1626 "cool.tab.c" /* yacc.c:1646  */
+#line 244 "cool.y" /* yacc.c:1646  */
+    { 
+          (yyloc) = (yylsp[0]); 
+          parse_results = (yyvsp[0].buffer)->to_list<Class_>();
+          ast_root = program(parse_results); 
+        }
+#line 1706 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 3:
-#line 173 "cool.y" /* yacc.c:1646  */
+#line 253 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.classes) = single_Classes((yyvsp[-1].class_));
-          parse_results = (yyval.classes); 
+          (yyval.buffer) = ListBuffer::start()->add((yyvsp[-1].class_));
         }
-#line 1635 "cool.tab.c" /* yacc.c:1646  */
+#line 1714 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 4:
-#line 178 "cool.y" /* yacc.c:1646  */
+#line 257 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.classes) = append_Classes((yyvsp[-2].classes),single_Classes((yyvsp[-1].class_))); 
-          parse_results = (yyval.classes); 
+          (yyval.buffer) = (yyvsp[-2].buffer)->add((yyvsp[-1].class_)); 
         }
-#line 1644 "cool.tab.c" /* yacc.c:1646  */
+#line 1722 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 183 "cool.y" /* yacc.c:1646  */
+#line 261 "cool.y" /* yacc.c:1646  */
+    {
+          (yyval.buffer) = (yyvsp[-2].buffer);
+        }
+#line 1730 "cool.tab.c" /* yacc.c:1646  */
+    break;
+
+  case 6:
+#line 265 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.classes) = (yyvsp[-2].classes);
+          (yyval.buffer) = ListBuffer::start();
         }
-#line 1652 "cool.tab.c" /* yacc.c:1646  */
+#line 1738 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 7:
-#line 192 "cool.y" /* yacc.c:1646  */
+#line 273 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.class_) = class_((yyvsp[-3].symbol),idtable.add_string("Object"),(yyvsp[-1].features),
-                      stringtable.add_string(curr_filename)); 
+          (yyval.class_) = class_((yyvsp[-3].symbol),object_sym(),(yyvsp[-1].features),filename_sym()); 
         }
-#line 1661 "cool.tab.c" /* yacc.c:1646  */
+#line 1746 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 197 "cool.y" /* yacc.c:1646  */
+#line 277 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.class_) = class_((yyvsp[-3].symbol),idtable.add_string("Object"),(yyvsp[-1].features),
-                      stringtable.add_string(curr_filename));
+          (yyval.class_) = class_((yyvsp[-3].symbol),object_sym(),(yyvsp[-1].buffer)->to_list<Feature>(),
+                      filename_sym());
         }
-#line 1670 "cool.tab.c" /* yacc.c:1646  */
+#line 1755 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 202 "cool.y" /* yacc.c:1646  */
+#line 282 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.class_) = class_((yyvsp[-5].symbol),(yyvsp[-3].symbol),(yyvsp[-1].features),stringtable.add_string(curr_filename)); 
+          (yyval.class_) = class_((yyvsp[-5].symbol),(yyvsp[-3].symbol),(yyvsp[-1].features),filename_sym()); 
         }
-#line 1678 "cool.tab.c" /* yacc.c:1646  */
+#line 1763 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 206 "cool.y" /* yacc.c:1646  */
+#line 286 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.class_) = class_((yyvsp[-5].symbol),(yyvsp[-3].symbol),(yyvsp[-1].features),stringtable.add_string(curr_filename)); 
+          (yyval.class_) = class_((yyvsp[-5].symbol),(yyvsp[-3].symbol),(yyvsp[-1].buffer)->to_list<Feature>(),filename_sym()); 
         }
-#line 1686 "cool.tab.c" /* yacc.c:1646  */
+#line 1771 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 11:
-#line 213 "cool.y" /* yacc.c:1646  */
+#line 293 "cool.y" /* yacc.c:1646  */
     {  
         (yyval.features) = nil_Features(); 
       }
-#line 1694 "cool.tab.c" /* yacc.c:1646  */
+#line 1779 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 12:
-#line 220 "cool.y" /* yacc.c:1646  */
+#line 300 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.features) = single_Features((yyvsp[-1].feature)); 
+          (yyval.buffer) = ListBuffer::start()->add((yyvsp[-1].feature)); 
         }
-#line 1702 "cool.tab.c" /* yacc.c:1646  */
+#line 1787 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 13:
-#line 224 "cool.y" /* yacc.c:1646  */
+#line 304 "cool.y" /* yacc.c:1646  */
     { 
-          (yyval.features) = append_Features((yyvsp[-2].features), single_Features((yyvsp[-1].feature))); 
+          (yyval.buffer) = (yyvsp[-2].buffer)->add((yyvsp[-1].feature)); 
         }
-#line 1710 "cool.tab.c" /* yacc.c:1646  */
+#line 1795 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 14:
-#line 228 "cool.y" /* yacc.c:1646  */
+#line 308 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.features) = (yyvsp[-2].features);
+          (yyval.buffer) = (yyvsp[-2].buffer);
         }
-#line 1718 "cool.tab.c" /* yacc.c:1646  */
+#line 1803 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 15:
-#line 232 "cool.y" /* yacc.c:1646  */
-    {}
-#line 1724 "cool.tab.c" /* yacc.c:1646  */
+#line 312 "cool.y" /* yacc.c:1646  */
+    {
+          (yyval.buffer) = ListBuffer::start();
+        }
+#line 1811 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 16:
-#line 237 "cool.y" /* yacc.c:1646  */
+#line 319 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.feature) = method((yyvsp[-8].symbol), (yyvsp[-6].formals), (yyvsp[-3].symbol), (yyvsp[-1].expression));  
+          (yyval.feature) = method((yyvsp[-8].symbol), (yyvsp[-6].buffer)->to_list<Formal>(), (yyvsp[-3].symbol), (yyvsp[-1].expression));  
         }
-#line 1732 "cool.tab.c" /* yacc.c:1646  */
+#line 1819 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 17:
-#line 242 "cool.y" /* yacc.c:1646  */
+#line 324 "cool.y" /* yacc.c:1646  */
     {
           (yyval.feature) = method((yyvsp[-8].symbol), (yyvsp[-6].formals), (yyvsp[-3].symbol), (yyvsp[-1].expression));
         }
-#line 1740 "cool.tab.c" /* yacc.c:1646  */
+#line 1827 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 18:
-#line 246 "cool.y" /* yacc.c:1646  */
+#line 328 "cool.y" /* yacc.c:1646  */
     {
           (yyval.feature) = attr((yyvsp[-4].symbol), (yyvsp[-2].symbol), (yyvsp[0].expression)); 
         }
-#line 1748 "cool.tab.c" /* yacc.c:1646  */
+#line 1835 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 19:
-#line 251 "cool.y" /* yacc.c:1646  */
+#line 333 "cool.y" /* yacc.c:1646  */
     {
           (yyval.feature) = attr((yyvsp[-2].symbol), (yyvsp[0].symbol), no_expr()); 
         }
-#line 1756 "cool.tab.c" /* yacc.c:1646  */
+#line 1843 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 20:
-#line 257 "cool.y" /* yacc.c:1646  */
+#line 339 "cool.y" /* yacc.c:1646  */
     {
         (yyval.formals) = nil_Formals();
       }
-#line 1764 "cool.tab.c" /* yacc.c:1646  */
+#line 1851 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 21:
-#line 264 "cool.y" /* yacc.c:1646  */
+#line 346 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.formals) = append_Formals((yyvsp[-2].formals), single_Formals((yyvsp[0].formal)));
+        (yyval.buffer) = (yyvsp[-2].buffer)->add((yyvsp[0].formal));
       }
-#line 1772 "cool.tab.c" /* yacc.c:1646  */
+#line 1859 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 22:
-#line 268 "cool.y" /* yacc.c:1646  */
+#line 350 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.formals) = single_Formals((yyvsp[0].formal));
+        (yyval.buffer) = ListBuffer::start()->add((yyvsp[0].formal));
       }
-#line 1780 "cool.tab.c" /* yacc.c:1646  */
+#line 1867 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 23:
-#line 275 "cool.y" /* yacc.c:1646  */
+#line 357 "cool.y" /* yacc.c:1646  */
     {
         (yyval.formal) = formal((yyvsp[-2].symbol), (yyvsp[0].symbol)); 
       }
-#line 1788 "cool.tab.c" /* yacc.c:1646  */
+#line 1875 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 24:
-#line 281 "cool.y" /* yacc.c:1646  */
+#line 363 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.cases) = append_Cases((yyvsp[-1].cases), single_Cases((yyvsp[0].case_)));
+        (yyval.buffer) = (yyvsp[-1].buffer)->add((yyvsp[0].case_));
       }
-#line 1796 "cool.tab.c" /* yacc.c:1646  */
+#line 1883 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 25:
-#line 285 "cool.y" /* yacc.c:1646  */
+#line 367 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.cases) = single_Cases((yyvsp[0].case_));
+        (yyval.buffer) = ListBuffer::start()->add((yyvsp[0].case_));
       }
-#line 1804 "cool.tab.c" /* yacc.c:1646  */
+#line 1891 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 26:
-#line 292 "cool.y" /* yacc.c:1646  */
+#line 374 "cool.y" /* yacc.c:1646  */
     {
         (yyval.case_) = branch((yyvsp[-5].symbol), (yyvsp[-3].symbol), (yyvsp[-1].expression));
       }
-#line 1812 "cool.tab.c" /* yacc.c:1646  */
+#line 1899 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 27:
-#line 299 "cool.y" /* yacc.c:1646  */
+#line 381 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.param_expressions) = append_Expressions((yyvsp[-2].param_expressions), single_Expressions((yyvsp[0].expression))); 
+        (yyval.buffer) = (yyvsp[-2].buffer)->add((yyvsp[0].expression)); 
       }
-#line 1820 "cool.tab.c" /* yacc.c:1646  */
+#line 1907 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 28:
-#line 303 "cool.y" /* yacc.c:1646  */
+#line 385 "cool.y" /* yacc.c:1646  */
     {
-        (yyval.param_expressions) = single_Expressions((yyvsp[0].expression));
+        (yyval.buffer) = ListBuffer::start()->add((yyvsp[0].expression));
       }
-#line 1828 "cool.tab.c" /* yacc.c:1646  */
+#line 1915 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 29:
-#line 310 "cool.y" /* yacc.c:1646  */
+#line 392 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.plain_expressions) = append_Expressions((yyvsp[-2].plain_expressions), single_Expressions((yyvsp[-1].expression))); 
+          (yyval.buffer) = (yyvsp[-2].buffer)->add((yyvsp[-1].expression)); 
         }
-#line 1836 "cool.tab.c" /* yacc.c:1646  */
+#line 1923 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 30:
-#line 314 "cool.y" /* yacc.c:1646  */
+#line 396 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.plain_expressions) = single_Expressions((yyvsp[-1].expression));
+          (yyval.buffer) = ListBuffer::start()->add((yyvsp[-1].expression));
         }
-#line 1844 "cool.tab.c" /* yacc.c:1646  */
+#line 1931 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 31:
-#line 318 "cool.y" /* yacc.c:1646  */
+#line 400 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.plain_expressions) = (yyvsp[-2].plain_expressions);
+          (yyval.buffer) = (yyvsp[-2].buffer);
         }
-#line 1852 "cool.tab.c" /* yacc.c:1646  */
+#line 1939 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 32:
-#line 325 "cool.y" /* yacc.c:1646  */
+#line 407 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = assign((yyvsp[-2].symbol), (yyvsp[0].expression));
         }
-#line 1860 "cool.tab.c" /* yacc.c:1646  */
+#line 1947 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 33:
-#line 330 "cool.y" /* yacc.c:1646  */
+#line 412 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = dispatch((yyvsp[-5].expression), (yyvsp[-3].symbol), (yyvsp[-1].param_expressions));
+          (yyval.expression) = dispatch((yyvsp[-5].expression), (yyvsp[-3].symbol), (yyvsp[-1].buffer)->to_list<Expression>());
         }
-#line 1868 "cool.tab.c" /* yacc.c:1646  */
+#line 1955 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 34:
-#line 335 "cool.y" /* yacc.c:1646  */
+#line 417 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = dispatch((yyvsp[-4].expression), (yyvsp[-2].symbol), nil_Expressions());
         }
-#line 1876 "cool.tab.c" /* yacc.c:1646  */
+#line 1963 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 35:
-#line 340 "cool.y" /* yacc.c:1646  */
+#line 422 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = static_dispatch((yyvsp[-7].expression), (yyvsp[-5].symbol), (yyvsp[-3].symbol), (yyvsp[-1].param_expressions));
+          (yyval.expression) = static_dispatch((yyvsp[-7].expression), (yyvsp[-5].symbol), (yyvsp[-3].symbol), (yyvsp[-1].buffer)->to_list<Expression>());
         }
-#line 1884 "cool.tab.c" /* yacc.c:1646  */
+#line 1971 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 36:
-#line 345 "cool.y" /* yacc.c:1646  */
+#line 427 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = static_dispatch((yyvsp[-6].expression), (yyvsp[-4].symbol), (yyvsp[-2].symbol), nil_Expressions());
         }
-#line 1892 "cool.tab.c" /* yacc.c:1646  */
+#line 1979 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 37:
-#line 350 "cool.y" /* yacc.c:1646  */
+#line 432 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = dispatch(object(idtable.add_string("self")), (yyvsp[-3].symbol), (yyvsp[-1].param_expressions));
+          (yyval.expression) = dispatch(object(self_sym()), (yyvsp[-3].symbol), (yyvsp[-1].buffer)->to_list<Expression>());
         }
-#line 1900 "cool.tab.c" /* yacc.c:1646  */
+#line 1987 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 38:
-#line 355 "cool.y" /* yacc.c:1646  */
+#line 437 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = dispatch(object(idtable.add_string("self")), (yyvsp[-2].symbol), nil_Expressions());
+          (yyval.expression) = dispatch(object(self_sym()), (yyvsp[-2].symbol), nil_Expressions());
         }
-#line 1908 "cool.tab.c" /* yacc.c:1646  */
+#line 1995 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 39:
-#line 360 "cool.y" /* yacc.c:1646  */
+#line 442 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = cond((yyvsp[-5].expression), (yyvsp[-3].expression), (yyvsp[-1].expression));
         }
-#line 1916 "cool.tab.c" /* yacc.c:1646  */
+#line 2003 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 40:
-#line 365 "cool.y" /* yacc.c:1646  */
+#line 447 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = loop((yyvsp[-3].expression), (yyvsp[-1].expression));
         }
-#line 1924 "cool.tab.c" /* yacc.c:1646  */
+#line 2011 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 41:
-#line 370 "cool.y" /* yacc.c:1646  */
+#line 452 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = block((yyvsp[-1].plain_expressions));
+          (yyval.expression) = block((yyvsp[-1].buffer)->to_list<Expression>());
         }
-#line 1932 "cool.tab.c" /* yacc.c:1646  */
+#line 2019 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 42:
-#line 375 "cool.y" /* yacc.c:1646  */
+#line 457 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = (yyvsp[0].expression);
         }
-#line 1940 "cool.tab.c" /* yacc.c:1646  */
+#line 2027 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 43:
-#line 380 "cool.y" /* yacc.c:1646  */
+#line 462 "cool.y" /* yacc.c:1646  */
     {
-          (yyval.expression) = typcase((yyvsp[-3].expression), (yyvsp[-1].cases));
+          (yyval.expression) = typcase((yyvsp[-3].expression), (yyvsp[-1].buffer)->to_list<Case>());
         }
-#line 1948 "cool.tab.c" /* yacc.c:1646  */
+#line 2035 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 44:
-#line 385 "cool.y" /* yacc.c:1646  */
+#line 467 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = new_((yyvsp[0].symbol));
         }
-#line 1956 "cool.tab.c" /* yacc.c:1646  */
+#line 2043 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 45:
-#line 389 "cool.y" /* yacc.c:1646  */
+#line 471 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = isvoid((yyvsp[0].expression));
         }
-#line 1964 "cool.tab.c" /* yacc.c:1646  */
+#line 2051 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 46:
-#line 393 "cool.y" /* yacc.c:1646  */
+#line 475 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = plus((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 1972 "cool.tab.c" /* yacc.c:1646  */
+#line 2059 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 47:
-#line 397 "cool.y" /* yacc.c:1646  */
+#line 479 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = sub((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 1980 "cool.tab.c" /* yacc.c:1646  */
+#line 2067 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 48:
-#line 401 "cool.y" /* yacc.c:1646  */
+#line 483 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = mul((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 1988 "cool.tab.c" /* yacc.c:1646  */
+#line 2075 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 49:
-#line 405 "cool.y" /* yacc.c:1646  */
+#line 487 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = divide((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 1996 "cool.tab.c" /* yacc.c:1646  */
+#line 2083 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 50:
-#line 409 "cool.y" /* yacc.c:1646  */
+#line 491 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = neg((yyvsp[0].expression));
         }
-#line 2004 "cool.tab.c" /* yacc.c:1646  */
+#line 2091 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 51:
-#line 413 "cool.y" /* yacc.c:1646  */
+#line 495 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = lt((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 2012 "cool.tab.c" /* yacc.c:1646  */
+#line 2099 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 52:
-#line 417 "cool.y" /* yacc.c:1646  */
+#line 499 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = leq((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 2020 "cool.tab.c" /* yacc.c:1646  */
+#line 2107 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 53:
-#line 421 "cool.y" /* yacc.c:1646  */
+#line 503 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = eq((yyvsp[-2].expression), (yyvsp[0].expression));
         }
-#line 2028 "cool.tab.c" /* yacc.c:1646  */
+#line 2115 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 54:
-#line 425 "cool.y" /* yacc.c:1646  */
+#line 507 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = comp((yyvsp[0].expression));
         }
-#line 2036 "cool.tab.c" /* yacc.c:1646  */
+#line 2123 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 55:
-#line 429 "cool.y" /* yacc.c:1646  */
+#line 511 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = (yyvsp[-1].expression);
         }
-#line 2044 "cool.tab.c" /* yacc.c:1646  */
+#line 2131 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 56:
-#line 433 "cool.y" /* yacc.c:1646  */
+#line 515 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = object((yyvsp[0].symbol));
         }
-#line 2052 "cool.tab.c" /* yacc.c:1646  */
+#line 2139 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 57:
-#line 437 "cool.y" /* yacc.c:1646  */
+#line 519 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = int_const((yyvsp[0].symbol));
         }
-#line 2060 "cool.tab.c" /* yacc.c:1646  */
+#line 2147 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 58:
-#line 441 "cool.y" /* yacc.c:1646  */
+#line 523 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = bool_const((yyvsp[0].boolean));
         }
-#line 2068 "cool.tab.c" /* yacc.c:1646  */
+#line 2155 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 59:
-#line 445 "cool.y" /* yacc.c:1646  */
+#line 527 "cool.y" /* yacc.c:1646  */
     {
           (yyval.expression) = string_const((yyvsp[0].symbol));
         }
-#line 2076 "cool.tab.c" /* yacc.c:1646  */
+#line 2163 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 60:
-#line 452 "cool.y" /* yacc.c:1646  */
+#line 534 "cool.y" /* yacc.c:1646  */
     {
             (yyval.expression) = let((yyvsp[-4].symbol),(yyvsp[-2].symbol),no_expr(),(yyvsp[0].expression));
           }
-#line 2084 "cool.tab.c" /* yacc.c:1646  */
+#line 2171 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 61:
-#line 456 "cool.y" /* yacc.c:1646  */
+#line 538 "cool.y" /* yacc.c:1646  */
     {
             (yyval.expression) = let((yyvsp[-6].symbol),(yyvsp[-4].symbol),(yyvsp[-2].expression),(yyvsp[0].expression));
           }
-#line 2092 "cool.tab.c" /* yacc.c:1646  */
+#line 2179 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 62:
-#line 460 "cool.y" /* yacc.c:1646  */
+#line 542 "cool.y" /* yacc.c:1646  */
     {
             (yyval.expression) = let((yyvsp[-4].symbol),(yyvsp[-2].symbol),no_expr(),(yyvsp[0].expression));
           }
-#line 2100 "cool.tab.c" /* yacc.c:1646  */
+#line 2187 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 63:
-#line 464 "cool.y" /* yacc.c:1646  */
+#line 546 "cool.y" /* yacc.c:1646  */
     {
             (yyval.expression) = let((yyvsp[-6].symbol),(yyvsp[-4].symbol),(yyvsp[-2].expression),(yyvsp[0].expression));
           }
-#line 2108 "cool.tab.c" /* yacc.c:1646  */
+#line 2195 "cool.tab.c" /* yacc.c:1646  */
     break;
 
   case 64:
-#line 468 "cool.y" /* yacc.c:1646  */
+#line 550 "cool.y" /* yacc.c:1646  */
     {
             (yyval.expression) =  (yyvsp[0].expression);
           }
-#line 2116 "cool.tab.c" /* yacc.c:1646  */
+#line 2203 "cool.tab.c" /* yacc.c:1646  */
     break;
 
 
-#line 2120 "cool.tab.c" /* yacc.c:1646  */
+#line 2207 "cool.tab.c" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -2351,7 +2438,7 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 474 "cool.y" /* yacc.c:1906  */
+#line 556 "cool.y" /* yacc.c:1906  */
 
     
     /* This function is called automatically when Bison detects a parse error. */
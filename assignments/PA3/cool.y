@@ -14,6 +14,7 @@
   
   /* Locations */
   #define YYLTYPE int              /* the type of locations */
+  #define YYINITDEPTH 10000        /* bison never grows the stacks in C++ */
   #define cool_yylloc curr_lineno  /* use the curr_lineno from the lexer
   for the location of tokens */
     
@@ -83,6 +84,80 @@
     Program ast_root;	      /* the result of the parse  */
     Classes parse_results;        /* for use in semantic analysis */
     int omerrs = 0;               /* number of errors in lexing and parsing */
+    
+    
+    /* Lists under construction.  The value of a list nonterminal is a
+    ListBuffer that its rules add elements to, and the rule that uses
+    the whole list turns it into one array_node with to_list.  Buffers
+    go back on a free list once they have been turned into lists, so
+    the space they have grown stays in use for the next list. */
+    class ListBuffer {
+    private:
+      tree_node **elems;
+      int length;
+      int capacity;
+      ListBuffer *next_free;
+      static ListBuffer *free_list;
+      
+      void grow() {
+        capacity = capacity ? 2 * capacity : 8;
+        elems = (tree_node **) realloc(elems, capacity * sizeof(tree_node *));
+      }
+    public:
+      /* an empty buffer */
+      static ListBuffer *start() {
+        ListBuffer *b = free_list;
+        if (b != NULL)
+          free_list = b->next_free;
+        else {
+          b = new ListBuffer;
+          b->elems = NULL;
+          b->capacity = 0;
+        }
+        b->length = 0;
+        return b;
+      }
+      
+      ListBuffer *add(tree_node *e) {
+        if (length == capacity)
+          grow();
+        elems[length++] = e;
+        return this;
+      }
+      
+      /* the elements as a list; the buffer is free again afterwards */
+      template <class Elem> list_node<Elem> *to_list() {
+        Elem *out = (Elem *) node_arena.alloc((length ? length : 1) * sizeof(Elem));
+        for (int i = 0; i < length; i++)
+          out[i] = static_cast<Elem>(elems[i]);
+        list_node<Elem> *l = list_node<Elem>::array(out, length);
+        next_free = free_list;
+        free_list = this;
+        return l;
+      }
+    };
+    ListBuffer *ListBuffer::free_list = NULL;
+    
+    /* Symbols the actions supply themselves, entered once. */
+    static Symbol self_sym() {
+      static Symbol sym = idtable.add_string("self");
+      return sym;
+    }
+    static Symbol object_sym() {
+      static Symbol sym = idtable.add_string("Object");
+      return sym;
+    }
+    
+    /* the file name of every class, entered once per file */
+    static Symbol filename_sym() {
+      static char *name = NULL;
+      static Symbol sym;
+      if (name != curr_filename) {
+        name = curr_filename;
+        sym = stringtable.add_string(curr_filename);
+      }
+      return sym;
+    }
     %}
     
     /* A union of all the types that can be the result of parsing actions. */
@@ -101,6 +176,7 @@
       Expression expression;
       Expressions plain_expressions;
       Expressions param_expressions;
+      ListBuffer *buffer;
       char *error_msg;
     }
     
@@ -132,22 +208,21 @@
     
     /* Declare types for the grammar's non-terminals. */
     %type <program> program
-    %type <classes> classes
+    %type <buffer> classes
     %type <class_> class
 
     
     /* You will want to change the following line. */
     %type <features> dummy_features
-    %type <features> features
+    %type <buffer> features
     %type <feature> feature
     %type <formals> dummy_formals
-    %type <formals> formals
+    %type <buffer> formals
     %type <formal> formal
-    %type <plain_expressions> plain_expressions 
-    %type <param_expressions> param_expressions
+    %type <buffer> plain_expressions param_expressions
     %type <expression> expression let_expr
     %type <case_> case_
-    %type <cases> cases 
+    %type <buffer> cases
   
     /* Precedence declarations go here. */
     %right ASSIGN
@@ -165,46 +240,51 @@
     Save the root of the abstract syntax tree in a global variable.
     */
     program	
-      : classes	{ @$ = @1; ast_root = program($1); }
+      : classes	
+        { 
+          @$ = @1; 
+          parse_results = $1->to_list<Class_>();
+          ast_root = program(parse_results); 
+        }
       ;
     
     classes
       : class	';'		/* single class */
         { 
-          $$ = single_Classes($1);
-          parse_results = $$; 
+          $$ = ListBuffer::start()->add($1);
         }
       | classes class	';'/* several classes */
         { 
-          $$ = append_Classes($1,single_Classes($class)); 
-          parse_results = $$; 
+          $$ = $1->add($class); 
         }
       | classes error ';'
         {
           $$ = $1;
         }
       | error ';'
+        {
+          $$ = ListBuffer::start();
+        }
       ;
     
     /* If no parent is specified, the class inherits from the Object class. */
     class	/* single dummy class */
       : CLASS TYPEID '{' dummy_features '}' 
         { 
-          $$ = class_($2,idtable.add_string("Object"),$dummy_features,
-                      stringtable.add_string(curr_filename)); 
+          $$ = class_($2,object_sym(),$dummy_features,filename_sym()); 
         } /* single class */
       | CLASS TYPEID[name] '{' features '}' 
         { 
-          $$ = class_($name,idtable.add_string("Object"),$features,
-                      stringtable.add_string(curr_filename));
+          $$ = class_($name,object_sym(),$features->to_list<Feature>(),
+                      filename_sym());
         } /* inherited dummy class */
       | CLASS TYPEID[name] INHERITS TYPEID[parent] '{' dummy_features '}'  
         { 
-          $$ = class_($name,$parent,$dummy_features,stringtable.add_string(curr_filename)); 
+          $$ = class_($name,$parent,$dummy_features,filename_sym()); 
         } /* inherited class */
       | CLASS TYPEID[name] INHERITS TYPEID[parent] '{' features '}' 
         { 
-          $$ = class_($name,$parent,$features,stringtable.add_string(curr_filename)); 
+          $$ = class_($name,$parent,$features->to_list<Feature>(),filename_sym()); 
         }
       ;
     
@@ -218,24 +298,26 @@
     features /* single feature */
       : feature ';'
         { 
-          $$ = single_Features($feature); 
+          $$ = ListBuffer::start()->add($feature); 
         }
       | features feature ';' /* several features */
         { 
-          $$ = append_Features($1, single_Features($feature)); 
+          $$ = $1->add($feature); 
         }
       | features error ';'
         {
           $$ = $1;
         }
       | error ';'
-        {}
+        {
+          $$ = ListBuffer::start();
+        }
     ;
     
     feature /* method with formal params */
       : OBJECTID[name] '(' formals ')' ':' TYPEID[ret_type] '{' expression '}'
         {
-          $$ = method($name, $formals, $ret_type, $expression);  
+          $$ = method($name, $formals->to_list<Formal>(), $ret_type, $expression);  
         } /* method without formal params */
       | OBJECTID[name] '(' dummy_formals[formals] ')' ':' 
           TYPEID[ret_type] '{' expression '}'
@@ -262,11 +344,11 @@
     formals /* single formal */
       : formals ',' formal
       {
-        $$ = append_Formals($1, single_Formals($formal));
+        $$ = $1->add($formal);
       }
       | formal
       {
-        $$ = single_Formals($formal);
+        $$ = ListBuffer::start()->add($formal);
       }
     ;
     
@@ -279,11 +361,11 @@
     cases
       : cases case_
       {
-        $$ = append_Cases($1, single_Cases($case_));
+        $$ = $1->add($case_);
       }
       | case_
       {
-        $$ = single_Cases($case_);
+        $$ = ListBuffer::start()->add($case_);
       }
     ;
 
@@ -297,22 +379,22 @@
     param_expressions
       : param_expressions ',' expression
       {
-        $$ = append_Expressions($1, single_Expressions($expression)); 
+        $$ = $1->add($expression); 
       }
       | expression
       {
-        $$ = single_Expressions($expression);
+        $$ = ListBuffer::start()->add($expression);
       }
     ;
 
     plain_expressions
       : plain_expressions expression ';'
         {
-          $$ = append_Expressions($1, single_Expressions($expression)); 
+          $$ = $1->add($expression); 
         }
       | expression ';'
         {
-          $$ = single_Expressions($expression);
+          $$ = ListBuffer::start()->add($expression);
         }
       | plain_expressions error ';'
         {
@@ -328,7 +410,7 @@
       /* dispatch expression */
       | expression '.' OBJECTID[name] '(' param_expressions[actual] ')'
         {
-          $$ = dispatch($1, $name, $actual);
+          $$ = dispatch($1, $name, $actual->to_list<Expression>());
         }
       /* dispatch expression with no params */
       | expression '.' OBJECTID[name] '(' ')'
@@ -338,7 +420,7 @@
       /* static dispatch */
       | expression '@' TYPEID[type_name] '.' OBJECTID[name] '(' param_expressions[actual] ')' 
         {
-          $$ = static_dispatch($1, $type_name, $name, $actual);
+          $$ = static_dispatch($1, $type_name, $name, $actual->to_list<Expression>());
         } 
       /* static dispatch with no params */
       | expression '@' TYPEID[type_name] '.' OBJECTID[name] '(' ')' 
@@ -348,12 +430,12 @@
       /* self dispatch */
       | OBJECTID[name] '(' param_expressions[actual] ')'
         {
-          $$ = dispatch(object(idtable.add_string("self")), $name, $actual);
+          $$ = dispatch(object(self_sym()), $name, $actual->to_list<Expression>());
         }
       /* self dispatch */
       | OBJECTID[name] '(' ')'
         {
-          $$ = dispatch(object(idtable.add_string("self")), $name, nil_Expressions());
+          $$ = dispatch(object(self_sym()), $name, nil_Expressions());
         }
       /* cond expression */
       | IF expression[pred] THEN expression[then_expr] ELSE expression[else_expr] FI
@@ -368,7 +450,7 @@
       /* block expression */
       | '{' plain_expressions '}'
         {
-          $$ = block($plain_expressions);
+          $$ = block($plain_expressions->to_list<Expression>());
         }
       /* let expression */
       | LET let_expr
@@ -378,7 +460,7 @@
       /* case expression */
       | CASE expression OF cases ESAC
         {
-          $$ = typcase($2, $cases);
+          $$ = typcase($2, $cases->to_list<Case>());
         }
       /* new expression */
       | NEW TYPEID[name]
@@ -10,43 +10,6 @@
 
 #include "tree.h"
 #include "cool-tree.handcode.h"
-#include "symtab.h"
-
-typedef SymbolTable <Symbol, Entry> AttrInfoTable;
-typedef SymbolTable <Symbol, Feature_class> MethodInfoTable;
-typedef SymbolTable <Symbol, Class__class> ClassInfoTable;
-
-class ClassTable {
-private:
-    int semant_errors;
-
-    void install_basic_classes();
-
-    ostream &error_stream;
-
-public:
-    ClassTable(Classes);
-
-    ClassInfoTable class_dec_table;
-
-    int errors() { return semant_errors; }
-
-    ostream &semant_error();
-
-    ostream &semant_error(Class_ c);
-
-    ostream &semant_error(Symbol filename, tree_node *t);
-
-    void checkClass(Class_);
-
-    void registerFeatures(Class_);
-
-    bool checkAscent(Symbol, Symbol);
-
-    bool hasClass(Symbol);
-
-    Symbol unionType(Symbol, Symbol);
-};
 
 // define the class for phylum
 // define simple phylum - Program
@@ -71,34 +34,10 @@ typedef class Class__class *Class_;
 
 class Class__class : public tree_node {
 public:
-    Class__class() {
-        is_visited = false;
-        is_valid = true;
-        is_registered = false;
-    }
-
-    bool is_visited;
-
-    bool is_valid;
-
-    bool is_registered;
-
     tree_node *copy() { return copy_Class_(); }
 
-    AttrInfoTable attr_env;
-    MethodInfoTable method_env;
-    ClassInfoTable class_inh;
-
     virtual Class_ copy_Class_() = 0;
 
-    virtual Symbol getName() = 0;
-
-    virtual Features getFeatures() = 0;
-
-    virtual Symbol getParent() = 0;
-
-    virtual void setInheritance(ClassTable *, ClassInfoTable) = 0;
-
 #ifdef Class__EXTRAS
 
     Class__EXTRAS
@@ -116,12 +55,6 @@ public:
 
     virtual Feature copy_Feature() = 0;
 
-    virtual char *getFeatureType() = 0;
-
-    virtual Symbol getName() = 0;
-
-    virtual void check(ClassTable *, Class_) = 0;
-
 #ifdef Feature_EXTRAS
 
     Feature_EXTRAS
@@ -139,10 +72,6 @@ public:
 
     virtual Formal copy_Formal() = 0;
 
-    virtual Symbol getName() = 0;
-
-    virtual Symbol getTypeDecl() = 0;
-
 #ifdef Formal_EXTRAS
 
     Formal_EXTRAS
@@ -160,8 +89,6 @@ public:
 
     virtual Expression copy_Expression() = 0;
 
-    virtual void check(ClassTable *, AttrInfoTable &, Class_) = 0;
-
 #ifdef Expression_EXTRAS
     Expression_EXTRAS
 
@@ -174,20 +101,10 @@ typedef class Case_class *Case;
 
 class Case_class : public tree_node {
 public:
-    Symbol type;
-
     tree_node *copy() { return copy_Case(); }
 
     virtual Case copy_Case() = 0;
 
-    virtual void check(ClassTable *, AttrInfoTable &, Class_) = 0;
-
-    virtual Symbol getName() = 0;
-
-    virtual Symbol getTypeDecl() = 0;
-
-    virtual Expression getExpr() = 0;
-
 #ifdef Case_EXTRAS
 
     Case_EXTRAS
@@ -229,6 +146,7 @@ protected:
     Classes classes;
 public:
     program_class(Classes a1) {
+        kind = AST_program;
         classes = a1;
     }
 
@@ -256,6 +174,7 @@ protected:
     Symbol filename;
 public:
     class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+        kind = AST_class_;
         name = a1;
         parent = a2;
         features = a3;
@@ -266,14 +185,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    Symbol getName() { return name; }
-
-    Symbol getParent() { return parent; }
-
-    Features getFeatures() { return features; }
-
-    void setInheritance(ClassTable *, ClassInfoTable);
-
 #ifdef Class__SHARED_EXTRAS
     Class__SHARED_EXTRAS
 #endif
@@ -294,6 +205,7 @@ protected:
     Expression expr;
 public:
     method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+        kind = AST_method;
         name = a1;
         formals = a2;
         return_type = a3;
@@ -304,18 +216,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    Symbol getRetType() { return return_type; }
-
-    char *getFeatureType() { return "METHOD"; }
-
-    Symbol getName() { return name; }
-
-    Formals getFormals() { return formals; }
-
-    void check(ClassTable *, Class_);
-
-    Symbol matchParam(Expressions, ClassTable *, AttrInfoTable&, Class_);
-
 #ifdef Feature_SHARED_EXTRAS
 
     Feature_SHARED_EXTRAS
@@ -334,9 +234,8 @@ protected:
     Symbol type_decl;
     Expression init;
 public:
-    Symbol type;
-
     attr_class(Symbol a1, Symbol a2, Expression a3) {
+        kind = AST_attr;
         name = a1;
         type_decl = a2;
         init = a3;
@@ -346,16 +245,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    Symbol getName() { return name; }
-
-    Symbol getTypeDecl() { return type_decl; }
-
-    Expression getInit() { return init; }
-
-    char *getFeatureType() { return "ATTR"; }
-
-    void check(ClassTable *, Class_);
-
 #ifdef Feature_SHARED_EXTRAS
 
     Feature_SHARED_EXTRAS
@@ -374,6 +263,7 @@ protected:
     Symbol type_decl;
 public:
     formal_class(Symbol a1, Symbol a2) {
+        kind = AST_formal;
         name = a1;
         type_decl = a2;
     }
@@ -382,10 +272,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    Symbol getTypeDecl() { return type_decl; }
-
-    Symbol getName() { return name; }
-
 #ifdef Formal_SHARED_EXTRAS
     Formal_SHARED_EXTRAS
 #endif
@@ -405,6 +291,7 @@ protected:
     Expression expr;
 public:
     branch_class(Symbol a1, Symbol a2, Expression a3) {
+        kind = AST_branch;
         name = a1;
         type_decl = a2;
         expr = a3;
@@ -414,16 +301,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    Symbol getExprType() { return this->expr->type; }
-
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
-    Symbol getName() { return name; }
-
-    Symbol getTypeDecl() { return type_decl; }
-
-    Expression getExpr() { return expr; }
-
 #ifdef Case_SHARED_EXTRAS
     Case_SHARED_EXTRAS
 #endif
@@ -442,6 +319,7 @@ protected:
     Expression expr;
 public:
     assign_class(Symbol a1, Expression a2) {
+        kind = AST_assign;
         name = a1;
         expr = a2;
     }
@@ -450,8 +328,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -472,6 +348,7 @@ protected:
     Expressions actual;
 public:
     static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+        kind = AST_static_dispatch;
         expr = a1;
         type_name = a2;
         name = a3;
@@ -482,8 +359,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -503,6 +378,7 @@ protected:
     Expressions actual;
 public:
     dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+        kind = AST_dispatch;
         expr = a1;
         name = a2;
         actual = a3;
@@ -512,8 +388,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -533,6 +407,7 @@ protected:
     Expression else_exp;
 public:
     cond_class(Expression a1, Expression a2, Expression a3) {
+        kind = AST_cond;
         pred = a1;
         then_exp = a2;
         else_exp = a3;
@@ -542,8 +417,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -562,6 +435,7 @@ protected:
     Expression body;
 public:
     loop_class(Expression a1, Expression a2) {
+        kind = AST_loop;
         pred = a1;
         body = a2;
     }
@@ -570,8 +444,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -590,6 +462,7 @@ protected:
     Cases cases;
 public:
     typcase_class(Expression a1, Cases a2) {
+        kind = AST_typcase;
         expr = a1;
         cases = a2;
     }
@@ -598,8 +471,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -617,6 +488,7 @@ protected:
     Expressions body;
 public:
     block_class(Expressions a1) {
+        kind = AST_block;
         body = a1;
     }
 
@@ -624,8 +496,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -646,6 +516,7 @@ protected:
     Expression body;
 public:
     let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+        kind = AST_let;
         identifier = a1;
         type_decl = a2;
         init = a3;
@@ -656,8 +527,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -676,6 +545,7 @@ protected:
     Expression e2;
 public:
     plus_class(Expression a1, Expression a2) {
+        kind = AST_plus;
         e1 = a1;
         e2 = a2;
     }
@@ -684,8 +554,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -704,6 +572,7 @@ protected:
     Expression e2;
 public:
     sub_class(Expression a1, Expression a2) {
+        kind = AST_sub;
         e1 = a1;
         e2 = a2;
     }
@@ -712,8 +581,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -732,6 +599,7 @@ protected:
     Expression e2;
 public:
     mul_class(Expression a1, Expression a2) {
+        kind = AST_mul;
         e1 = a1;
         e2 = a2;
     }
@@ -740,8 +608,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -760,6 +626,7 @@ protected:
     Expression e2;
 public:
     divide_class(Expression a1, Expression a2) {
+        kind = AST_divide;
         e1 = a1;
         e2 = a2;
     }
@@ -768,8 +635,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -787,6 +652,7 @@ protected:
     Expression e1;
 public:
     neg_class(Expression a1) {
+        kind = AST_neg;
         e1 = a1;
     }
 
@@ -794,8 +660,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -814,6 +678,7 @@ protected:
     Expression e2;
 public:
     lt_class(Expression a1, Expression a2) {
+        kind = AST_lt;
         e1 = a1;
         e2 = a2;
     }
@@ -822,8 +687,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -842,6 +705,7 @@ protected:
     Expression e2;
 public:
     eq_class(Expression a1, Expression a2) {
+        kind = AST_eq;
         e1 = a1;
         e2 = a2;
     }
@@ -850,8 +714,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -870,6 +732,7 @@ protected:
     Expression e2;
 public:
     leq_class(Expression a1, Expression a2) {
+        kind = AST_leq;
         e1 = a1;
         e2 = a2;
     }
@@ -878,8 +741,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -897,6 +758,7 @@ protected:
     Expression e1;
 public:
     comp_class(Expression a1) {
+        kind = AST_comp;
         e1 = a1;
     }
 
@@ -904,8 +766,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -923,6 +783,7 @@ protected:
     Symbol token;
 public:
     int_const_class(Symbol a1) {
+        kind = AST_int_const;
         token = a1;
     }
 
@@ -930,8 +791,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -949,6 +808,7 @@ protected:
     Boolean val;
 public:
     bool_const_class(Boolean a1) {
+        kind = AST_bool_const;
         val = a1;
     }
 
@@ -956,8 +816,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -975,6 +833,7 @@ protected:
     Symbol token;
 public:
     string_const_class(Symbol a1) {
+        kind = AST_string_const;
         token = a1;
     }
 
@@ -982,8 +841,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -1001,6 +858,7 @@ protected:
     Symbol type_name;
 public:
     new__class(Symbol a1) {
+        kind = AST_new_;
         type_name = a1;
     }
 
@@ -1008,8 +866,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -1027,6 +883,7 @@ protected:
     Expression e1;
 public:
     isvoid_class(Expression a1) {
+        kind = AST_isvoid;
         e1 = a1;
     }
 
@@ -1034,8 +891,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -1053,14 +908,13 @@ protected:
 public:
 
     no_expr_class() {
+        kind = AST_no_expr;
     }
 
     Expression copy_Expression();
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -1078,6 +932,7 @@ protected:
     Symbol name;
 public:
     object_class(Symbol a1) {
+        kind = AST_object;
         name = a1;
     }
 
@@ -1085,8 +940,6 @@ public:
 
     void dump(ostream &stream, int n);
 
-    void check(ClassTable *, AttrInfoTable &, Class_);
-
 #ifdef Expression_SHARED_EXTRAS
 
     Expression_SHARED_EXTRAS
@@ -20,6 +20,8 @@ void dump_Symbol(ostream& stream, int padding, Symbol b);
 void assert_Symbol(Symbol b);
 Symbol copy_Symbol(Symbol b);
 
+class AstWriter;
+
 class Program_class;
 typedef Program_class *Program;
 class Class__class;
@@ -44,62 +46,90 @@ typedef Expressions_class *Expressions;
 typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
+#include "semant-tree.h"
+
 #define Program_EXTRAS                          \
+Program_SEMANT_EXTRAS                           \
 virtual void semant() = 0;			\
-virtual void dump_with_types(ostream&, int) = 0; 
+virtual void dump_with_types(ostream&, int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 
 #define program_EXTRAS                          \
+program_SEMANT_EXTRAS                           \
 void semant();     				\
-void dump_with_types(ostream&, int);            
+void dump_with_types(ostream&, int);            \
+void dump_binary(AstWriter&);
 
 #define Class__EXTRAS                   \
+Class__SEMANT_EXTRAS                    \
 virtual Symbol get_filename() = 0;      \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define class__EXTRAS                                 \
+class__SEMANT_EXTRAS                                  \
 Symbol get_filename() { return filename; }             \
-void dump_with_types(ostream&,int);                    
+void dump_with_types(ostream&,int);                   \
+void dump_binary(AstWriter&);
 
 
 #define Feature_EXTRAS                                        \
-virtual void dump_with_types(ostream&,int) = 0; 
+Feature_SEMANT_EXTRAS                                         \
+virtual void dump_with_types(ostream&,int) = 0;               \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define Feature_SHARED_EXTRAS                                       \
-void dump_with_types(ostream&,int);    
+void dump_with_types(ostream&,int);                                 \
+void dump_binary(AstWriter&);
+
+#define method_EXTRAS method_SEMANT_EXTRAS
+#define attr_EXTRAS attr_SEMANT_EXTRAS
 
 
 
 
 
 #define Formal_EXTRAS                              \
-virtual void dump_with_types(ostream&,int) = 0;
+Formal_SEMANT_EXTRAS                               \
+virtual void dump_with_types(ostream&,int) = 0;    \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define formal_EXTRAS                           \
-void dump_with_types(ostream&,int);
+formal_SEMANT_EXTRAS                            \
+void dump_with_types(ostream&,int);             \
+void dump_binary(AstWriter&);
 
 
 #define Case_EXTRAS                             \
-virtual void dump_with_types(ostream& ,int) = 0;
+Case_SEMANT_EXTRAS                              \
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define branch_EXTRAS                                   \
-void dump_with_types(ostream& ,int);
+branch_SEMANT_EXTRAS                                    \
+void dump_with_types(ostream& ,int);                    \
+void dump_binary(AstWriter&);
 
 
 #define Expression_EXTRAS                    \
+Expression_SEMANT_EXTRAS                     \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
-virtual void dump_with_types(ostream&,int) = 0;  \
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;    \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 #define Expression_SHARED_EXTRAS           \
-void dump_with_types(ostream&,int); 
+Expression_SHARED_SEMANT_EXTRAS            \
+void dump_with_types(ostream&,int);        \
+void dump_binary(AstWriter&);
 
 #endif
@@ -0,0 +1,214 @@
+#ifndef SEMANT_TREE_H
+#define SEMANT_TREE_H
+//////////////////////////////////////////////////////////
+//
+// file: semant-tree.h
+//
+// The class table of the semantic analyzer, and the members it adds to
+// the AST classes.  cool-tree.handcode.h includes this file after its
+// phylum typedefs and puts each X_SEMANT_EXTRAS into the X_EXTRAS that
+// cool-tree.h expands in the class X, here in PA4 as in coolc, which
+// builds on the AST of PA5.
+//
+//////////////////////////////////////////////////////////
+
+#include "symtab.h"
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <string>
+
+typedef SymbolTable <Symbol, Entry> AttrInfoTable;
+typedef SymbolTable <Symbol, Feature_class> MethodInfoTable;
+typedef SymbolTable <Symbol, Class__class> ClassInfoTable;
+typedef std::unordered_map<Symbol, Feature_class *> MethodTable;
+typedef std::unordered_map<Symbol, Symbol> AttrTable;
+
+// How a class depends on another (bits of the class dependency graph)
+enum DepKind {
+    DEP_INHERITS = 1,   // the other class is its parent
+    DEP_ATTR = 2,       // an attribute has the other class as its type
+    DEP_METHOD = 4,     // a method's formals or result have the other class
+    DEP_DISPATCH = 8,   // it calls methods of the other class
+    DEP_USES = 16       // a check looked at the other class otherwise
+};
+
+struct ClassErrors;
+
+class ClassTable {
+private:
+    int semant_errors;
+    bool errors_left_out;   // errors were found but not printed
+
+    void install_basic_classes();
+
+    ostream &error_stream;
+
+    // The inheritance tree below Object, numbered in preorder once every
+    // class has its parent: the descendants of class id are the classes
+    // id..class_last[id], and class_up[k * n + id] is its 2^k-th ancestor
+    // (Object is its own parent), n being the number of classes in it.
+    std::vector<Class_> class_by_id;
+    std::vector<int> class_last;
+    std::vector<int> class_depth;
+    std::vector<int> class_up;
+    int class_levels;
+
+    void indexHierarchy(Classes);
+
+    void checkClasses(Classes);
+
+    // for incremental checking (-i): memoized class signatures, and the
+    // checked classes taken from the cache instead of being checked
+    std::unordered_map<Symbol, unsigned long long> class_signatures;
+    std::map<Class_, const std::string *> cached_classes;
+
+    unsigned long long signature(Symbol);
+
+    // for -d: the classes each class depends on, with DepKind bits
+    std::map<Symbol, std::map<Symbol, int> > class_graph;
+
+    void writeDependencies(const char *, Classes);
+
+    int classId(Symbol);
+
+    void printErrors(ClassErrors &, Class_);
+
+public:
+    ClassTable(Classes);
+
+    ClassInfoTable class_dec_table;
+
+    int errors() { return semant_errors; }
+
+    ostream &semant_error();
+
+    ostream &semant_error(Class_ c);
+
+    ostream &semant_error(Symbol filename, tree_node *t);
+
+    void checkClass(Class_);
+
+    void registerFeatures(Class_);
+
+    bool checkAscent(Symbol, Symbol);
+
+    bool hasClass(Symbol);
+
+    Class_ findClass(Symbol, int kind = DEP_USES);
+
+    void addDependency(Class_, Symbol, int);
+
+    Classes checkedClasses(Classes);
+
+    Symbol unionType(Symbol, Symbol);
+};
+
+#define Program_SEMANT_EXTRAS                   \
+virtual Classes getClasses() = 0;
+
+#define program_SEMANT_EXTRAS                   \
+Classes getClasses() { return classes; }
+
+// class_id is the preorder number in the inheritance tree, or -1.
+//
+// method_table and attr_table hold every method and attribute of a
+// class, inherited or its own, built by registerFeatures after the
+// parent's: method name => method, attribute name => declared type.
+// A class shares its parent's table until it defines a method (or an
+// attribute) of its own, and then gets a copy with its own added, so a
+// class that adds nothing costs no memory and a lookup (findMethod,
+// findAttr) is one hash probe.  They are NULL until the class is
+// registered.
+//
+// flattenLists, here and in each feature, case and expression, reads
+// every list below the node so that it is flat; see checkClasses.
+#define Class__SEMANT_EXTRAS                                            \
+bool is_visited = false;                                                \
+bool is_valid = true;                                                   \
+bool is_registered = false;                                             \
+int class_id = -1;                                                      \
+AttrInfoTable attr_env;                                                 \
+MethodInfoTable method_env;                                             \
+ClassInfoTable class_inh;                                               \
+MethodTable *method_table = NULL;                                       \
+AttrTable *attr_table = NULL;                                           \
+Feature_class *findMethod(Symbol name) {                                \
+    if (method_table == NULL)                                           \
+        return NULL;                                                    \
+    MethodTable::iterator it = method_table->find(name);                \
+    return it == method_table->end() ? NULL : it->second;               \
+}                                                                       \
+Symbol findAttr(Symbol name) {                                          \
+    if (attr_table == NULL)                                             \
+        return NULL;                                                    \
+    AttrTable::iterator it = attr_table->find(name);                    \
+    return it == attr_table->end() ? NULL : it->second;                 \
+}                                                                       \
+virtual Symbol getName() = 0;                                           \
+virtual Features getFeatures() = 0;                                     \
+virtual Symbol getParent() = 0;                                         \
+virtual void setInheritance(ClassTable *, ClassInfoTable &) = 0;        \
+virtual void flattenLists() = 0;
+
+#define class__SEMANT_EXTRAS                            \
+Symbol getName() { return name; }                       \
+Symbol getParent() { return parent; }                   \
+Features getFeatures() { return features; }             \
+void setInheritance(ClassTable *, ClassInfoTable &);    \
+void flattenLists();
+
+#define Feature_SEMANT_EXTRAS                                   \
+virtual Symbol getName() = 0;                                   \
+virtual void check(ClassTable *, AttrInfoTable &, Class_) = 0;  \
+virtual void flattenLists() = 0;
+
+#define method_SEMANT_EXTRAS                                    \
+Symbol getRetType() { return return_type; }                     \
+Symbol getName() { return name; }                               \
+Formals getFormals() { return formals; }                        \
+void check(ClassTable *, AttrInfoTable &, Class_);              \
+void flattenLists();                                            \
+Symbol matchParam(Expressions, ClassTable *, AttrInfoTable&, Class_);
+
+#define attr_SEMANT_EXTRAS                                      \
+Symbol type;                                                    \
+Symbol getName() { return name; }                               \
+Symbol getTypeDecl() { return type_decl; }                      \
+Expression getInit() { return init; }                           \
+void check(ClassTable *, AttrInfoTable &, Class_);              \
+void flattenLists();
+
+#define Formal_SEMANT_EXTRAS                    \
+virtual Symbol getName() = 0;                   \
+virtual Symbol getTypeDecl() = 0;
+
+#define formal_SEMANT_EXTRAS                    \
+Symbol getTypeDecl() { return type_decl; }      \
+Symbol getName() { return name; }
+
+#define Case_SEMANT_EXTRAS                                      \
+Symbol type;                                                    \
+virtual void check(ClassTable *, AttrInfoTable &, Class_) = 0;  \
+virtual void flattenLists() = 0;                                \
+virtual Symbol getName() = 0;                                   \
+virtual Symbol getTypeDecl() = 0;                               \
+virtual Expression getExpr() = 0;
+
+#define branch_SEMANT_EXTRAS                                    \
+Symbol getExprType() { return this->expr->type; }               \
+void check(ClassTable *, AttrInfoTable &, Class_);              \
+void flattenLists();                                            \
+Symbol getName() { return name; }                               \
+Symbol getTypeDecl() { return type_decl; }                      \
+Expression getExpr() { return expr; }
+
+#define Expression_SEMANT_EXTRAS                                \
+virtual void check(ClassTable *, AttrInfoTable &, Class_) = 0;  \
+virtual void flattenLists() = 0;
+
+#define Expression_SHARED_SEMANT_EXTRAS                         \
+void check(ClassTable *, AttrInfoTable &, Class_);              \
+void flattenLists();
+
+#endif
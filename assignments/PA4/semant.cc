@@ -6,9 +6,21 @@
 #include <symtab.h>
 #include "semant.h"
 #include "utilities.h"
+#include "astbinary.h"
 #include <string>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <sstream>
+#include <fstream>
+#include <atomic>
+#include <thread>
 
 extern int semant_debug;
+extern int compile_jobs;
+extern char *semant_cache_file;
+extern char *dep_graph_file;
 extern char *curr_filename;
 
 //////////////////////////////////////////////////////////////////////
@@ -40,6 +52,7 @@ static Symbol
     Object,
     out_int,
     out_string,
+    Poisoned,
     prim_slot,
     self,
     SELF_TYPE,
@@ -74,6 +87,10 @@ static void initialize_constants(void)
     Object = idtable.add_string("Object");
     out_int = idtable.add_string("out_int");
     out_string = idtable.add_string("out_string");
+    //   _poisoned is the type of an expression whose check failed.
+    //   Every check it takes part in passes, so that one mistake
+    //   gives one error and not also one for each enclosing expression.
+    Poisoned = idtable.add_string("_poisoned");
     prim_slot = idtable.add_string("_prim_slot");
     self = idtable.add_string("self");
     SELF_TYPE = idtable.add_string("SELF_TYPE");
@@ -84,7 +101,75 @@ static void initialize_constants(void)
     val = idtable.add_string("_val");
 }
 
-ClassTable::ClassTable(Classes classes) : semant_errors(0), error_stream(cerr)
+//////////////////////////////////////////////////////////////////////
+//
+// Diagnostics
+//
+// Errors are not printed as they are found but collected, for each
+// class check and for the checks of the whole program: semant_error
+// starts a message, which ends when the next one starts or the errors
+// are printed.  A message given twice for a class is kept once, and
+// after SEMANT_CLASS_ERRORS messages the rest of a class is not checked.
+// The collected errors are printed in class order, up to
+// SEMANT_MAX_ERRORS in all; checking stops once that many are found.
+//
+//////////////////////////////////////////////////////////////////////
+
+#define SEMANT_CLASS_ERRORS 20
+#define SEMANT_MAX_ERRORS 100
+
+struct ClassErrors
+{
+    std::ostringstream stream;              // the message being written
+    bool open;
+    std::vector<std::string> messages;      // the messages kept, in order
+    std::unordered_set<std::string> seen;
+    bool truncated;                         // messages were left out
+    size_t limit;
+
+    ClassErrors(size_t limit = SEMANT_CLASS_ERRORS)
+        : open(false), truncated(false), limit(limit) {}
+
+    ostream &start()
+    {
+        end();
+        open = true;
+        return stream;
+    }
+
+    void end()
+    {
+        if (!open)
+        {
+            return;
+        }
+        open = false;
+        std::string message = stream.str();
+        stream.str("");
+        if (!seen.insert(message).second)
+        {
+            return;
+        }
+        if (full())
+        {
+            truncated = true;
+            return;
+        }
+        messages.push_back(message);
+    }
+
+    bool full() { return messages.size() >= limit; }
+};
+
+/* the errors of the class check a thread is doing, and of the checks
+* of the whole program; and, with a cache or -d, the classes whose
+* signatures the check has looked at, with DepKind bits */
+static thread_local ClassErrors *class_errors = NULL;
+static ClassErrors program_errors(SEMANT_MAX_ERRORS);
+static thread_local std::map<Symbol, int> *class_deps = NULL;
+
+ClassTable::ClassTable(Classes classes)
+    : semant_errors(0), errors_left_out(false), error_stream(cerr)
 {
     this->class_dec_table = ClassInfoTable();
     class_dec_table.enterscope();
@@ -127,7 +212,7 @@ ClassTable::ClassTable(Classes classes) : semant_errors(0), error_stream(cerr)
         {
             Feature feature = features->nth(i);
             Symbol feature_name = feature->getName();
-            if (strcmp(feature->getFeatureType(), "METHOD") == 0) {
+            if (feature->get_kind() == AST_method) {
                 if(((method_class*) feature)->getFormals()->len() == 0) {
                     hasMainMethod = true;
                 }
@@ -144,6 +229,7 @@ ClassTable::ClassTable(Classes classes) : semant_errors(0), error_stream(cerr)
                     class_->setInheritance(this, class_dec_table);
                 }
             }
+            indexHierarchy(classes);
             /*register features */
             for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
             {
@@ -153,16 +239,16 @@ ClassTable::ClassTable(Classes classes) : semant_errors(0), error_stream(cerr)
                 }
             }
             /*start type checking for each class*/
-            for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
-            {
-                Class_ class_ = classes->nth(i);
-                if(class_->is_valid) {
-                    checkClass(class_);
-                }
-            }    
+            checkClasses(classes);
         }
     }
-    
+    printErrors(program_errors, NULL);
+    if (errors_left_out) {
+        error_stream << "Too many errors; the rest are not reported." << endl;
+    }
+    if (dep_graph_file != NULL) {
+        writeDependencies(dep_graph_file, classes);
+    }
 }
 
 /* register all features of a class */
@@ -175,13 +261,27 @@ void ClassTable::registerFeatures(Class_ class_)
             if(parent_class != NULL && !parent_class->is_registered) {
                 registerFeatures(parent_class);
             }
+            /*start from everything the parent has, sharing its tables
+            * until this class adds to them */
+            if(parent_class != NULL) {
+                class_->method_table = parent_class->method_table;
+                class_->attr_table = parent_class->attr_table;
+            }
+        }
+        MethodTable *inherited_methods = class_->method_table;
+        AttrTable *inherited_attrs = class_->attr_table;
+        if (class_->method_table == NULL) {
+            class_->method_table = new MethodTable();
+        }
+        if (class_->attr_table == NULL) {
+            class_->attr_table = new AttrTable();
         }
         Features features = class_->getFeatures();
         for (size_t i = features->first(); features->more(i); i = features->next(i))
         {
             Feature feature = features->nth(i);
             Symbol feature_name = feature->getName();
-            if (strcmp(feature->getFeatureType(), "METHOD") == 0) {
+            if (feature->get_kind() == AST_method) {
                 if (class_->method_env.probe(feature_name) != NULL)
                 {
                     semant_error(class_->get_filename(), feature) 
@@ -201,6 +301,7 @@ void ClassTable::registerFeatures(Class_ class_)
                         formal_correct = false;
                         continue;
                     }
+                    addDependency(class_, formal_type, DEP_METHOD);
                     if (!hasClass(formal_type))
                     {
                         semant_error(class_->get_filename(), feature) 
@@ -210,6 +311,7 @@ void ClassTable::registerFeatures(Class_ class_)
                         continue;
                     }
                 }
+                addDependency(class_, ((method_class *)feature)->getRetType(), DEP_METHOD);
                 if (!formal_correct)
                 {
                     continue;
@@ -217,7 +319,7 @@ void ClassTable::registerFeatures(Class_ class_)
                 /*method redefinition checking */
                 if(class_->getName() != Object) {
                     Class_ parent_class = class_dec_table.lookup(class_->getParent());
-                    method_class* ori_method = (method_class*) parent_class->method_env.lookup(feature_name);
+                    method_class* ori_method = (method_class*) parent_class->findMethod(feature_name);
                     if(ori_method != NULL) {
                         /*check formal and actual length */
                         Formals formals = ((method_class *)feature)->getFormals();
@@ -267,10 +369,15 @@ void ClassTable::registerFeatures(Class_ class_)
                     }
                 }
                 class_->method_env.addid(feature_name, (method_class *)feature);
+                if (class_->method_table == inherited_methods)
+                {
+                    class_->method_table = new MethodTable(*inherited_methods);
+                }
+                (*class_->method_table)[feature_name] = feature;
             }
-            else if (strcmp(feature->getFeatureType(), "ATTR") == 0)
+            else if (feature->get_kind() == AST_attr)
             { /*attribute feature */
-                if (class_->attr_env.lookup(feature_name) != NULL)
+                if (class_->findAttr(feature_name) != NULL)
                 {
                     semant_error(class_->get_filename(), feature) 
                     << "repititive attribute definition for " << feature_name 
@@ -278,6 +385,7 @@ void ClassTable::registerFeatures(Class_ class_)
                     continue;
                 }
                 Symbol attr_type = ((attr_class *)feature)->getTypeDecl();
+                addDependency(class_, attr_type, DEP_ATTR);
                 if (!hasClass(attr_type))
                 {
                     semant_error(class_->get_filename(), feature) << "Attribute type " 
@@ -286,6 +394,11 @@ void ClassTable::registerFeatures(Class_ class_)
                 }
                 class_->attr_env.addid(feature_name,
                                 ((attr_class *)feature)->getTypeDecl());
+                if (class_->attr_table == inherited_attrs)
+                {
+                    class_->attr_table = new AttrTable(*inherited_attrs);
+                }
+                (*class_->attr_table)[feature_name] = attr_type;
             }
         }
         class_->is_registered = true;
@@ -362,16 +475,10 @@ void ClassTable::install_basic_classes()
                filename);
 
     class_dec_table.addid(IO, IO_class);
-    Object_class->method_env.enterscope();
-    IO_class->method_env = Object_class->method_env;
-    Object_class->method_env.exitscope();
-    Object_class->attr_env.enterscope();
-    IO_class->attr_env = Object_class->attr_env;
-    Object_class->attr_env.exitscope();
-    Object_class->class_inh.enterscope();
-    IO_class->class_inh = Object_class->class_inh;
+    IO_class->method_env.inherit(Object_class->method_env);
+    IO_class->attr_env.inherit(Object_class->attr_env);
+    IO_class->class_inh.inherit(Object_class->class_inh);
     IO_class->class_inh.addid(IO, IO_class);
-    Object_class->class_inh.exitscope();
     IO_class->is_visited = true;
 
     //
@@ -385,16 +492,10 @@ void ClassTable::install_basic_classes()
                filename);
 
     class_dec_table.addid(Int, Int_class);
-    Object_class->method_env.enterscope();
-    Int_class->method_env = Object_class->method_env;
-    Object_class->method_env.exitscope();
-    Object_class->attr_env.enterscope();
-    Int_class->attr_env = Object_class->attr_env;
-    Object_class->attr_env.exitscope();
-    Object_class->class_inh.enterscope();
-    Int_class->class_inh = Object_class->class_inh;
+    Int_class->method_env.inherit(Object_class->method_env);
+    Int_class->attr_env.inherit(Object_class->attr_env);
+    Int_class->class_inh.inherit(Object_class->class_inh);
     Int_class->class_inh.addid(Int, Int_class);
-    Object_class->class_inh.exitscope();
     Int_class->is_visited = true;
 
     //
@@ -404,16 +505,10 @@ void ClassTable::install_basic_classes()
         class_(Bool, Object, single_Features(attr(val, prim_slot, no_expr())), filename);
 
     class_dec_table.addid(Bool, Bool_class);
-    Object_class->method_env.enterscope();
-    Bool_class->method_env = Object_class->method_env;
-    Object_class->method_env.exitscope();
-    Object_class->attr_env.enterscope();
-    Bool_class->attr_env = Object_class->attr_env;
-    Object_class->attr_env.exitscope();
-    Object_class->class_inh.enterscope();
-    Bool_class->class_inh = Object_class->class_inh;
+    Bool_class->method_env.inherit(Object_class->method_env);
+    Bool_class->attr_env.inherit(Object_class->attr_env);
+    Bool_class->class_inh.inherit(Object_class->class_inh);
     Bool_class->class_inh.addid(Bool, Bool_class);
-    Object_class->class_inh.exitscope();
     Bool_class->is_visited = true;
 
     //
@@ -446,16 +541,10 @@ void ClassTable::install_basic_classes()
                filename);
 
     class_dec_table.addid(Str, Str_class);
-    Object_class->method_env.enterscope();
-    Str_class->method_env = Object_class->method_env;
-    Object_class->method_env.exitscope();
-    Object_class->attr_env.enterscope();
-    Str_class->attr_env = Object_class->attr_env;
-    Object_class->attr_env.exitscope();
-    Object_class->class_inh.enterscope();
-    Str_class->class_inh = Object_class->class_inh;
+    Str_class->method_env.inherit(Object_class->method_env);
+    Str_class->attr_env.inherit(Object_class->attr_env);
+    Str_class->class_inh.inherit(Object_class->class_inh);
     Str_class->class_inh.addid(Str, Str_class);
-    Object_class->class_inh.exitscope();
     Str_class->is_visited = true;
 
     registerFeatures(Object_class);
@@ -465,64 +554,782 @@ void ClassTable::install_basic_classes()
     registerFeatures(Str_class);
 }
 
+
+//////////////////////////////////////////////////////////////////////
+//
+// Incremental checking
+//
+// With -i file, semant keeps in file what checking each class gave:
+// the diagnostics, and the class with its types as a binary AST (see
+// astbinary.h).  An entry is found by the fingerprint of the class's
+// own AST, line numbers included, and records the signature of every
+// class the check looked up; it is used only if all those signatures
+// are still the same.  A signature covers what checking another class
+// can see of a class: whether and where it is in the hierarchy, its
+// ancestors, and the types of the methods and attributes it has.
+// Registration and the other whole-program checks always run.
+//
+//////////////////////////////////////////////////////////////////////
+
+#define SEMANT_CACHE_MAGIC "COOLSEMC"
+#define SEMANT_CACHE_VERSION 3
+
+struct CacheDep
+{
+    std::string name;
+    int kinds;                      // DepKind bits, for -d
+    unsigned long long signature;
+};
+
+struct CacheEntry
+{
+    std::vector<CacheDep> deps;
+    std::vector<std::string> errors;
+    int truncated;
+    std::string typed;   // program(single_Classes(checked class)), binary
+};
+
+typedef std::unordered_map<unsigned long long, CacheEntry> SemantCache;
+
+// FNV-1a, 64 bits
+static void hash_bytes(unsigned long long &h, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char) s[i];
+        h *= 1099511628211ull;
+    }
+}
+
+static void hash_symbol(unsigned long long &h, Symbol sym)
+{
+    /*the terminating null keeps "ab","c" apart from "a","bc" */
+    hash_bytes(h, sym->get_string(), sym->get_len() + 1);
+}
+
+static unsigned long long fingerprint(Class_ class_)
+{
+    AstWriter w;
+    class_->dump_binary(w);
+    std::ostringstream out;
+    w.write(out);
+    std::string bytes = out.str();
+    unsigned long long h = 14695981039346656037ull;
+    hash_bytes(h, bytes.data(), bytes.size());
+    return h;
+}
+
+static void put_number(std::string &out, unsigned long long v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        out += (char) (v >> (8 * i));
+    }
+}
+
+static void put_bytes(std::string &out, const std::string &s)
+{
+    put_number(out, s.size());
+    out += s;
+}
+
+/* a reader over the cache file that gives up on anything malformed */
+struct CacheReader
+{
+    const std::string &in;
+    size_t pos;
+    bool ok;
+    CacheReader(const std::string &s) : in(s), pos(0), ok(true) {}
+
+    unsigned long long number()
+    {
+        if (!ok || in.size() - pos < 8)
+        {
+            ok = false;
+            return 0;
+        }
+        unsigned long long v = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            v |= (unsigned long long) (unsigned char) in[pos++] << (8 * i);
+        }
+        return v;
+    }
+
+    std::string bytes()
+    {
+        unsigned long long len = number();
+        if (!ok || in.size() - pos < len)
+        {
+            ok = false;
+            return std::string();
+        }
+        pos += len;
+        return in.substr(pos - len, len);
+    }
+};
+
+static void load_cache(const char *name, SemantCache &cache)
+{
+    FILE *f = fopen(name, "rb");
+    if (f == NULL)
+    {
+        return;   /*the first compilation */
+    }
+    std::string in;
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        in.append(buf, n);
+    }
+    fclose(f);
+
+    CacheReader r(in);
+    if (r.bytes() != SEMANT_CACHE_MAGIC || r.number() != SEMANT_CACHE_VERSION)
+    {
+        return;
+    }
+    unsigned long long entries = r.number();
+    for (unsigned long long i = 0; r.ok && i < entries; i++)
+    {
+        unsigned long long key = r.number();
+        CacheEntry e;
+        unsigned long long deps = r.number();
+        for (unsigned long long d = 0; r.ok && d < deps; d++)
+        {
+            CacheDep dep;
+            dep.name = r.bytes();
+            dep.kinds = r.number();
+            dep.signature = r.number();
+            e.deps.push_back(dep);
+        }
+        unsigned long long errors = r.number();
+        for (unsigned long long m = 0; r.ok && m < errors; m++)
+        {
+            e.errors.push_back(r.bytes());
+        }
+        e.truncated = r.number();
+        e.typed = r.bytes();
+        cache[key] = e;
+    }
+    if (!r.ok)
+    {
+        cache.clear();
+    }
+}
+
+static void save_cache(const char *name, const SemantCache &cache)
+{
+    std::string out;
+    put_bytes(out, SEMANT_CACHE_MAGIC);
+    put_number(out, SEMANT_CACHE_VERSION);
+    put_number(out, cache.size());
+    for (SemantCache::const_iterator it = cache.begin(); it != cache.end(); ++it)
+    {
+        const CacheEntry &e = it->second;
+        put_number(out, it->first);
+        put_number(out, e.deps.size());
+        for (size_t d = 0; d < e.deps.size(); d++)
+        {
+            put_bytes(out, e.deps[d].name);
+            put_number(out, e.deps[d].kinds);
+            put_number(out, e.deps[d].signature);
+        }
+        put_number(out, e.errors.size());
+        for (size_t m = 0; m < e.errors.size(); m++)
+        {
+            put_bytes(out, e.errors[m]);
+        }
+        put_number(out, e.truncated);
+        put_bytes(out, e.typed);
+    }
+    /*write a new file and rename it, so that a compilation that dies
+    * half way leaves the old cache */
+    std::string tmp = std::string(name) + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (f == NULL || fwrite(out.data(), 1, out.size(), f) != out.size())
+    {
+        cerr << "cannot write semant cache " << tmp << endl;
+        if (f != NULL)
+        {
+            fclose(f);
+        }
+        return;
+    }
+    if (fclose(f) != 0 || rename(tmp.c_str(), name) != 0)
+    {
+        cerr << "cannot write semant cache " << name << endl;
+    }
+}
+
+/* the entries loaded at the start; cached_classes point into them */
+static SemantCache semant_cache;
+
+/* the signature of a class as the checks of other classes see it */
+unsigned long long ClassTable::signature(Symbol name)
+{
+    std::unordered_map<Symbol, unsigned long long>::iterator it = class_signatures.find(name);
+    if (it != class_signatures.end())
+    {
+        return it->second;
+    }
+    unsigned long long h = 14695981039346656037ull;
+    hash_symbol(h, name);
+    Class_ class_ = class_dec_table.lookup(name);
+    if (class_ != NULL)
+    {
+        h ^= class_->is_valid + 2 * (class_->class_id >= 0);
+        h *= 1099511628211ull;
+        /*the ancestors, up to Object if it is in the tree */
+        for (Class_ c = class_; c != NULL; )
+        {
+            hash_symbol(h, c->getParent());
+            if (c->class_id <= 0)
+            {
+                break;
+            }
+            c = class_dec_table.lookup(c->getParent());
+        }
+        /*its methods and attributes, in name order */
+        std::map<std::string, Feature> methods;
+        std::map<std::string, Symbol> attrs;
+        if (class_->method_table != NULL)
+        {
+            for (auto m = class_->method_table->begin(); m != class_->method_table->end(); ++m)
+            {
+                methods[m->first->get_string()] = m->second;
+            }
+        }
+        if (class_->attr_table != NULL)
+        {
+            for (auto a = class_->attr_table->begin(); a != class_->attr_table->end(); ++a)
+            {
+                attrs[a->first->get_string()] = a->second;
+            }
+        }
+        for (auto m = methods.begin(); m != methods.end(); ++m)
+        {
+            method_class *method = (method_class *) m->second;
+            Formals formals = method->getFormals();
+            hash_symbol(h, method->getName());
+            for (int i = formals->first(); formals->more(i); i = formals->next(i))
+            {
+                hash_symbol(h, formals->nth(i)->getTypeDecl());
+            }
+            hash_symbol(h, method->getRetType());
+        }
+        for (auto a = attrs.begin(); a != attrs.end(); ++a)
+        {
+            hash_bytes(h, a->first.c_str(), a->first.size() + 1);
+            hash_symbol(h, a->second);
+        }
+    }
+    class_signatures[name] = h;
+    return h;
+}
+
+/* a class looked up by a class check; with a cache, the check now
+* depends on the class's signature */
+Class_ ClassTable::findClass(Symbol name, int kind)
+{
+    if (class_deps != NULL)
+    {
+        (*class_deps)[name] |= kind;
+    }
+    return class_dec_table.lookup(name);
+}
+
+/* record that a class depends on another, for -d */
+void ClassTable::addDependency(Class_ class_, Symbol name, int kind)
+{
+    if (dep_graph_file == NULL || name == SELF_TYPE || name == class_->getName())
+    {
+        return;
+    }
+    class_graph[class_->getName()][name] |= kind;
+}
+
+/* write the class dependency graph for -d: first a line
+*     class NAME SIGNATURE FILE
+* for each class of the program and each class one of them depends on,
+* SIGNATURE being the hex signature of the class (see signature) and
+* FILE "-" for classes that are not defined; then a line
+*     depends NAME OTHER KIND,...
+* for each class another depends on, KIND being inherits, attr, method,
+* dispatch or uses; all in name order.
+* A class has to be checked again after an edit if its own definition
+* changed or the signature of a class it depends on did.  The signature
+* of a class covers what it inherits, so the dependencies of a class
+* need not be followed any further than one step.
+*/
+void ClassTable::writeDependencies(const char *name, Classes classes)
+{
+    static const char *kind_names[] = { "inherits", "attr", "method", "dispatch", "uses" };
+    /*the program's classes, and then the classes they depend on; the
+    * basic classes' own dependencies are left out */
+    std::map<std::string, Symbol> sources, names;
+    for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
+    {
+        Symbol class_name = classes->nth(i)->getName();
+        sources[class_name->get_string()] = class_name;
+    }
+    names = sources;
+    for (auto n = sources.begin(); n != sources.end(); ++n)
+    {
+        auto c = class_graph.find(n->second);
+        if (c == class_graph.end())
+        {
+            continue;
+        }
+        for (auto d = c->second.begin(); d != c->second.end(); ++d)
+        {
+            names[d->first->get_string()] = d->first;
+        }
+    }
+
+    std::ofstream out(name);
+    for (auto n = names.begin(); n != names.end(); ++n)
+    {
+        Class_ class_ = class_dec_table.lookup(n->second);
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", signature(n->second));
+        out << "class " << n->first << " " << hex << " "
+            << (class_ != NULL ? class_->get_filename()->get_string() : "-") << "\n";
+    }
+    for (auto n = sources.begin(); n != sources.end(); ++n)
+    {
+        auto c = class_graph.find(n->second);
+        if (c == class_graph.end())
+        {
+            continue;
+        }
+        std::map<std::string, int> deps;
+        for (auto d = c->second.begin(); d != c->second.end(); ++d)
+        {
+            deps[d->first->get_string()] = d->second;
+        }
+        for (auto d = deps.begin(); d != deps.end(); ++d)
+        {
+            out << "depends " << n->first << " " << d->first << " ";
+            const char *sep = "";
+            for (int k = 0; k < 5; k++)
+            {
+                if (d->second & (1 << k))
+                {
+                    out << sep << kind_names[k];
+                    sep = ",";
+                }
+            }
+            out << "\n";
+        }
+    }
+    if (!out)
+    {
+        cerr << "cannot write class dependencies to " << name << endl;
+    }
+}
+
+/* type check every valid class, on compile_jobs threads.
+* Once the features are registered a class check only reads the
+* tables shared between classes: attributes it rebinds go into its
+* own environment (see checkClass), and types into its own nodes.
+* Reading a list can write it, though, the first time, when it
+* flattens itself into node_arena, which has no lock; so before the
+* threads start every list of every class is flattened, and from then
+* on the trees they share do not change.
+* Threads take the next unchecked class as they finish one; the errors
+* of each class are kept apart and printed in class order, so the
+* output is that of checking the classes one after another.  Once the
+* classes checked have SEMANT_MAX_ERRORS errors no more are taken, and
+* the classes checked are made to be the first ones, which have all the
+* errors that are printed.
+* With a cache (-i), classes whose entries are still good are not
+* checked at all; see checkedClasses.
+*/
+void ClassTable::checkClasses(Classes classes)
+{
+    std::vector<Class_> valid;
+    for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
+    {
+        Class_ class_ = classes->nth(i);
+        if(class_->is_valid) {
+            valid.push_back(class_);
+        }
+    }
+    int jobs = std::min<int>(compile_jobs, valid.size());
+    bool record = semant_cache_file != NULL || dep_graph_file != NULL;
+    printErrors(program_errors, NULL);
+    if (semant_errors >= SEMANT_MAX_ERRORS)
+    {
+        errors_left_out = !valid.empty();
+        return;
+    }
+
+    /*look the classes up in the cache */
+    std::vector<ClassErrors> errors(valid.size());
+    std::vector<std::map<Symbol, int> > deps(valid.size());
+    std::vector<unsigned long long> keys(valid.size());
+    std::vector<size_t> todo;
+    SemantCache next_cache;
+    if (semant_cache_file != NULL)
+    {
+        load_cache(semant_cache_file, semant_cache);
+    }
+    for (size_t i = 0; i < valid.size(); i++)
+    {
+        if (semant_cache_file == NULL)
+        {
+            todo.push_back(i);
+            continue;
+        }
+        keys[i] = fingerprint(valid[i]);
+        SemantCache::iterator hit = semant_cache.find(keys[i]);
+        bool current = hit != semant_cache.end();
+        for (size_t d = 0; current && d < hit->second.deps.size(); d++)
+        {
+            const CacheDep &dep = hit->second.deps[d];
+            Symbol name = idtable.add_string((char *) dep.name.c_str());
+            current = signature(name) == dep.signature;
+            deps[i][name] = dep.kinds;
+        }
+        if (!current)
+        {
+            deps[i].clear();
+            todo.push_back(i);
+            continue;
+        }
+        errors[i].messages = hit->second.errors;
+        errors[i].truncated = hit->second.truncated;
+        cached_classes[valid[i]] = &hit->second.typed;
+        next_cache[keys[i]] = hit->second;
+    }
+
+    if (semant_debug && semant_cache_file != NULL)
+    {
+        cerr << "semant cache: checking " << todo.size() << " of "
+             << valid.size() << " classes" << endl;
+    }
+
+    /*check the others */
+    std::vector<char> done(todo.size());
+    std::atomic<size_t> next(0);
+    std::atomic<int> found(semant_errors);
+    auto check_one = [&](size_t t) {
+        size_t i = todo[t];
+        class_errors = &errors[i];
+        class_deps = record ? &deps[i] : NULL;
+        deps[i][valid[i]->getName()] |= DEP_USES;
+        checkClass(valid[i]);
+        errors[i].end();
+        found += errors[i].messages.size();
+        done[t] = true;
+        class_errors = NULL;
+        class_deps = NULL;
+    };
+    auto check = [&]() {
+        for (size_t t = next++; t < todo.size() && found < SEMANT_MAX_ERRORS; t = next++)
+        {
+            check_one(t);
+        }
+    };
+    jobs = std::min<int>(jobs, todo.size());
+    if (jobs <= 1)
+    {
+        check();
+    }
+    else
+    {
+        /*make every list the threads can read flat now, in this thread:
+        * the classes in the hierarchy, which have the features the
+        * checks look up, and the valid classes outside it */
+        for (size_t c = 0; c < class_by_id.size(); c++)
+        {
+            class_by_id[c]->flattenLists();
+        }
+        for (size_t i = 0; i < valid.size(); i++)
+        {
+            if (valid[i]->class_id < 0)
+            {
+                valid[i]->flattenLists();
+            }
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < jobs; t++)
+        {
+            threads.push_back(std::thread(check));
+        }
+        for (int t = 0; t < jobs; t++)
+        {
+            threads[t].join();
+        }
+        /*a thread may have left a class for too many errors that others
+        * found after it; check the classes before the last one checked */
+        size_t last = todo.size();
+        while (last > 0 && !done[last - 1])
+        {
+            last--;
+        }
+        for (size_t t = 0; t < last; t++)
+        {
+            if (!done[t])
+            {
+                check_one(t);
+            }
+        }
+    }
+    bool complete = std::find(done.begin(), done.end(), false) == done.end();
+
+    /*keep the entries of this program's classes, and only those;
+    * classes left unchecked for too many errors have none.  The
+    * entries are made before printErrors empties the messages */
+    bool save = semant_cache_file != NULL && complete;
+    if (save)
+    {
+        for (size_t t = 0; t < todo.size(); t++)
+        {
+            size_t i = todo[t];
+            CacheEntry &e = next_cache[keys[i]];
+            for (auto d = deps[i].begin(); d != deps[i].end(); ++d)
+            {
+                CacheDep dep;
+                dep.name = d->first->get_string();
+                dep.kinds = d->second;
+                dep.signature = signature(d->first);
+                e.deps.push_back(dep);
+            }
+            e.errors = errors[i].messages;
+            e.truncated = errors[i].truncated;
+            std::ostringstream typed;
+            dump_binary(typed, program(single_Classes(valid[i])));
+            e.typed = typed.str();
+        }
+    }
+    for (size_t i = 0; i < valid.size(); i++)
+    {
+        printErrors(errors[i], valid[i]);
+    }
+    if (!complete)
+    {
+        errors_left_out = true;
+    }
+    for (size_t i = 0; i < valid.size(); i++)
+    {
+        for (auto d = deps[i].begin(); d != deps[i].end(); ++d)
+        {
+            addDependency(valid[i], d->first, d->second);
+        }
+    }
+    if (save)
+    {
+        save_cache(semant_cache_file, next_cache);
+    }
+}
+
+/* the program's classes, with each class that was not checked because
+* its cache entry was good replaced by the checked class from the entry */
+Classes ClassTable::checkedClasses(Classes classes)
+{
+    if (cached_classes.empty())
+    {
+        return classes;
+    }
+    Classes result = nil_Classes();
+    for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
+    {
+        Class_ class_ = classes->nth(i);
+        std::map<Class_, const std::string *>::iterator it = cached_classes.find(class_);
+        if (it != cached_classes.end())
+        {
+            const std::string &typed = *it->second;
+            Program p = read_binary_ast((const unsigned char *) typed.data(), typed.size());
+            class_ = p->getClasses()->nth(0);
+        }
+        result = append_Classes(result, single_Classes(class_));
+    }
+    return result;
+}
+
 /* type check a class*/
 void ClassTable::checkClass(Class_ class_)
 {
+    /*attribute checks rebind attributes here rather than in attr_env,
+    * which the subclasses share */
+    AttrInfoTable class_env;
+    class_env.inherit(class_->attr_env);
     Features features = class_->getFeatures();
     for (size_t i = features->first(); features->more(i); i = features->next(i))
     {
         Feature feature = features->nth(i);
         Symbol feature_name = feature->getName();
-        feature->check(this, class_);
+        feature->check(this, class_env, class_);
+        if (class_errors != NULL && class_errors->full())
+        {
+            break;   /*the rest would not be reported */
+        }
     }
 }
 
+/* number the inheritance tree for checkAscent and unionType.
+* A class is in the tree if its whole chain of parents was set up by
+* setInheritance and leads to Object; classes in an inheritance cycle
+* and the duplicates of a class name are left out.
+*/
+void ClassTable::indexHierarchy(Classes classes)
+{
+    /*collect the classes known by name, basic classes first */
+    std::vector<Class_> members;
+    Symbol basic[] = { Object, IO, Int, Bool, Str };
+    for (size_t i = 0; i < sizeof(basic) / sizeof(basic[0]); i++)
+    {
+        members.push_back(class_dec_table.lookup(basic[i]));
+    }
+    for (size_t i = classes->first(); classes->more(i); i = classes->next(i))
+    {
+        Class_ class_ = classes->nth(i);
+        if (class_->is_valid && class_->getName() != Object &&
+            class_dec_table.lookup(class_->getName()) == class_)
+        {
+            members.push_back(class_);
+        }
+    }
+    /*children in declaration order, as the index of the first child
+    * and of each next sibling */
+    int count = members.size();
+    std::vector<int> first_child(count, -1), next_sibling(count, -1);
+    std::map<Class_, int> position;
+    for (int i = 0; i < count; i++)
+    {
+        position[members[i]] = i;
+    }
+    for (int i = count - 1; i > 0; i--)
+    {
+        Class_ parent = class_dec_table.lookup(members[i]->getParent());
+        std::map<Class_, int>::iterator it = position.find(parent);
+        if (it != position.end())
+        {
+            next_sibling[i] = first_child[it->second];
+            first_child[it->second] = i;
+        }
+    }
+    /*preorder walk from Object; an explicit stack keeps deep chains
+    * of classes off the C++ stack */
+    class_by_id.clear();
+    class_last.clear();
+    class_depth.clear();
+    /*a stack entry is a member and the id of its parent, or, once the
+    * member is numbered, ~id to close its range after its children */
+    std::vector<int> parent_id;
+    std::vector<std::pair<int, int> > stack;
+    stack.push_back(std::make_pair(0, 0));
+    while (!stack.empty())
+    {
+        int i = stack.back().first, up = stack.back().second;
+        stack.pop_back();
+        if (i < 0)
+        {
+            class_last[~i] = class_by_id.size() - 1;
+            continue;
+        }
+        int id = class_by_id.size();
+        members[i]->class_id = id;
+        class_by_id.push_back(members[i]);
+        class_last.push_back(id);
+        class_depth.push_back(id == 0 ? 0 : class_depth[up] + 1);
+        parent_id.push_back(up);
+        stack.push_back(std::make_pair(~id, 0));
+        /*push the children backwards so they are numbered in order */
+        size_t mark = stack.size();
+        for (int c = first_child[i]; c >= 0; c = next_sibling[c])
+        {
+            stack.push_back(std::make_pair(c, id));
+        }
+        std::reverse(stack.begin() + mark, stack.end());
+    }
+    /*ancestor tables, as deep as the deepest class needs */
+    int n = class_by_id.size();
+    int deepest = 0;
+    for (int id = 0; id < n; id++)
+    {
+        deepest = std::max(deepest, class_depth[id]);
+    }
+    class_levels = 1;
+    while ((1 << class_levels) <= deepest)
+    {
+        class_levels++;
+    }
+    class_up.resize(class_levels * n);
+    for (int id = 0; id < n; id++)
+    {
+        class_up[id] = parent_id[id];
+    }
+    for (int k = 1; k < class_levels; k++)
+    {
+        for (int id = 0; id < n; id++)
+        {
+            class_up[k * n + id] = class_up[(k - 1) * n + class_up[(k - 1) * n + id]];
+        }
+    }
+}
+
+/*the preorder number of a class, or -1 if it is not in the tree */
+int ClassTable::classId(Symbol type)
+{
+    Class_ class_ = findClass(type);
+    return class_ == NULL ? -1 : class_->class_id;
+}
+
 /**check if ltype is the ascent of rtype 
 * both rtype and ltype must be valid types
 */
 bool ClassTable::checkAscent(Symbol ltype, Symbol rtype)
 {
-    Class_ r_class = class_dec_table.lookup(rtype);
-    Class_ found = r_class->class_inh.lookup(ltype);
-    return found != NULL;
+    if (rtype == Poisoned)
+    {
+        return true;
+    }
+    int l_id = classId(ltype), r_id = classId(rtype);
+    return l_id >= 0 && r_id >= l_id && r_id <= class_last[l_id];
 }
 
 /*check if a class exists */
 bool ClassTable::hasClass(Symbol tocheck)
 {
-    Class_ tocheck_class = class_dec_table.lookup(tocheck);
+    Class_ tocheck_class = findClass(tocheck);
     return tocheck_class != NULL;
 }
 
+/*the least common ancestor of two classes, found by lifting rtype
+* to its highest ancestor that is not an ascent of ltype */
 Symbol ClassTable::unionType(Symbol ltype, Symbol rtype)
 {
-    if (ltype == Object || rtype == Object)
+    if (ltype == Poisoned || rtype == Poisoned)
+    {
+        return Poisoned;
+    }
+    int l_id = classId(ltype), r_id = classId(rtype);
+    if (l_id <= 0 || r_id <= 0)
     {
         return Object;
     }
-    else
+    if (r_id <= l_id && l_id <= class_last[r_id])
     {
-        Class_ l_class = class_dec_table.lookup(ltype);
-        Class_ r_class = class_dec_table.lookup(rtype);
-        if (l_class->class_inh.lookup(rtype) != NULL)
-        {
-            return rtype;
-        }
-        else if (r_class->class_inh.lookup(ltype) != NULL)
-        {
-            return ltype;
-        }
-        while (l_class->class_inh.lookup(rtype) == NULL)
+        return rtype;
+    }
+    int n = class_by_id.size();
+    for (int k = class_levels - 1; k >= 0; k--)
+    {
+        int up = class_up[k * n + r_id];
+        if (!(up <= l_id && l_id <= class_last[up]))
         {
-            rtype = r_class->getParent();
-            r_class = class_dec_table.lookup(rtype);
+            r_id = up;
         }
-        return rtype;
     }
+    return class_by_id[class_up[r_id]]->getName();
 }
 
 void class__class::setInheritance(ClassTable *class_table,
-                                  ClassInfoTable class_dec_table)
+                                  ClassInfoTable &class_dec_table)
 {
     /*exclude classes already set its inheritance*/
     if (!is_visited)
@@ -532,6 +1339,7 @@ void class__class::setInheritance(ClassTable *class_table,
             class_table->semant_error(this) << "Cant inherit from SELF_TYPE." << endl;
             this->is_valid = false;
         } else {
+            class_table->addDependency(this, parent, DEP_INHERITS);
             Class_ parent_class = class_dec_table.lookup(parent);
             if(parent_class != NULL) {
                 if (parent == Str ||
@@ -543,17 +1351,10 @@ void class__class::setInheritance(ClassTable *class_table,
                 } else {
                     parent_class->setInheritance(class_table, class_dec_table);
                     if(parent_class->is_valid) {
-                        parent_class->method_env.enterscope();
-                        this->method_env = parent_class->method_env;
-                        parent_class->method_env.exitscope();
-
-                        parent_class->attr_env.enterscope();
-                        this->attr_env = parent_class->attr_env;
-                        parent_class->attr_env.exitscope();
-                        
-                        parent_class->class_inh.enterscope();
-                        this->class_inh = parent_class->class_inh;
-                        parent_class->class_inh.exitscope();
+                        /*inherit live views of the parent's tables */
+                        this->method_env.inherit(parent_class->method_env);
+                        this->attr_env.inherit(parent_class->attr_env);
+                        this->class_inh.inherit(parent_class->class_inh);
                         /*add class to its own inh */
                         class_inh.addid(name, this);
                     } else {
@@ -580,7 +1381,7 @@ Symbol method_class::matchParam(Expressions actual,
         class_table->semant_error(class_->get_filename(), this)
             << "expected " << formals->len() << " parameters but "
             << actual->len() << " were given" << endl;
-        return Object;
+        return Poisoned;
     }
     /*check formal and actual match */
     bool is_param_matched = true;
@@ -608,16 +1409,16 @@ Symbol method_class::matchParam(Expressions actual,
     }
     else
     {
-        return Object;
+        return Poisoned;
     }
 }
 
 /*method feature */
 void method_class::check(ClassTable *class_table,
-                         Class_ class_)
+                         AttrInfoTable &class_env, Class_ class_)
 {
-    class_->attr_env.enterscope();
-    AttrInfoTable curr_env = class_->attr_env;
+    AttrInfoTable curr_env;
+    curr_env.inherit(class_env);
     /*register formals */
     for (size_t i = formals->first(); formals->more(i); i = formals->next(i))
     {
@@ -666,7 +1467,8 @@ void method_class::check(ClassTable *class_table,
                 << expr->get_type()->get_string() << endl;
             }
         } else {
-            if(ret_type == SELF_TYPE || !class_table->checkAscent(ret_type, expr_type)) {
+            if(expr_type != Poisoned &&
+               (ret_type == SELF_TYPE || !class_table->checkAscent(ret_type, expr_type))) {
                 class_table->semant_error(class_->get_filename(), this)
                 << "return type "<< return_type->get_string() 
                 << " does not match with expr type " 
@@ -674,14 +1476,13 @@ void method_class::check(ClassTable *class_table,
             }
         }
     }  
-    class_->attr_env.exitscope();
 }
 
 /*attribute feature */
 void attr_class::check(ClassTable *class_table,
-                       Class_ class_)
+                       AttrInfoTable &class_env, Class_ class_)
 {
-    init->check(class_table, class_->attr_env, class_);
+    init->check(class_table, class_env, class_);
     Symbol init_type = init->type;
     if(init_type == SELF_TYPE) {
         init_type = class_->getName();
@@ -691,7 +1492,7 @@ void attr_class::check(ClassTable *class_table,
             class_table->semant_error(class_->get_filename(), this)
             << "'self' cannot be a name of an attribute." << endl;
         } else {
-            class_->attr_env.addid(name, type_decl);
+            class_env.addid(name, type_decl);
         }
     } else {
         if(type_decl == SELF_TYPE) {
@@ -707,7 +1508,7 @@ void attr_class::check(ClassTable *class_table,
                     << " and expression type " << init_type
                     << " does not match" << endl;
                 } else {
-                    class_->attr_env.addid(name, init_type);
+                    class_env.addid(name, init_type == Poisoned ? SELF_TYPE : init_type);
                 }
             }       
         } else {
@@ -722,7 +1523,7 @@ void attr_class::check(ClassTable *class_table,
                         << " and expression type " << init_type
                         << " does not match" << endl;
                 } else {
-                    class_->attr_env.addid(name, init_type);
+                    class_env.addid(name, init_type == Poisoned ? type_decl : init_type);
                 }
             }
         } 
@@ -748,14 +1549,14 @@ void branch_class::check(ClassTable *class_table,
         class_table->semant_error(class_->get_filename(), this)
             << "branch type decl class " << type_decl->get_string()
             << " does not exist" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     else if (type_decl == SELF_TYPE)
     {
         class_table->semant_error(class_->get_filename(), this)
             << "SELF_TYPE should not appear in case" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     env.addid(name, type_decl);
@@ -771,7 +1572,7 @@ void branch_class::check(ClassTable *class_table,
             << "case " << name->get_string() << "expr's type "
             << expr_type->get_string() << " and its declaration "
             << type_decl->get_string() << " does not match" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     this->type = expr->type;
@@ -786,7 +1587,7 @@ void assign_class::check(ClassTable *class_table,
     {
         class_table->semant_error(class_->get_filename(), this)
             << "self should not appear in assignment" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     /*check if name exists */
@@ -795,7 +1596,7 @@ void assign_class::check(ClassTable *class_table,
     {
         class_table->semant_error(class_->get_filename(), this) << "name " 
             << name->get_string() << " is not defined" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     /*check declared type and assignment type match */
@@ -809,12 +1610,23 @@ void assign_class::check(ClassTable *class_table,
         class_table->semant_error(class_->get_filename(), this) << "declared type " 
             << type_decl << " and assignment expression type" << expr_type 
             << " does not match" << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
     this->type = expr->type;
 }
 
+/* check the arguments of a dispatch that cannot be checked against a
+* method, for the errors in them */
+static void checkActuals(Expressions actual, ClassTable *class_table,
+                         AttrInfoTable &env, Class_ class_)
+{
+    for (size_t i = actual->first(); actual->more(i); i = actual->next(i))
+    {
+        actual->nth(i)->check(class_table, env, class_);
+    }
+}
+
 void static_dispatch_class::check(ClassTable *class_table,
                                   AttrInfoTable &env, Class_ class_)
 {
@@ -823,23 +1635,37 @@ void static_dispatch_class::check(ClassTable *class_table,
     if(expr_type == SELF_TYPE) {
         expr_type = class_->getName();
     }
-    Class_ expr_class = class_table->class_dec_table.lookup(expr_type);
+    Class_ expr_class = expr_type == Poisoned ? NULL : class_table->findClass(expr_type);
+    if (expr_class == NULL)
+    {
+        /*the error in expr has been reported */
+        checkActuals(actual, class_table, env, class_);
+        this->type = Poisoned;
+        return;
+    }
     Class_ parent_class = expr_class->class_inh.lookup(type_name);
+    if (parent_class != NULL)
+    {
+        class_table->findClass(type_name, DEP_DISPATCH);   /*its methods are used below */
+    }
     if (parent_class == NULL)
     {
         class_table->semant_error(class_->get_filename(), this) << "class " 
         << expr_type->get_string() << " has no parent named " 
         << type_name->get_string() << endl;
-        this->type = Object;
+        this->type = Poisoned;
         return;
     }
 
-    method_class *method = (method_class *)parent_class->method_env.lookup(name);
+    method_class *method = (method_class *)parent_class->findMethod(name);
     if (method == NULL)
     {
         class_table->semant_error(class_->get_filename(), this)
         << "Dispatch to undefined method " 
         << name->get_string() << endl;
+        checkActuals(actual, class_table, env, class_);
+        this->type = Poisoned;
+        return;
     }
     this->type = method->matchParam(actual, class_table, env, class_);
     if(this->type == SELF_TYPE) {
@@ -859,15 +1685,24 @@ void dispatch_class::check(ClassTable *class_table,
     if(expr_type == SELF_TYPE) {
         expr_type = class_->getName();
     }
-    Class_ expr_class = class_table->class_dec_table.lookup(expr_type);
+    Class_ expr_class = expr_type == Poisoned ? NULL
+                        : class_table->findClass(expr_type, DEP_DISPATCH);
+    if (expr_class == NULL)
+    {
+        /*the error in expr has been reported */
+        checkActuals(actual, class_table, env, class_);
+        this->type = Poisoned;
+        return;
+    }
     /*check if method exists */
-    method_class *method = (method_class *)expr_class->method_env.lookup(name);
+    method_class *method = (method_class *)expr_class->findMethod(name);
     if (method == NULL)
     {
         class_table->semant_error(class_->get_filename(), this) << "method " 
         << name->get_string() << " is not defined in " 
         << "class " << expr_class->getName()->get_string() << endl;
-        this->type = Object;
+        checkActuals(actual, class_table, env, class_);
+        this->type = Poisoned;
         return;
     }
     this->type = method->matchParam(actual, class_table, env, class_);
@@ -888,7 +1723,7 @@ void cond_class::check(ClassTable *class_table,
     if(pred_type == SELF_TYPE) {
         pred_type = class_->getName();
     }
-    if (Bool != pred_type)
+    if (Bool != pred_type && Poisoned != pred_type)
     {
         class_table->semant_error(class_->get_filename(), this) 
         << "pred type should be bool other than " 
@@ -914,7 +1749,7 @@ void loop_class::check(ClassTable *class_table,
     if(pred_type == SELF_TYPE) {
         pred_type = class_->getName();
     }
-    if (Bool != pred_type)
+    if (Bool != pred_type && Poisoned != pred_type)
     {
         class_table->semant_error(class_->get_filename(), this) 
         << "pred type should be bool other than " 
@@ -990,7 +1825,7 @@ void let_class::check(ClassTable *class_table,
     if(identifier == self) {
         class_table->semant_error(class_->get_filename(), this)
         << "'self' cannot be bound in a 'let' expression." << endl;
-        this->type = Object;
+        this->type = Poisoned;
     }
     else if (type_decl == SELF_TYPE) {
         init->check(class_table, env, class_);
@@ -1017,7 +1852,7 @@ void let_class::check(ClassTable *class_table,
     {
         class_table->semant_error(class_->get_filename(), this) << "class " 
         << type_decl->get_string() << " has not been defined" << endl;
-        this->type = Object;
+        this->type = Poisoned;
     } 
     else
     {
@@ -1049,18 +1884,18 @@ void plus_class::check(ClassTable *class_table,
                        AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "plus expression has left type " << e1->type->get_string() 
         << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "plus expression has right type " << e2->type->get_string() 
         << " instead of Int" << endl;
@@ -1073,18 +1908,18 @@ void sub_class::check(ClassTable *class_table,
                       AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "sub expression has left type " << e1->type->get_string() 
         << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "plus expression has right type " << e2->type->get_string() 
         << " instead of Int" << endl;
@@ -1097,18 +1932,18 @@ void mul_class::check(ClassTable *class_table,
                       AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "mul expression has left type " << e1->type->get_string() 
         << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "mul expression has right type " << e2->type->get_string() 
         << " instead of Int" << endl;
@@ -1121,18 +1956,18 @@ void divide_class::check(ClassTable *class_table,
                          AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "divide expression has left type "
         << e1->type->get_string() << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "divide expression has right type "
         << e2->type->get_string() << " instead of Int" << endl;
@@ -1145,9 +1980,9 @@ void neg_class::check(ClassTable *class_table,
                       AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "neg expression has type " << e1->type->get_string() 
         << " instead of Int" << endl;
@@ -1160,18 +1995,18 @@ void lt_class::check(ClassTable *class_table,
                      AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "lt expression has left type " << e1->type->get_string()
         << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "lt expression has right type " << e2->type->get_string() 
         << " instead of Int" << endl;
@@ -1185,7 +2020,11 @@ void eq_class::check(ClassTable *class_table,
 {
     e1->check(class_table, env, class_);
     e2->check(class_table, env, class_);
-    if (e1->type == Int || e1->type == Bool || e1->type == Str
+    if (e1->type == Poisoned || e2->type == Poisoned)
+    {
+        /*its error has been reported */
+    }
+    else if (e1->type == Int || e1->type == Bool || e1->type == Str
         || e2->type == Int || e2->type == Bool || e2->type ==  Str)
     {
         if(e2->type != e1->type) {
@@ -1202,18 +2041,18 @@ void leq_class::check(ClassTable *class_table,
                       AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Int)
+    if (e1->type != Int && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "leq expression has left type " << e1->type->get_string() 
         << " instead of Int" << endl;
         return;
     }
     e2->check(class_table, env, class_);
-    if (e2->type != Int)
+    if (e2->type != Int && e2->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "leq expression has right type " << e2->type->get_string() 
         << " instead of Int" << endl;
@@ -1226,9 +2065,9 @@ void comp_class::check(ClassTable *class_table,
                        AttrInfoTable &env, Class_ class_)
 {
     e1->check(class_table, env, class_);
-    if (e1->type != Bool)
+    if (e1->type != Bool && e1->type != Poisoned)
     {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) 
         << "comp expression has type " << e1->type->get_string() 
         << " instead of Bool" << endl;
@@ -1262,7 +2101,7 @@ void new__class::check(ClassTable *class_table,
     {
         this->type = SELF_TYPE;
     } else if (!class_table->hasClass(type_name)) {
-        this->type = Object;
+        this->type = Poisoned;
         class_table->semant_error(class_->get_filename(), this) << "class " 
         << type_name->get_string() << " has not been defined" << endl;
     } else {
@@ -1297,7 +2136,7 @@ void object_class::check(ClassTable *class_table,
         {
             class_table->semant_error(class_->get_filename(), this)
             << name->get_string() << " is not defined" << endl;
-            this->type = Object;
+            this->type = Poisoned;
         }
         else
         {
@@ -1306,6 +2145,161 @@ void object_class::check(ClassTable *class_table,
     }
 }
 
+/* flattenLists: an append_node flattens itself into node_arena the
+* first time it is read, so the lists of the classes are all flattened
+* before checkClasses shares them between threads */
+void class__class::flattenLists()
+{
+    for (size_t i = features->first(); features->more(i); i = features->next(i))
+    {
+        features->nth(i)->flattenLists();
+    }
+}
+
+void method_class::flattenLists()
+{
+    formals->len();
+    expr->flattenLists();
+}
+
+void attr_class::flattenLists()
+{
+    init->flattenLists();
+}
+
+void branch_class::flattenLists()
+{
+    expr->flattenLists();
+}
+
+void assign_class::flattenLists()
+{
+    expr->flattenLists();
+}
+
+void static_dispatch_class::flattenLists()
+{
+    expr->flattenLists();
+    for (size_t i = actual->first(); actual->more(i); i = actual->next(i))
+    {
+        actual->nth(i)->flattenLists();
+    }
+}
+
+void dispatch_class::flattenLists()
+{
+    expr->flattenLists();
+    for (size_t i = actual->first(); actual->more(i); i = actual->next(i))
+    {
+        actual->nth(i)->flattenLists();
+    }
+}
+
+void cond_class::flattenLists()
+{
+    pred->flattenLists();
+    then_exp->flattenLists();
+    else_exp->flattenLists();
+}
+
+void loop_class::flattenLists()
+{
+    pred->flattenLists();
+    body->flattenLists();
+}
+
+void typcase_class::flattenLists()
+{
+    expr->flattenLists();
+    for (size_t i = cases->first(); cases->more(i); i = cases->next(i))
+    {
+        cases->nth(i)->flattenLists();
+    }
+}
+
+void block_class::flattenLists()
+{
+    for (size_t i = body->first(); body->more(i); i = body->next(i))
+    {
+        body->nth(i)->flattenLists();
+    }
+}
+
+void let_class::flattenLists()
+{
+    init->flattenLists();
+    body->flattenLists();
+}
+
+void plus_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void sub_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void mul_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void divide_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void neg_class::flattenLists()
+{
+    e1->flattenLists();
+}
+
+void lt_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void eq_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void leq_class::flattenLists()
+{
+    e1->flattenLists();
+    e2->flattenLists();
+}
+
+void comp_class::flattenLists()
+{
+    e1->flattenLists();
+}
+
+void isvoid_class::flattenLists()
+{
+    e1->flattenLists();
+}
+
+void int_const_class::flattenLists() { }
+
+void bool_const_class::flattenLists() { }
+
+void string_const_class::flattenLists() { }
+
+void new__class::flattenLists() { }
+
+void no_expr_class::flattenLists() { }
+
+void object_class::flattenLists() { }
+
 ////////////////////////////////////////////////////////////////////
 //
 // semant_error is an overloaded function for reporting errors
@@ -1328,14 +2322,51 @@ ostream &ClassTable::semant_error(Class_ c)
 
 ostream &ClassTable::semant_error(Symbol filename, tree_node *t)
 {
-    error_stream << filename << ":" << t->get_line_number() << ": ";
-    return semant_error();
+    ostream &stream = semant_error();
+    stream << filename << ":" << t->get_line_number() << ": ";
+    return stream;
 }
 
 ostream &ClassTable::semant_error()
 {
-    semant_errors++;
-    return error_stream;
+    if (class_errors != NULL)
+    {
+        return class_errors->start();
+    }
+    return program_errors.start();
+}
+
+/* print the errors of a class check, or of the checks of the whole
+* program if class_ is NULL, while fewer than SEMANT_MAX_ERRORS have
+* been printed */
+void ClassTable::printErrors(ClassErrors &errors, Class_ class_)
+{
+    errors.end();
+    for (size_t m = 0; m < errors.messages.size(); m++)
+    {
+        if (semant_errors >= SEMANT_MAX_ERRORS)
+        {
+            errors_left_out = true;
+            break;
+        }
+        error_stream << errors.messages[m];
+        semant_errors++;
+    }
+    if (errors.truncated)
+    {
+        if (class_ == NULL || semant_errors >= SEMANT_MAX_ERRORS)
+        {
+            errors_left_out = true;
+        }
+        else
+        {
+            error_stream << class_->get_filename() << ":" << class_->get_line_number()
+                         << ": Too many errors in class " << class_->getName()
+                         << "; the rest of it is not checked." << endl;
+        }
+    }
+    errors.messages.clear();
+    errors.truncated = false;
 }
 
 /*   This is the entry point to the semantic checker.
@@ -1357,6 +2388,7 @@ void program_class::semant()
 
     /* ClassTable constructor may do some semantic analysis */
     ClassTable *classtable = new ClassTable(classes);
+    classes = classtable->checkedClasses(classes);
 
     /* some semantic analysis code may go here */
 
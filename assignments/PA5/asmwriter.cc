@@ -0,0 +1,108 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+///////////////////////////////////////////////////////////////////////////
+//
+// file: asmwriter.cc
+//
+// The buffered writer the code generator emits assembly through.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "asmwriter.h"
+#include "utilities.h"   // for fatal_error
+
+static char *new_buffer()
+{
+    char *buf = (char *) malloc(ASM_BUFFER);
+    if (buf == NULL)
+	fatal_error("out of memory\n");
+    return buf;
+}
+
+AsmWriter::AsmWriter(const char *filename)
+    : buf(new_buffer()), cur(buf), limit(buf + ASM_BUFFER),
+      stream(NULL), failed(false)
+{
+    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+	failed = true;
+}
+
+AsmWriter::AsmWriter(ostream &s)
+    : buf(new_buffer()), cur(buf), limit(buf + ASM_BUFFER),
+      fd(-1), stream(&s), failed(false)
+{
+}
+
+AsmWriter::~AsmWriter()
+{
+    flush();
+    if (fd >= 0)
+	close(fd);
+    free(buf);
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// AsmWriter::drain
+//
+// Write out the buffer and start it again.  Once a write has failed
+// nothing more is written, but the buffer is still emptied so the
+// code generator can run to the end.
+//
+///////////////////////////////////////////////////////////////////////////
+void AsmWriter::drain()
+{
+    const char *p = buf;
+    size_t left = cur - buf;
+    cur = buf;
+    if (failed)
+	return;
+    if (fd < 0) {
+	stream->write(p, left);
+	failed = !*stream;
+	return;
+    }
+    while (left > 0) {
+	ssize_t n = ::write(fd, p, left);
+	if (n < 0) {
+	    if (errno == EINTR)
+		continue;
+	    failed = true;
+	    return;
+	}
+	p += n;
+	left -= n;
+    }
+}
+
+// the slow path of write: the bytes do not fit in what is left of buf
+void AsmWriter::write_long(const char *s, size_t len)
+{
+    while (len > 0) {
+	if (cur == limit)
+	    drain();
+	size_t n = limit - cur;
+	if (n > len)
+	    n = len;
+	memcpy(cur, s, n);
+	cur += n;
+	s += n;
+	len -= n;
+    }
+}
+
+void AsmWriter::flush()
+{
+    drain();
+    if (fd < 0 && !failed)
+	stream->flush();
+}
@@ -26,10 +26,13 @@
 #include "list"
 #include <algorithm>
 
-extern void emit_string_constant(ostream& str, char* s);
+extern void emit_string_constant(AsmWriter& str, char* s);
 extern int cgen_debug;
+extern int cgen_optimize;
+extern bool disable_reg_alloc;
 
 int stackDepth = 0; // stack depth
+int loopDepth = 0;  // loops around the code being generated
 int labelTag = 0;
 
 //
@@ -98,7 +101,7 @@ BoolConst truebool(TRUE);
 // Define method for code generation
 //
 // This is the method called by the compiler driver
-// `cgtest.cc'. cgen takes an `ostream' to which the assembly will be
+// `cgtest.cc'. cgen takes an `AsmWriter' to which the assembly will be
 // emmitted, and it passes this and the class list of the
 // code generator tree to the constructor for `CgenClassTable'.
 // That constructor performs all of the work of the code
@@ -106,12 +109,17 @@ BoolConst truebool(TRUE);
 //
 //*********************************************************
 
-void program_class::cgen(ostream& os) {
+void program_class::cgen(AsmWriter& os) {
     // spim wants comments to start with '#'
     os << "# start of generated code\n";
 
     initialize_constants();
     CgenClassTable* codegen_classtable = new CgenClassTable(classes, os);
+    if (cgen_optimize && cgen_debug) {
+        peephole_report(cerr);
+        if (!disable_reg_alloc)
+            regalloc_report(cerr);
+    }
 
     os << "\n# end of generated code\n";
 }
@@ -120,187 +128,246 @@ void program_class::cgen(ostream& os) {
 //
 //  emit_* procedures
 //
-//  emit_X  writes code for operation "X" to the output stream.
-//  There is an emit_X for each opcode X, as well as emit_ functions
-//  for generating names according to the naming conventions (see emit.h)
-//  and calls to support functions defined in the trap handler.
+//  emit_X  appends an instruction for operation "X" to the routine being
+//  generated (see cgen_ir.h).  There is an emit_X for each opcode X, as
+//  well as emit_ functions for generating names according to the naming
+//  conventions (see emit.h) and calls to support functions defined in the
+//  trap handler.
 //
 //  Register names and addresses are passed as strings.  See `emit.h'
 //  for symbolic names you can use to refer to the strings.
 //
 //////////////////////////////////////////////////////////////////////////////
 
+static Instr reg_instr(Opcode op, char* dest, char* src1, char* src2) {
+    Instr i(op);
+    i.rd = ir_reg(dest);
+    i.rs = ir_reg(src1);
+    if (src2 != NULL)
+        i.rt = ir_reg(src2);
+    return i;
+}
+
+static Instr imm_instr(Opcode op, char* dest, char* src1, int imm) {
+    Instr i(op);
+    if (dest != NULL)
+        i.rd = ir_reg(dest);
+    if (src1 != NULL)
+        i.rs = ir_reg(src1);
+    i.imm = imm;
+    return i;
+}
+
 static void emit_load(char* dest_reg, int offset, char* source_reg,
-                      ostream& s) {
-    s << LW << dest_reg << " " << offset * WORD_SIZE << "(" << source_reg << ")"
-      << endl;
+                      InstrList& s) {
+    s.append(imm_instr(OP_LW, dest_reg, source_reg, offset * WORD_SIZE));
 }
 
 static void emit_store(char* source_reg, int offset, char* dest_reg,
-                       ostream& s) {
-    s << SW << source_reg << " " << offset * WORD_SIZE << "(" << dest_reg << ")"
-      << endl;
+                       InstrList& s) {
+    s.append(imm_instr(OP_SW, source_reg, dest_reg, offset * WORD_SIZE));
 }
 
-static void emit_load_imm(char* dest_reg, int val, ostream& s) {
-    s << LI << dest_reg << " " << val << endl;
+static void emit_load_imm(char* dest_reg, int val, InstrList& s) {
+    s.append(imm_instr(OP_LI, dest_reg, NULL, val));
 }
 
-static void emit_load_address(char* dest_reg, char* address, ostream& s) {
-    s << LA << dest_reg << " " << address << endl;
+static void emit_load_address(char* dest_reg, const Address& address,
+                              InstrList& s) {
+    Instr i(OP_LA);
+    i.rd = ir_reg(dest_reg);
+    i.addr = address;
+    s.append(i);
 }
 
-static void emit_partial_load_address(char* dest_reg, ostream& s) {
-    s << LA << dest_reg << " ";
+static void emit_load_bool(char* dest, const BoolConst& b, InstrList& s) {
+    emit_load_address(dest, b.address(), s);
 }
 
-static void emit_load_bool(char* dest, const BoolConst& b, ostream& s) {
-    emit_partial_load_address(dest, s);
-    b.code_ref(s);
-    s << endl;
+static void emit_load_string(char* dest, StringEntry* str, InstrList& s) {
+    emit_load_address(dest, Address(ADDR_STRCONST, str->get_index()), s);
 }
 
-static void emit_load_string(char* dest, StringEntry* str, ostream& s) {
-    emit_partial_load_address(dest, s);
-    str->code_ref(s);
-    s << endl;
+static void emit_load_int(char* dest, IntEntry* i, InstrList& s) {
+    emit_load_address(dest, Address(ADDR_INTCONST, i->get_index()), s);
 }
 
-static void emit_load_int(char* dest, IntEntry* i, ostream& s) {
-    emit_partial_load_address(dest, s);
-    i->code_ref(s);
-    s << endl;
+static void emit_move(char* dest_reg, char* source_reg, InstrList& s) {
+    s.append(reg_instr(OP_MOVE, dest_reg, source_reg, NULL));
 }
 
-static void emit_move(char* dest_reg, char* source_reg, ostream& s) {
-    s << MOVE << dest_reg << " " << source_reg << endl;
+//
+// Copy to or from a virtual register, which register allocation turns
+// into a register or a frame slot.
+//
+static void emit_move_to(Reg vreg, char* source_reg, InstrList& s) {
+    Instr i(OP_MOVE);
+    i.rd = vreg;
+    i.rs = ir_reg(source_reg);
+    s.append(i);
 }
 
-static void emit_neg(char* dest, char* src1, ostream& s) {
-    s << NEG << dest << " " << src1 << endl;
+static void emit_move_from(char* dest_reg, Reg vreg, InstrList& s) {
+    Instr i(OP_MOVE);
+    i.rd = ir_reg(dest_reg);
+    i.rs = vreg;
+    s.append(i);
 }
 
-static void emit_add(char* dest, char* src1, char* src2, ostream& s) {
-    s << ADD << dest << " " << src1 << " " << src2 << endl;
+//
+// ACC = rs op rt, for the operators on raw values, whose operands may
+// be virtual registers.
+//
+static void emit_raw_op(Opcode op, Reg rs, Reg rt, InstrList& s) {
+    Instr i(op);
+    i.rd = R_ACC;
+    i.rs = rs;
+    i.rt = rt;
+    s.append(i);
 }
 
-static void emit_addu(char* dest, char* src1, char* src2, ostream& s) {
-    s << ADDU << dest << " " << src1 << " " << src2 << endl;
+static void emit_neg(char* dest, char* src1, InstrList& s) {
+    s.append(reg_instr(OP_NEG, dest, src1, NULL));
 }
 
-static void emit_addiu(char* dest, char* src1, int imm, ostream& s) {
-    s << ADDIU << dest << " " << src1 << " " << imm << endl;
+static void emit_add(char* dest, char* src1, char* src2, InstrList& s) {
+    s.append(reg_instr(OP_ADD, dest, src1, src2));
 }
 
-static void emit_div(char* dest, char* src1, char* src2, ostream& s) {
-    s << DIV << dest << " " << src1 << " " << src2 << endl;
+static void emit_addu(char* dest, char* src1, char* src2, InstrList& s) {
+    s.append(reg_instr(OP_ADDU, dest, src1, src2));
 }
 
-static void emit_mul(char* dest, char* src1, char* src2, ostream& s) {
-    s << MUL << dest << " " << src1 << " " << src2 << endl;
+static void emit_addiu(char* dest, char* src1, int imm, InstrList& s) {
+    s.append(imm_instr(OP_ADDIU, dest, src1, imm));
 }
 
-static void emit_sub(char* dest, char* src1, char* src2, ostream& s) {
-    s << SUB << dest << " " << src1 << " " << src2 << endl;
+static void emit_div(char* dest, char* src1, char* src2, InstrList& s) {
+    s.append(reg_instr(OP_DIV, dest, src1, src2));
 }
 
-static void emit_sll(char* dest, char* src1, int num, ostream& s) {
-    s << SLL << dest << " " << src1 << " " << num << endl;
+static void emit_mul(char* dest, char* src1, char* src2, InstrList& s) {
+    s.append(reg_instr(OP_MUL, dest, src1, src2));
 }
 
-static void emit_jalr(char* dest, ostream& s) {
-    s << JALR << "\t" << dest << endl;
+static void emit_sub(char* dest, char* src1, char* src2, InstrList& s) {
+    s.append(reg_instr(OP_SUB, dest, src1, src2));
 }
 
-static void emit_jal(char* address, ostream& s) { s << JAL << address << endl; }
+static void emit_sll(char* dest, char* src1, int num, InstrList& s) {
+    s.append(imm_instr(OP_SLL, dest, src1, num));
+}
 
-static void emit_return(ostream& s) { s << RET << endl; }
+static void emit_xori(char* dest, char* src1, int imm, InstrList& s) {
+    s.append(imm_instr(OP_XORI, dest, src1, imm));
+}
 
-static void emit_gc_assign(ostream& s) { s << JAL << "_GenGC_Assign" << endl; }
+static void emit_ori(char* dest, char* src1, int imm, InstrList& s) {
+    s.append(imm_instr(OP_ORI, dest, src1, imm));
+}
 
-static void emit_disptable_ref(Symbol sym, ostream& s) {
-    s << sym << DISPTAB_SUFFIX;
+static void emit_jalr(char* dest, InstrList& s) {
+    s.append(imm_instr(OP_JALR, NULL, dest, 0));
 }
 
-static void emit_init_ref(Symbol sym, ostream& s) {
-    s << sym << CLASSINIT_SUFFIX;
+static void emit_jal(const Address& address, InstrList& s) {
+    Instr i(OP_JAL);
+    i.addr = address;
+    s.append(i);
 }
 
-static void emit_label_ref(int l, ostream& s) { s << "label" << l; }
+static void emit_return(InstrList& s) { s.append(Instr(OP_RET)); }
 
-static void emit_protobj_ref(Symbol sym, ostream& s) {
+//
+// Store ACC into attribute slot `slot' of self.  Only the generational
+// collector keeps a record of the assignments.  _GenGC_Assign takes the
+// record off the top of the heap, so under the other collectors each
+// call lowers the heap limit for good, and once the stores have used
+// up the room left it calls _GenGC_Collect, which was never set up.
+//
+static void emit_store_attr(int slot, InstrList& s) {
+    emit_store(ACC, slot, SELF, s);
+    if (cgen_Memmgr == GC_GENGC) {
+        emit_addiu(A1, SELF, WORD_SIZE * slot, s);
+        emit_jal("_GenGC_Assign", s);
+    }
+}
+
+static void emit_init_ref(Symbol sym, AsmWriter& s) {
+    s << sym << CLASSINIT_SUFFIX;
+}
+
+static void emit_protobj_ref(Symbol sym, AsmWriter& s) {
     s << sym << PROTOBJ_SUFFIX;
 }
 
-static void emit_method_ref(Symbol classname, Symbol methodname, ostream& s) {
+static void emit_method_ref(Symbol classname, Symbol methodname, AsmWriter& s) {
     s << classname << METHOD_SEP << methodname;
 }
 
-static void emit_jal_method(Symbol classname, Symbol methodname, ostream& s) {
-    s << JAL << classname << METHOD_SEP << methodname << endl;
+static void emit_jal_method(Symbol classname, Symbol methodname, InstrList& s) {
+    emit_jal(Address(ADDR_METHOD, classname, methodname), s);
+}
+
+static void emit_jal_init(Symbol sym, InstrList& s) {
+    emit_jal(Address(ADDR_INIT, sym), s);
 }
 
-static void emit_jal_init(Symbol sym, ostream& s) {
-    s << JAL << sym << CLASSINIT_SUFFIX << endl;
+static void emit_label_def(int l, InstrList& s) {
+    Instr i(OP_LABEL);
+    i.label = l;
+    s.append(i);
 }
 
-static void emit_label_def(int l, ostream& s) {
-    emit_label_ref(l, s);
-    s << ":" << endl;
+static void emit_branch_instr(Opcode op, char* src1, char* src2, int imm,
+                              int label, InstrList& s) {
+    Instr i(op);
+    i.rs = ir_reg(src1);
+    if (src2 != NULL)
+        i.rt = ir_reg(src2);
+    i.imm = imm;
+    i.label = label;
+    s.append(i);
 }
 
-static void emit_beqz(char* source, int label, ostream& s) {
-    s << BEQZ << source << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_beqz(char* source, int label, InstrList& s) {
+    emit_branch_instr(OP_BEQZ, source, NULL, 0, label, s);
 }
 
-static void emit_beq(char* src1, char* src2, int label, ostream& s) {
-    s << BEQ << src1 << " " << src2 << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_beq(char* src1, char* src2, int label, InstrList& s) {
+    emit_branch_instr(OP_BEQ, src1, src2, 0, label, s);
 }
 
-static void emit_bne(char* src1, char* src2, int label, ostream& s) {
-    s << BNE << src1 << " " << src2 << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_bne(char* src1, char* src2, int label, InstrList& s) {
+    emit_branch_instr(OP_BNE, src1, src2, 0, label, s);
 }
 
-static void emit_bleq(char* src1, char* src2, int label, ostream& s) {
-    s << BLEQ << src1 << " " << src2 << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_bleq(char* src1, char* src2, int label, InstrList& s) {
+    emit_branch_instr(OP_BLE, src1, src2, 0, label, s);
 }
 
-static void emit_blt(char* src1, char* src2, int label, ostream& s) {
-    s << BLT << src1 << " " << src2 << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_blt(char* src1, char* src2, int label, InstrList& s) {
+    emit_branch_instr(OP_BLT, src1, src2, 0, label, s);
 }
 
-static void emit_blti(char* src1, int imm, int label, ostream& s) {
-    s << BLT << src1 << " " << imm << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_blti(char* src1, int imm, int label, InstrList& s) {
+    emit_branch_instr(OP_BLTI, src1, NULL, imm, label, s);
 }
 
-static void emit_bgti(char* src1, int imm, int label, ostream& s) {
-    s << BGT << src1 << " " << imm << " ";
-    emit_label_ref(label, s);
-    s << endl;
+static void emit_bgti(char* src1, int imm, int label, InstrList& s) {
+    emit_branch_instr(OP_BGTI, src1, NULL, imm, label, s);
 }
 
-static void emit_branch(int l, ostream& s) {
-    s << BRANCH;
-    emit_label_ref(l, s);
-    s << endl;
+static void emit_branch(int l, InstrList& s) {
+    Instr i(OP_B);
+    i.label = l;
+    s.append(i);
 }
 
 //
 // Push a register on the stack. The stack grows towards smaller addresses.
 //
-static void emit_push(char* reg, ostream& str) {
+static void emit_push(char* reg, InstrList& str) {
     emit_store(reg, 0, SP, str);
     emit_addiu(SP, SP, -4, str);
 }
@@ -310,7 +377,7 @@ static void emit_push(char* reg, ostream& str) {
 // Emits code to fetch the integer value of the Integer object pointed
 // to by register source into the register dest
 //
-static void emit_fetch_int(char* dest, char* source, ostream& s) {
+static void emit_fetch_int(char* dest, char* source, InstrList& s) {
     emit_load(dest, DEFAULT_OBJFIELDS, source, s);
 }
 
@@ -318,23 +385,85 @@ static void emit_fetch_int(char* dest, char* source, ostream& s) {
 // Emits code to store the integer value contained in register source
 // into the Integer object pointed to by dest.
 //
-static void emit_store_int(char* source, char* dest, ostream& s) {
+static void emit_store_int(char* source, char* dest, InstrList& s) {
     emit_store(source, DEFAULT_OBJFIELDS, dest, s);
 }
 
-static void emit_test_collector(ostream& s) {
+static void emit_test_collector(InstrList& s) {
     emit_push(ACC, s);
     emit_move(ACC, SP, s);  // stack end
     emit_move(A1, ZERO, s); // allocate nothing
-    s << JAL << gc_collect_names[cgen_Memmgr] << endl;
+    emit_jal(gc_collect_names[cgen_Memmgr], s);
     emit_addiu(SP, SP, 4, s);
     emit_load(ACC, 0, SP, s);
 }
 
-static void emit_gc_check(char* source, ostream& s) {
+static void emit_gc_check(char* source, InstrList& s) {
     if (source != (char*)A1)
         emit_move(A1, source, s);
-    s << JAL << "_gc_check" << endl;
+    emit_jal("_gc_check", s);
+}
+
+//
+// Generate the Int or Bool expression e, whose environment is set,
+// from its raw value.  A Bool is one of the two constants.  An Int is
+// allocated first and kept on the stack while e is generated, as the
+// raw value must not be on the stack across Object.copy.
+//
+static void code_boxed(Expression e, InstrList& s) {
+    if (e->type == Bool) {
+        e->code_unboxed(s);
+        emit_move(T1, ACC, s);
+        emit_load_bool(ACC, truebool, s);
+        emit_bne(T1, ZERO, labelTag, s);
+        emit_load_bool(ACC, falsebool, s);
+        emit_label_def(labelTag++, s);
+        return;
+    }
+    emit_load_address(ACC, Address(ADDR_PROTOBJ, Int), s);
+    emit_jal_method(Object, COPY, s);
+    emit_push(ACC, s);
+    stackDepth++;
+    e->code_unboxed(s);
+    emit_load(T1, 1, SP, s);
+    emit_store_int(ACC, T1, s);
+    emit_move(ACC, T1, s);
+    emit_addiu(SP, SP, 4, s);
+    stackDepth--;
+}
+
+//
+// Push the raw value in ACC of an expression of the given type, and
+// then load it into T1 and pop it, using T2.  A Bool is 0 or 1, which
+// the collector never takes for a pointer, but an Int can be any word,
+// so it goes on the stack as two words that cannot be heap addresses:
+// ACC | 1, which is odd, and the 0 or 1 to take off it again.
+//
+static void emit_push_raw(Symbol type, InstrList& s) {
+    if (type != Int) {
+        emit_push(ACC, s);
+        stackDepth++;
+        return;
+    }
+    emit_ori(T1, ACC, 1, s);
+    emit_push(T1, s);
+    emit_sub(T1, T1, ACC, s);
+    emit_push(T1, s);
+    stackDepth += 2;
+}
+
+static void emit_pop_raw(Symbol type, InstrList& s) {
+    if (type != Int) {
+        emit_load(T1, 1, SP, s);
+        emit_addiu(SP, SP, 4, s);
+        stackDepth--;
+        return;
+    }
+    emit_load(T1, 2, SP, s);
+    emit_load(T2, 1, SP, s);
+    emit_sub(T1, T1, T2, s);
+    emit_addiu(SP, SP, 8, s);
+    stackDepth -= 2;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -361,14 +490,14 @@ static void emit_gc_check(char* source, ostream& s) {
 //
 // Strings
 //
-void StringEntry::code_ref(ostream& s) { s << STRCONST_PREFIX << index; }
+void StringEntry::code_ref(AsmWriter& s) { s << STRCONST_PREFIX << index; }
 
 //
 // Emit code for a constant String.
 // You should fill in the code naming the dispatch table.
 //
 
-void StringEntry::code_def(ostream& s, int stringclasstag) {
+void StringEntry::code_def(AsmWriter& s, int stringclasstag) {
     IntEntryP lensym = inttable.add_int(len);
 
     // Add -1 eye catcher
@@ -396,7 +525,7 @@ void StringEntry::code_def(ostream& s, int stringclasstag) {
 // Generate a string object definition for every string constant in the
 // stringtable.
 //
-void StrTable::code_string_table(ostream& s, int stringclasstag) {
+void StrTable::code_string_table(AsmWriter& s, int stringclasstag) {
     for (List<StringEntry>* l = tbl; l; l = l->tl()) {
         l->hd()->code_def(s, stringclasstag);
     }
@@ -405,14 +534,14 @@ void StrTable::code_string_table(ostream& s, int stringclasstag) {
 //
 // Ints
 //
-void IntEntry::code_ref(ostream& s) { s << INTCONST_PREFIX << index; }
+void IntEntry::code_ref(AsmWriter& s) { s << INTCONST_PREFIX << index; }
 
 //
 // Emit code for a constant Integer.
 // You should fill in the code naming the dispatch table.
 //
 
-void IntEntry::code_def(ostream& s, int intclasstag) {
+void IntEntry::code_def(AsmWriter& s, int intclasstag) {
     // Add -1 eye catcher
     s << WORD << "-1" << endl;
 
@@ -433,7 +562,7 @@ void IntEntry::code_def(ostream& s, int intclasstag) {
 // Generate an Int object definition for every Int constant in the
 // inttable.
 //
-void IntTable::code_string_table(ostream& s, int intclasstag) {
+void IntTable::code_string_table(AsmWriter& s, int intclasstag) {
     for (List<IntEntry>* l = tbl; l; l = l->tl())
         l->hd()->code_def(s, intclasstag);
 }
@@ -443,14 +572,14 @@ void IntTable::code_string_table(ostream& s, int intclasstag) {
 //
 BoolConst::BoolConst(int i) : val(i) { assert(i == 0 || i == 1); }
 
-void BoolConst::code_ref(ostream& s) const { s << BOOLCONST_PREFIX << val; }
+void BoolConst::code_ref(AsmWriter& s) const { s << BOOLCONST_PREFIX << val; }
 
 //
 // Emit code for a constant Bool.
 // You should fill in the code naming the dispatch table.
 //
 
-void BoolConst::code_def(ostream& s, int boolclasstag) {
+void BoolConst::code_def(AsmWriter& s, int boolclasstag) {
     // Add -1 eye catcher
     s << WORD << "-1" << endl;
 
@@ -588,7 +717,7 @@ void CgenClassTable::code_constants() {
     code_bools(boolclasstag);
 }
 
-CgenClassTable::CgenClassTable(Classes classes, ostream& s)
+CgenClassTable::CgenClassTable(Classes classes, AsmWriter& s)
     : nds(NULL), str(s) {
 
     enterscope();
@@ -928,30 +1057,42 @@ void CgenClassTable::code_prot_objs() {
     }
 }
 
+// whether let variables and operator temporaries go in virtual
+// registers (-O, unless -r)
+static bool allocating_registers() {
+    return cgen_optimize && !disable_reg_alloc;
+}
+
 /**
  * @brief generate codes when enter a function
  *
  * @param s output stream
+ * @param frame what register allocation added to the frame
  */
-static void code_func_prefix(ostream& s) {
-    emit_addiu(SP, SP, -12, s);
-    emit_store(FP, 3, SP, s);
-    emit_store(SELF, 2, SP, s);
-    emit_store(RA, 1, SP, s);
-    emit_addiu(FP, SP, 4, s);
+static void code_func_prefix(InstrList& s, const Frame& frame) {
+    int extra = frame.words();
+    emit_addiu(SP, SP, -12 - WORD_SIZE * extra, s);
+    emit_store(FP, 3 + extra, SP, s);
+    emit_store(SELF, 2 + extra, SP, s);
+    emit_store(RA, 1 + extra, SP, s);
+    emit_addiu(FP, SP, 4 + WORD_SIZE * extra, s);
     emit_move(SELF, ACC, s);
+    frame.enter(s);
 }
 
 /**
  * @brief generate codes when exit a function
  *
  * @param s output stream
+ * @param frame what register allocation added to the frame
  */
-static void code_func_suffix(ostream& s) {
-    emit_load(FP, 3, SP, s);
-    emit_load(SELF, 2, SP, s);
-    emit_load(RA, 1, SP, s);
-    emit_addiu(SP, SP, 12, s);
+static void code_func_suffix(InstrList& s, const Frame& frame) {
+    int extra = frame.words();
+    frame.leave(s);
+    emit_load(FP, 3 + extra, SP, s);
+    emit_load(SELF, 2 + extra, SP, s);
+    emit_load(RA, 1 + extra, SP, s);
+    emit_addiu(SP, SP, 12 + WORD_SIZE * extra, s);
 }
 
 template <typename W, typename T> std::list<T> get_values(std::map<W, T> map_) {
@@ -962,14 +1103,50 @@ template <typename W, typename T> std::list<T> get_values(std::map<W, T> map_) {
     return ret;
 }
 
-static void generate_new_class(ostream& s, Symbol type_name) {
-    emit_partial_load_address(ACC, s);
-    emit_protobj_ref(type_name, s);
-    s << endl;
+static void generate_new_class(InstrList& s, Symbol type_name) {
+    emit_load_address(ACC, Address(ADDR_PROTOBJ, type_name), s);
     emit_jal_method(Object, COPY, s);
-    s << JAL << "\t";
-    emit_init_ref(type_name, s);
-    s << endl;
+    Instr init(OP_JAL);
+    init.addr = Address(ADDR_INIT, type_name);
+    init.pad = true;
+    s.append(init);
+}
+
+/**
+ * @brief wrap a routine body in its frame and write it out
+ *
+ * Under -O the virtual registers of the body are allocated first, and
+ * the whole routine goes through the peephole pass at the end.
+ *
+ * @param entry the routine's label
+ * @param body the code between entering and leaving the frame
+ * @param nargs the number of arguments to pop on return
+ * @param s output stream
+ */
+static void write_routine(const Address& entry, InstrList& body, int nargs,
+                          AsmWriter& s) {
+    Frame frame;
+    if (allocating_registers())
+        body.allocate_registers(frame);
+
+    InstrList code;
+    code.start(entry);
+    code_func_prefix(code, frame);
+    code.append(body);
+    code_func_suffix(code, frame);
+    if (nargs > 0) {
+        emit_addiu(SP, SP, WORD_SIZE * nargs, code); // pop argument
+    }
+    emit_return(code);
+    if (cgen_optimize)
+        code.peephole();
+    if (cgen_debug) {
+        std::vector<Block> blocks;
+        code.blocks(blocks);
+        cout << "# " << code.size() << " instructions in " << blocks.size()
+             << " blocks" << endl;
+    }
+    code.print(s);
 }
 
 /**
@@ -977,15 +1154,13 @@ static void generate_new_class(ostream& s, Symbol type_name) {
  *
  */
 void CgenClassTable::code_init() {
+    InstrList code;
     for (auto i = nds; i; i = i->tail) {
         CgenNodeP node = i->hd();
-        str << node->name << CLASSINIT_SUFFIX << LABEL;
-        code_func_prefix(str);
+        code.start(Address(ADDR_INIT, node->name));
 
         if (node->parent != No_class) { // parent init
-            char* parentName = strdup(node->parent->get_string());
-            parentName = strcat(parentName, CLASSINIT_SUFFIX);
-            emit_jal(parentName, str);
+            emit_jal_init(node->parent, code);
         }
 
         /*attribute initialization */
@@ -998,24 +1173,19 @@ void CgenClassTable::code_init() {
                     Expression init = attr->init;
                     init->localEnv = node->localEnv;
                     init->classTable = (SymbolTable<Symbol, Class__class>*)this;
-                    str << "# init attr " << attr->name << endl;
-                    init->code(str);
+                    code.comment("# init attr ", attr->name);
+                    init->code(code);
                     if (init->type != No_type) {
-                        emit_store(ACC,
-                                   node->get_attrtag(attr->name) +
-                                       DEFAULT_OBJFIELDS,
-                                   SELF, str);
-                        emit_addiu(A1, SELF, WORD_SIZE * (node->get_attrtag(attr->name) +
-                                       DEFAULT_OBJFIELDS), str);
-                        emit_jal("_GenGC_Assign", str);
+                        emit_store_attr(node->get_attrtag(attr->name) +
+                                            DEFAULT_OBJFIELDS,
+                                        code);
                     }
                 }
             }
         }
 
-        emit_move(ACC, SELF, str);
-        code_func_suffix(str);
-        emit_return(str);
+        emit_move(ACC, SELF, code);
+        write_routine(Address(ADDR_INIT, node->name), code, 0, str);
     }
 }
 
@@ -1074,12 +1244,13 @@ int CgenNode::set_info(int classtag, std::list<Symbol>& tagList,
     }
     if (attrTable == NULL) {
         attrTable = new std::list<attr_class*>();
+        attrIndex = new std::map<Symbol, int>();
     }
     unsigned int methodTag = methodTable->size();
     for (size_t i = features->first(); features->more(i);
          i = features->next(i)) {
         Feature feature = features->nth(i);
-        if (feature->feature_type == methodFeature) {
+        if (feature->get_kind() == AST_method) {
             ((method_class*)feature)->className = name;
             Symbol methodName = ((method_class*)feature)->name;
             if (methodTable->find(methodName) != methodTable->end()) {
@@ -1089,8 +1260,10 @@ int CgenNode::set_info(int classtag, std::list<Symbol>& tagList,
                 ((method_class*)feature)->methodTag = methodTag++;
             }
             (*methodTable)[methodName] = (method_class*)feature;
-        } else if (feature->feature_type == attrFeature) {
+        } else if (feature->get_kind() == AST_attr) {
             ((attr_class*)feature)->className = name;
+            attrIndex->insert(std::make_pair(((attr_class*)feature)->name,
+                                             (int)attrTable->size()));
             attrTable->push_back((attr_class*)feature);
         }
     }
@@ -1101,6 +1274,7 @@ int CgenNode::set_info(int classtag, std::list<Symbol>& tagList,
             child->methodTable =
                 new std::map<Symbol, method_class*>(*methodTable);
             child->attrTable = new std::list<attr_class*>(*attrTable);
+            child->attrIndex = new std::map<Symbol, int>(*attrIndex);
             classtag = child->set_info(classtag, tagList, classTable);
         }
     }
@@ -1114,12 +1288,8 @@ int CgenNode::set_info(int classtag, std::list<Symbol>& tagList,
  * @return int
  */
 int CgenNode::get_attrtag(Symbol attrName) {
-    for (auto it = attrTable->begin(); it != attrTable->end(); ++it) {
-        if ((*it)->name == attrName) {
-            return std::distance(attrTable->begin(), it);
-        }
-    }
-    return -1;
+    auto it = attrIndex->find(attrName);
+    return it == attrIndex->end() ? -1 : it->second;
 }
 
 /**
@@ -1156,7 +1326,7 @@ static bool isBasicMethod(Symbol methodName) {
  * @brief generate code for every methods
  *
  */
-void CgenNode::code_methods(ostream& str, CgenClassTableP classTable) {
+void CgenNode::code_methods(AsmWriter& str, CgenClassTableP classTable) {
     unsigned int method_num = methodTable->size();
     method_class* methodDispTable[method_num];
     get_method_disp_table(methodDispTable);
@@ -1181,6 +1351,230 @@ void CgenNode::code_methods(ostream& str, CgenClassTableP classTable) {
 //
 //*****************************************************************
 
+//
+// Unboxed Int and Bool values (-O)
+//
+// code_unboxed leaves the raw value of an Int or Bool expression in
+// ACC: the integer, or 0 and 1 for false and true.  Arithmetic,
+// comparisons, the predicates of conditionals and loops, and the
+// let variables chosen in cgen_unbox.cc work on raw values, and a
+// value is boxed only where an object is needed.
+//
+// The generational collector (-g) takes every even word on the stack
+// and in $s0-$s6 that points into the heap for an object, and moves
+// it or stops with a bad eyecatcher.  So a raw Int must never be
+// there, as it is, when a call can collect:
+//
+//   - an Int is boxed by allocating the object before the value is
+//     generated (code_boxed), not by keeping the value across
+//     Object.copy;
+//   - the left operand of an operator is pushed as two words that
+//     cannot be addresses (emit_push_raw);
+//   - a raw Int let variable lives in a virtual register, never in a
+//     stack slot, and register allocation keeps it out of the
+//     collector's sight (see cgen_regalloc.cc).
+//
+// A raw Bool is 0 or 1, which is below the heap, and can go anywhere.
+//
+
+bool is_raw_type(Symbol type) { return type == Int || type == Bool; }
+
+// whether the boxed value of e is a newly allocated Int
+bool allocates_int(Expression e) {
+    switch (e->get_kind()) {
+    case AST_plus:
+    case AST_sub:
+    case AST_mul:
+    case AST_divide:
+    case AST_neg:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// the raw value of any Int or Bool expression: fetch it from the object
+void Expression_class::code_unboxed(InstrList& s) {
+    code(s);
+    emit_fetch_int(ACC, ACC, s);
+}
+
+//
+// Whether the unboxed code of e is no dearer than its boxed code, so
+// that it is the better way to generate e when its value is not used.
+// e's environment must be set.
+//
+static bool has_raw_code(Expression e) {
+    if (!is_raw_type(e->type))
+        return false;
+    switch (e->get_kind()) {
+    case AST_assign:
+        return e->localEnv->lookup(((assign_class*)e)->name)->unboxed;
+    case AST_cond:
+    case AST_block:
+    case AST_let:
+    case AST_plus:
+    case AST_sub:
+    case AST_mul:
+    case AST_divide:
+    case AST_neg:
+    case AST_lt:
+    case AST_eq:
+    case AST_leq:
+    case AST_comp:
+    case AST_int_const:
+    case AST_bool_const:
+    case AST_object:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief generate an expression whose value is thrown away
+ *
+ * @param e the expression, with its environment set
+ * @param s output stream
+ */
+static void code_discarded(Expression e, InstrList& s) {
+    if (cgen_optimize && has_raw_code(e))
+        e->code_unboxed(s);
+    else
+        e->code(s);
+}
+
+/**
+ * @brief generate the predicate of a conditional or loop
+ *
+ * @param pred the predicate, with its environment set
+ * @param s output stream
+ * @return the register that holds the raw Bool
+ */
+static char* code_pred(Expression pred, InstrList& s) {
+    if (cgen_optimize) {
+        pred->code_unboxed(s);
+        return ACC;
+    }
+    pred->code(s);
+    emit_load(T1, 3, ACC, s);
+    return T1;
+}
+
+// whether e can be generated without touching T1
+static bool leaves_t1(Expression e) {
+    NodeKind kind = e->get_kind();
+    return kind == AST_int_const || kind == AST_bool_const ||
+           kind == AST_object;
+}
+
+//
+// Whether the unboxed code of e makes no call.  A temporary held
+// across such code can stay in a caller-saved register; one held
+// across a call needs a callee-saved register, which pays for saving
+// and restoring it only when it is used in a loop.
+//
+static bool raw_code_calls_nothing(Expression e) {
+    switch (e->get_kind()) {
+    case AST_int_const:
+    case AST_bool_const:
+    case AST_object:
+        return true;
+    case AST_plus:
+        return raw_code_calls_nothing(((plus_class*)e)->e1) &&
+               raw_code_calls_nothing(((plus_class*)e)->e2);
+    case AST_sub:
+        return raw_code_calls_nothing(((sub_class*)e)->e1) &&
+               raw_code_calls_nothing(((sub_class*)e)->e2);
+    case AST_mul:
+        return raw_code_calls_nothing(((mul_class*)e)->e1) &&
+               raw_code_calls_nothing(((mul_class*)e)->e2);
+    case AST_divide:
+        return raw_code_calls_nothing(((divide_class*)e)->e1) &&
+               raw_code_calls_nothing(((divide_class*)e)->e2);
+    case AST_lt:
+        return raw_code_calls_nothing(((lt_class*)e)->e1) &&
+               raw_code_calls_nothing(((lt_class*)e)->e2);
+    case AST_leq:
+        return raw_code_calls_nothing(((leq_class*)e)->e1) &&
+               raw_code_calls_nothing(((leq_class*)e)->e2);
+    case AST_eq:
+        return is_raw_type(((eq_class*)e)->e1->type) &&
+               raw_code_calls_nothing(((eq_class*)e)->e1) &&
+               raw_code_calls_nothing(((eq_class*)e)->e2);
+    case AST_neg:
+        return raw_code_calls_nothing(((neg_class*)e)->e1);
+    case AST_comp:
+        return raw_code_calls_nothing(((comp_class*)e)->e1);
+    default:
+        return false;
+    }
+}
+
+// the virtual register of e, if e is an unboxed let variable kept in
+// one, or NO_REG.  e's environment must be set.
+static Reg raw_register(Expression e) {
+    if (e->get_kind() != AST_object || ((object_class*)e)->name == self)
+        return NO_REG;
+    VarInfo* info = e->localEnv->lookup(((object_class*)e)->name);
+    if (info->storePos != REGISTER || !info->unboxed)
+        return NO_REG;
+    return Reg(info->pos);
+}
+
+/**
+ * @brief generate the raw values of both operands of a binary operator
+ *
+ * The value of e1 ends up in T1 and the value of e2 in ACC.  Under
+ * register allocation an operand that is an unboxed let variable is
+ * used from its register instead, and so is the temporary that holds
+ * e1 while e2 is generated.
+ *
+ * @param op the operator, whose environment is passed on to e1 and e2
+ * @param r1 set to the register of e1
+ * @param r2 set to the register of e2
+ * @param s output stream
+ */
+static void code_raw_operands(Expression op, Expression e1, Expression e2,
+                              Reg& r1, Reg& r2, InstrList& s) {
+    e1->localEnv = op->localEnv;
+    e1->classTable = op->classTable;
+    e2->localEnv = op->localEnv;
+    e2->classTable = op->classTable;
+    r1 = raw_register(e1);
+    r2 = raw_register(e2);
+    // only e2 being simple guarantees that it does not assign to e1
+    if (r1 != NO_REG && leaves_t1(e2)) {
+        if (r2 == NO_REG) {
+            e2->code_unboxed(s);
+            r2 = R_ACC;
+        }
+        return;
+    }
+    e1->code_unboxed(s);
+    if (r2 != NO_REG) {
+        r1 = R_ACC;
+        return;
+    }
+    r1 = R_T1;
+    r2 = R_ACC;
+    if (leaves_t1(e2)) {
+        emit_move(T1, ACC, s);
+        e2->code_unboxed(s);
+        return;
+    }
+    if (allocating_registers() &&
+        (loopDepth > 0 || raw_code_calls_nothing(e2))) {
+        r1 = s.new_vreg(e1->type == Int);
+        emit_move_to(r1, ACC, s);
+        e2->code_unboxed(s);
+        return;
+    }
+    emit_push_raw(e1->type, s);
+    e2->code_unboxed(s);
+    emit_pop_raw(e1->type, s);
+}
+
 /**
  * @brief generate void dispatch check
  *
@@ -1188,7 +1582,7 @@ void CgenNode::code_methods(ostream& str, CgenClassTableP classTable) {
  * @param line_number
  * @param s
  */
-static void void_ref_check(int line_number, ostream& s) {
+static void void_ref_check(int line_number, InstrList& s) {
     emit_bne(ACC, ZERO, labelTag, s);
     emit_load_string(ACC, stringtable.lookup(0), s);
     emit_load_imm(T1, line_number, s);
@@ -1196,11 +1590,10 @@ static void void_ref_check(int line_number, ostream& s) {
     emit_label_def(labelTag++, s);
 }
 
-void method_class::code(ostream& str) {
+void method_class::code(AsmWriter& str) {
     localEnv->enterscope();
 
-    str << className << METHOD_SEP << name << LABEL;
-    code_func_prefix(str);
+    InstrList code;
     stackDepth = 0;
 
     for (int i = formals->first(); formals->more(i); i = formals->next(i)) {
@@ -1213,33 +1606,49 @@ void method_class::code(ostream& str) {
 
     expr->classTable = classTable;
     expr->localEnv = localEnv;
-    expr->code(str); // generate expr code
+    expr->code(code); // generate expr code
 
-    code_func_suffix(str);
-    if (formals->len() > 0) {
-        emit_addiu(SP, SP, WORD_SIZE * formals->len(), str); // pop argument
-    }
-    emit_return(str);
+    write_routine(Address(ADDR_METHOD, className, name), code, formals->len(),
+                  str);
 
     localEnv->exitscope();
 }
 
-void assign_class::code(ostream& s) {
+void assign_class::code(InstrList& s) {
     expr->localEnv = localEnv;
     expr->classTable = classTable;
-    expr->code(s);
     VarInfo* info = localEnv->lookup(name);
+    if (info->unboxed) {
+        code_boxed(this, s);
+        return;
+    }
+    expr->code(s);
     if (info->storePos == ATTRIBUTE) {
-        emit_store(ACC, DEFAULT_OBJFIELDS + info->pos, SELF, s);
-        emit_addiu(A1, SELF, WORD_SIZE * (DEFAULT_OBJFIELDS + info->pos), s);
-        emit_jal("_GenGC_Assign", s);
+        emit_store_attr(DEFAULT_OBJFIELDS + info->pos, s);
     } else if (info->storePos == STACK) {
         emit_store(ACC, info->pos, FP, s);
+    } else if (info->storePos == REGISTER) {
+        emit_move_to(Reg(info->pos), ACC, s);
     }
 }
 
-void static_dispatch_class::code(ostream& s) {
-    s << "# static dispatch " << name << endl;
+void assign_class::code_unboxed(InstrList& s) {
+    VarInfo* info = localEnv->lookup(name);
+    if (!info->unboxed) {
+        Expression_class::code_unboxed(s);
+        return;
+    }
+    expr->localEnv = localEnv;
+    expr->classTable = classTable;
+    expr->code_unboxed(s);
+    if (info->storePos == REGISTER)
+        emit_move_to(Reg(info->pos), ACC, s);
+    else
+        emit_store(ACC, info->pos, FP, s);
+}
+
+void static_dispatch_class::code(InstrList& s) {
+    s.comment("# static dispatch ", name);
     for (size_t i = actual->first(); actual->more(i); i = actual->next(i)) {
         Expression actualExpr = actual->nth(i);
         actualExpr->localEnv = localEnv;
@@ -1252,19 +1661,17 @@ void static_dispatch_class::code(ostream& s) {
     expr->classTable = classTable;
     expr->code(s);
     void_ref_check(line_number, s);
-    emit_partial_load_address(T1, s);
-    emit_disptable_ref(type_name, s);
-    s << endl;
+    emit_load_address(T1, Address(ADDR_DISPTAB, type_name), s);
     CgenNodeP node = (CgenNodeP)classTable->lookup(type_name);
     int methodTag = (*(node->methodTable))[name]->methodTag;
-    s << "# methodTag for " << name << endl;
+    s.comment("# methodTag for ", name);
     emit_load(T1, methodTag, T1, s);
     emit_jalr(T1, s);
     stackDepth = stackDepth - actual->len();
 }
 
-void dispatch_class::code(ostream& s) {
-    s << "# dispatch " << name << endl;
+void dispatch_class::code(InstrList& s) {
+    s.comment("# dispatch ", name);
     for (size_t i = actual->first(); actual->more(i); i = actual->next(i)) {
         Expression actualExpr = actual->nth(i);
         actualExpr->localEnv = localEnv;
@@ -1284,62 +1691,80 @@ void dispatch_class::code(ostream& s) {
     expr->code(s);
     void_ref_check(line_number, s);
     int methodTag = (*(node->methodTable))[name]->methodTag;
-    s << "# methodTag for " << node->name << METHOD_SEP << name << endl;
+    s.comment("# methodTag for ", node->name, name);
     emit_load(T1, 2, ACC, s);
     emit_load(T1, methodTag, T1, s);
     emit_jalr(T1, s);
     stackDepth = stackDepth - actual->len();
 }
 
-void cond_class::code(ostream& s) {
-    s << "# cond class" << endl;
+void cond_class::code(InstrList& s) { code_cond(s, false); }
+
+void cond_class::code_unboxed(InstrList& s) { code_cond(s, true); }
+
+/**
+ * @brief generate a conditional
+ *
+ * @param s output stream
+ * @param raw whether to leave the value unboxed
+ */
+void cond_class::code_cond(InstrList& s, bool raw) {
+    s.comment("# cond class");
     pred->localEnv = localEnv;
     pred->classTable = classTable;
-    pred->code(s);
-    emit_load(T1, 3, ACC, s);
+    char* test = code_pred(pred, s);
     int falseTag = labelTag++;
-    emit_beqz(T1, falseTag, s);
+    emit_beqz(test, falseTag, s);
     int nextTag = labelTag++;
     then_exp->localEnv = localEnv;
     then_exp->classTable = classTable;
-    then_exp->code(s);
+    if (raw)
+        then_exp->code_unboxed(s);
+    else
+        then_exp->code(s);
     emit_branch(nextTag, s);
     emit_label_def(falseTag, s);
     else_exp->localEnv = localEnv;
     else_exp->classTable = classTable;
-    else_exp->code(s);
+    if (raw)
+        else_exp->code_unboxed(s);
+    else
+        else_exp->code(s);
     emit_label_def(nextTag, s);
 }
 
-void loop_class::code(ostream& s) {
-    s << "# loop class" << endl;
+void loop_class::code(InstrList& s) {
+    s.comment("# loop class");
     pred->localEnv = localEnv;
     pred->classTable = classTable;
     int predTag = labelTag++;
     emit_label_def(predTag, s);
-    s << "#pred " << endl;
-    pred->code(s);
-    emit_load(T1, 3, ACC, s);
+    s.comment("#pred ");
+    loopDepth++;
+    char* test = code_pred(pred, s);
+    loopDepth--;
     int exitTag = labelTag++;
-    emit_beqz(T1, exitTag, s);
+    emit_beqz(test, exitTag, s);
     body->localEnv = localEnv;
     body->classTable = classTable;
-    s << "# body" << endl;
-    body->code(s);
+    s.comment("# body");
+    loopDepth++;
+    code_discarded(body, s);
+    loopDepth--;
     emit_branch(predTag, s);
     emit_label_def(exitTag, s);
     emit_move(ACC, ZERO, s);
 }
 
-static void void_case_check(int line_number, ostream& s) {
+static void void_case_check(int line_number, InstrList& s) {
     emit_bne(ACC, ZERO, labelTag, s);
     emit_load_string(ACC, stringtable.lookup(0), s);
     emit_load_imm(T1, line_number, s);
     emit_jal("_case_abort2", s);
 }
 
-void typcase_class::code(ostream& s) {
-    s << "#typcase class " << endl;
+void typcase_class::code(InstrList& s) {
+    s.comment("#typcase class ");
     expr->localEnv = localEnv;
     expr->classTable = classTable;
     expr->code(s);
@@ -1406,21 +1831,70 @@ void typcase_class::code(ostream& s) {
     stackDepth--;
 }
 
-void block_class::code(ostream& s) {
+void block_class::code(InstrList& s) {
     for (size_t i = 0; body->more(i); i = body->next(i)) {
         Expression expr = body->nth(i);
         expr->localEnv = localEnv;
         expr->classTable = classTable;
-        expr->code(s);
+        if (body->more(body->next(i)))
+            code_discarded(expr, s);
+        else
+            expr->code(s);
     }
 }
 
-void let_class::code(ostream& s) {
-    s << "# letexpr" << endl;
+void block_class::code_unboxed(InstrList& s) {
+    for (size_t i = 0; body->more(i); i = body->next(i)) {
+        Expression expr = body->nth(i);
+        expr->localEnv = localEnv;
+        expr->classTable = classTable;
+        if (body->more(body->next(i)))
+            code_discarded(expr, s);
+        else
+            expr->code_unboxed(s);
+    }
+}
+
+void let_class::code(InstrList& s) { code_let(s, false); }
+
+void let_class::code_unboxed(InstrList& s) { code_let(s, true); }
+
+/**
+ * @brief generate a let
+ *
+ * Unless -r is given, a variable under -O is kept in a register if
+ * it is used in a loop, whether the loop is around the let or in its
+ * body.  A Bool variable is always kept raw, and an Int variable in a
+ * register when boxing it where it is read costs no more than boxing
+ * the sums assigned to it (see cgen_unbox.cc).  A raw Int is never
+ * kept in a stack slot, where the collector would see it.
+ *
+ * @param s output stream
+ * @param raw whether to leave the value unboxed
+ */
+void let_class::code_let(InstrList& s, bool raw) {
+    s.comment("# letexpr");
+    bool unbox = false;
+    VarUses uses = {0, 0, allocates_int(init) ? 1 : 0};
+    if (cgen_optimize)
+        body->count_uses(identifier, uses, raw, 1);
+    // a use in a loop weighs at least 8
+    bool hot = loopDepth > 0 || uses.raw + uses.boxed >= 8;
+    bool in_register = allocating_registers() && hot;
+    if (cgen_optimize && is_raw_type(type_decl))
+        unbox = type_decl == Bool ||
+                (in_register && uses.boxed <= uses.allocs);
     init->localEnv = localEnv;
     init->classTable = classTable;
-    init->code(s);
-    if (init->type == No_type) {
+    if (unbox) {
+        if (init->get_kind() == AST_no_expr)
+            emit_load_imm(ACC, 0, s);
+        else
+            init->code_unboxed(s);
+    } else {
+        init->code(s);
+    }
+    if (!unbox && init->type == No_type) {
         if (type_decl == Str) {
             emit_load_string(ACC, stringtable.lookup_string(""), s);
         } else if (type_decl == Int) {
@@ -1443,23 +1917,40 @@ void let_class::code(ostream& s) {
             // }
         }
     }
-    emit_push(ACC, s);
-    stackDepth++;
-    // cout << stackDepth << endl;
     localEnv->enterscope();
     VarInfo* info = new VarInfo;
-    info->storePos = STACK;
-    info->pos = -stackDepth;
+    if (in_register) {
+        Reg var = s.new_vreg(unbox && type_decl == Int);
+        emit_move_to(var, ACC, s);
+        info->storePos = REGISTER;
+        info->pos = var;
+    } else {
+        emit_push(ACC, s);
+        stackDepth++;
+        // cout << stackDepth << endl;
+        info->storePos = STACK;
+        info->pos = -stackDepth;
+    }
+    info->unboxed = unbox;
     localEnv->addid(identifier, info);
     body->localEnv = localEnv;
     body->classTable = classTable;
-    body->code(s);
+    if (raw)
+        body->code_unboxed(s);
+    else
+        body->code(s);
     localEnv->exitscope();
-    emit_addiu(SP, SP, 4, s);
-    stackDepth--;
+    if (info->storePos == STACK) {
+        emit_addiu(SP, SP, 4, s);
+        stackDepth--;
+    }
 }
 
-void plus_class::code(ostream& s) {
+void plus_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1468,20 +1959,27 @@ void plus_class::code(ostream& s) {
     e2->localEnv = localEnv;
     e2->classTable = classTable;
     e2->code(s);
+    emit_jal_method(Object, COPY, s); // the result, a copy of e2
     emit_load(T1, 1, SP, s);
     emit_fetch_int(T1, T1, s);
     emit_fetch_int(T2, ACC, s);
     emit_add(T1, T1, T2, s);
-    emit_push(T1, s);
-    stackDepth++;
-    emit_jal_method(Object, COPY, s);
-    emit_load(T1, 1, SP, s);
     emit_store_int(T1, ACC, s);
-    emit_addiu(SP, SP, 8, s);
-    stackDepth -= 2;
+    emit_addiu(SP, SP, 4, s);
+    stackDepth--;
+}
+
+void plus_class::code_unboxed(InstrList& s) {
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_ADD, r1, r2, s);
 }
 
-void sub_class::code(ostream& s) {
+void sub_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1490,20 +1988,27 @@ void sub_class::code(ostream& s) {
     e2->localEnv = localEnv;
     e2->classTable = classTable;
     e2->code(s);
+    emit_jal_method(Object, COPY, s); // the result, a copy of e2
     emit_load(T1, 1, SP, s);
     emit_fetch_int(T1, T1, s);
     emit_fetch_int(T2, ACC, s);
     emit_sub(T1, T1, T2, s);
-    emit_push(T1, s);
-    stackDepth++;
-    emit_jal_method(Object, COPY, s);
-    emit_load(T1, 1, SP, s);
     emit_store_int(T1, ACC, s);
-    emit_addiu(SP, SP, 8, s);
-    stackDepth -= 2;
+    emit_addiu(SP, SP, 4, s);
+    stackDepth--;
+}
+
+void sub_class::code_unboxed(InstrList& s) {
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_SUB, r1, r2, s);
 }
 
-void mul_class::code(ostream& s) {
+void mul_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1512,20 +2017,27 @@ void mul_class::code(ostream& s) {
     e2->localEnv = localEnv;
     e2->classTable = classTable;
     e2->code(s);
+    emit_jal_method(Object, COPY, s); // the result, a copy of e2
     emit_load(T1, 1, SP, s);
     emit_fetch_int(T1, T1, s);
     emit_fetch_int(T2, ACC, s);
     emit_mul(T1, T1, T2, s);
-    emit_push(T1, s);
-    stackDepth++;
-    emit_jal_method(Object, COPY, s);
-    emit_load(T1, 1, SP, s);
     emit_store_int(T1, ACC, s);
-    emit_addiu(SP, SP, 8, s);
-    stackDepth -= 2;
+    emit_addiu(SP, SP, 4, s);
+    stackDepth--;
+}
+
+void mul_class::code_unboxed(InstrList& s) {
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_MUL, r1, r2, s);
 }
 
-void divide_class::code(ostream& s) {
+void divide_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1534,35 +2046,48 @@ void divide_class::code(ostream& s) {
     e2->localEnv = localEnv;
     e2->classTable = classTable;
     e2->code(s);
+    emit_jal_method(Object, COPY, s); // the result, a copy of e2
     emit_load(T1, 1, SP, s);
     emit_fetch_int(T1, T1, s);
     emit_fetch_int(T2, ACC, s);
     emit_div(T1, T1, T2, s);
-    emit_push(T1, s);
-    stackDepth++;
-    emit_jal_method(Object, COPY, s);
-    emit_load(T1, 1, SP, s);
     emit_store_int(T1, ACC, s);
-    emit_addiu(SP, SP, 8, s);
-    stackDepth -= 2;
+    emit_addiu(SP, SP, 4, s);
+    stackDepth--;
+}
+
+void divide_class::code_unboxed(InstrList& s) {
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_DIV, r1, r2, s);
 }
 
-void neg_class::code(ostream& s) {
+void neg_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
+    emit_jal_method(Object, COPY, s); // the result, a copy of e1
     emit_fetch_int(T1, ACC, s);
     emit_sub(T1, ZERO, T1, s);
-    emit_push(T1, s);
-    stackDepth++;
-    emit_jal_method(Object, COPY, s);
-    emit_load(T1, 1, SP, s);
     emit_store_int(T1, ACC, s);
-    emit_addiu(SP, SP, 4, s);
-    stackDepth--;
 }
 
-void lt_class::code(ostream& s) {
+void neg_class::code_unboxed(InstrList& s) {
+    e1->localEnv = localEnv;
+    e1->classTable = classTable;
+    e1->code_unboxed(s);
+    emit_sub(ACC, ZERO, ACC, s);
+}
+
+void lt_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1582,7 +2107,17 @@ void lt_class::code(ostream& s) {
     stackDepth--;
 }
 
-void eq_class::code(ostream& s) {
+void lt_class::code_unboxed(InstrList& s) {
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_SLT, r1, r2, s);
+}
+
+void eq_class::code(InstrList& s) {
+    if (cgen_optimize && is_raw_type(e1->type)) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1602,7 +2137,22 @@ void eq_class::code(ostream& s) {
     stackDepth--;
 }
 
-void leq_class::code(ostream& s) {
+void eq_class::code_unboxed(InstrList& s) {
+    // Ints and Bools are equal when their values are
+    if (!is_raw_type(e1->type)) {
+        Expression_class::code_unboxed(s);
+        return;
+    }
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_SEQ, r1, r2, s);
+}
+
+void leq_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1623,8 +2173,20 @@ void leq_class::code(ostream& s) {
     stackDepth--;
 }
 
-void comp_class::code(ostream& s) {
-    s << "# comp class" << endl;
+void leq_class::code_unboxed(InstrList& s) {
+    // e1 <= e2 is not e2 < e1
+    Reg r1, r2;
+    code_raw_operands(this, e1, e2, r1, r2, s);
+    emit_raw_op(OP_SLT, r2, r1, s);
+    emit_xori(ACC, ACC, 1, s);
+}
+
+void comp_class::code(InstrList& s) {
+    if (cgen_optimize) {
+        code_boxed(this, s);
+        return;
+    }
+    s.comment("# comp class");
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1635,22 +2197,37 @@ void comp_class::code(ostream& s) {
     emit_label_def(labelTag++, s);
 }
 
-void int_const_class::code(ostream& s) {
+void comp_class::code_unboxed(InstrList& s) {
+    e1->localEnv = localEnv;
+    e1->classTable = classTable;
+    e1->code_unboxed(s);
+    emit_xori(ACC, ACC, 1, s);
+}
+
+void int_const_class::code(InstrList& s) {
     //
     // Need to be sure we have an IntEntry *, not an arbitrary Symbol
     //
     emit_load_int(ACC, inttable.lookup_string(token->get_string()), s);
 }
 
-void string_const_class::code(ostream& s) {
+void int_const_class::code_unboxed(InstrList& s) {
+    emit_load_imm(ACC, (int)atoll(token->get_string()), s);
+}
+
+void string_const_class::code(InstrList& s) {
     emit_load_string(ACC, stringtable.lookup_string(token->get_string()), s);
 }
 
-void bool_const_class::code(ostream& s) {
+void bool_const_class::code(InstrList& s) {
     emit_load_bool(ACC, BoolConst(val), s);
 }
 
-void new__class::code(ostream& s) {
+void bool_const_class::code_unboxed(InstrList& s) {
+    emit_load_imm(ACC, val, s);
+}
+
+void new__class::code(InstrList& s) {
     if (type_name == SELF_TYPE) {
         emit_load(ACC, 0, SELF, s);
         emit_sll(ACC, ACC, 3, s);
@@ -1670,7 +2247,7 @@ void new__class::code(ostream& s) {
     }
 }
 
-void isvoid_class::code(ostream& s) {
+void isvoid_class::code(InstrList& s) {
     e1->localEnv = localEnv;
     e1->classTable = classTable;
     e1->code(s);
@@ -1682,17 +2259,33 @@ void isvoid_class::code(ostream& s) {
     labelTag++;
 }
 
-void no_expr_class::code(ostream& s) { type = No_type; }
+void no_expr_class::code(InstrList& s) { type = No_type; }
 
-void object_class::code(ostream& s) {
+void object_class::code(InstrList& s) {
     if (name == self) {
         emit_move(ACC, SELF, s);
     } else {
         VarInfo* info = localEnv->lookup(name);
-        if (info->storePos == ATTRIBUTE) {
+        if (info->unboxed) {
+            code_boxed(this, s);
+        } else if (info->storePos == ATTRIBUTE) {
             emit_load(ACC, info->pos + DEFAULT_OBJFIELDS, SELF, s);
         } else if (info->storePos == STACK) {
             emit_load(ACC, info->pos, FP, s);
+        } else if (info->storePos == REGISTER) {
+            emit_move_from(ACC, Reg(info->pos), s);
         }
     }
 }
+
+void object_class::code_unboxed(InstrList& s) {
+    if (name == self || !localEnv->lookup(name)->unboxed) {
+        Expression_class::code_unboxed(s);
+        return;
+    }
+    VarInfo* info = localEnv->lookup(name);
+    if (info->storePos == REGISTER)
+        emit_move_from(ACC, Reg(info->pos), s);
+    else
+        emit_load(ACC, info->pos, FP, s);
+}
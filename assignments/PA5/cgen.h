@@ -1,5 +1,7 @@
 #include "cool-tree.h"
 #include "emit.h"
+#include "asmwriter.h"
+#include "cgen_ir.h"
 #include "list"
 #include "map"
 #include "symtab.h"
@@ -19,7 +21,7 @@ typedef CgenNode* CgenNodeP;
 class CgenClassTable : public SymbolTable<Symbol, CgenNode> {
   private:
     List<CgenNode>* nds;
-    ostream& str;
+    AsmWriter& str;
 
     // The following methods emit code for
     // constants and global declarations.
@@ -55,7 +57,7 @@ class CgenClassTable : public SymbolTable<Symbol, CgenNode> {
     int boolclasstag;
 
   public:
-    CgenClassTable(Classes, ostream& str);
+    CgenClassTable(Classes, AsmWriter& str);
     void code();
     CgenNodeP root();
     int get_classtag(Symbol);
@@ -72,6 +74,7 @@ class CgenNode : public class__class {
     int classtag;
     std::map<Symbol, method_class*>* methodTable; // methodname=>methodclass
     std::list<attr_class*>* attrTable;
+    std::map<Symbol, int>* attrIndex; // attrname=>position in attrTable
     LocalEnv* localEnv;
 
   public:
@@ -85,7 +88,7 @@ class CgenNode : public class__class {
     int set_info(int classtag, std::list<Symbol>& tagList, CgenClassTableP);
     int get_attrtag(Symbol attrName);
     void env_init(void);
-    void code_methods(ostream& str, CgenClassTableP classTable);
+    void code_methods(AsmWriter& str, CgenClassTableP classTable);
     void get_method_disp_table(method_class* methods[]);
 };
 
@@ -95,6 +98,21 @@ class BoolConst {
 
   public:
     BoolConst(int);
-    void code_def(ostream&, int boolclasstag);
-    void code_ref(ostream&) const;
+    void code_def(AsmWriter&, int boolclasstag);
+    void code_ref(AsmWriter&) const;
+    Address address() const { return Address(ADDR_BOOLCONST, val); }
 };
+
+//
+// How a let-bound Int or Bool is used in the let body (see
+// cgen_unbox.cc).  Each use is weighted by how deeply it is nested in
+// loops.
+//
+struct VarUses {
+    int boxed;  // reads that need an object
+    int raw;    // reads whose value is used unboxed
+    int allocs; // assignments that allocate an Int when it is boxed
+};
+
+bool is_raw_type(Symbol type);
+bool allocates_int(Expression e);
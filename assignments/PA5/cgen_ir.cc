@@ -0,0 +1,229 @@
+//**************************************************************
+//
+// The instruction IR of the code generator: register names,
+// basic blocks, and the printer that turns a routine back into
+// assembly text.
+//
+//**************************************************************
+
+#include "cgen_ir.h"
+#include "emit.h"
+
+static const char* reg_names[NUM_REGS] = {
+    "", ZERO, ACC, A1, SELF, T1, T2, T3, SP, FP, RA,
+    "$s1", "$s2", "$s3", "$s4", "$s5", "$s6",
+    "$t4", "$t5", "$t6", "$t7", "$t8", "$t9"};
+
+Reg ir_reg(const char* name) {
+    // the names of emit.h are told apart by their first two letters
+    switch (name[1]) {
+    case 'z': return R_ZERO;
+    case 'a': return name[2] == '0' ? R_ACC : R_A1;
+    case 's': return name[2] == '0' ? R_SELF : R_SP;
+    case 't': return name[2] == '1' ? R_T1 : name[2] == '2' ? R_T2 : R_T3;
+    case 'f': return R_FP;
+    case 'r': return R_RA;
+    default:  return NO_REG;
+    }
+}
+
+const char* reg_name(Reg r) { return reg_names[r]; }
+
+void Address::print(AsmWriter& s) const {
+    switch (kind) {
+    case ADDR_NONE:
+        break;
+    case ADDR_NAME:
+        s << name;
+        break;
+    case ADDR_STRCONST:
+        s << STRCONST_PREFIX << index;
+        break;
+    case ADDR_INTCONST:
+        s << INTCONST_PREFIX << index;
+        break;
+    case ADDR_BOOLCONST:
+        s << BOOLCONST_PREFIX << index;
+        break;
+    case ADDR_PROTOBJ:
+        s << sym << PROTOBJ_SUFFIX;
+        break;
+    case ADDR_DISPTAB:
+        s << sym << DISPTAB_SUFFIX;
+        break;
+    case ADDR_INIT:
+        s << sym << CLASSINIT_SUFFIX;
+        break;
+    case ADDR_METHOD:
+        s << sym << METHOD_SEP << sym2;
+        break;
+    }
+}
+
+static const char* opcode_text(Opcode op) {
+    switch (op) {
+    case OP_LW:     return LW;
+    case OP_SW:     return SW;
+    case OP_LI:     return LI;
+    case OP_LA:     return LA;
+    case OP_MOVE:   return MOVE;
+    case OP_NEG:    return NEG;
+    case OP_ADD:    return ADD;
+    case OP_ADDU:   return ADDU;
+    case OP_ADDIU:  return ADDIU;
+    case OP_DIV:    return DIV;
+    case OP_MUL:    return MUL;
+    case OP_SUB:    return SUB;
+    case OP_SLL:    return SLL;
+    case OP_SLT:    return SLT;
+    case OP_SEQ:    return SEQ;
+    case OP_XORI:   return XORI;
+    case OP_ORI:    return ORI;
+    case OP_JAL:    return JAL;
+    case OP_JALR:   return JALR;
+    case OP_RET:    return RET;
+    case OP_BEQZ:   return BEQZ;
+    case OP_BEQ:    return BEQ;
+    case OP_BNE:    return BNE;
+    case OP_BLE:    return BLEQ;
+    case OP_BLT:    return BLT;
+    case OP_BLTI:   return BLT;
+    case OP_BGTI:   return BGT;
+    case OP_B:      return BRANCH;
+    default:        return "";
+    }
+}
+
+/**
+ * @brief write one line of assembly, as the emit functions wrote it
+ *
+ * @param s output stream
+ */
+void Instr::print(AsmWriter& s) const {
+    switch (op) {
+    case OP_LABEL:
+        s << "label" << label << ":" << endl;
+        return;
+    case OP_COMMENT:
+        s << addr.name;
+        if (addr.sym != NULL)
+            s << addr.sym;
+        if (addr.sym2 != NULL)
+            s << METHOD_SEP << addr.sym2;
+        s << endl;
+        return;
+    default:
+        break;
+    }
+
+    s << opcode_text(op);
+    switch (op) {
+    case OP_LW:
+    case OP_SW:
+        s << reg_name(rd) << " " << imm << "(" << reg_name(rs) << ")";
+        break;
+    case OP_LI:
+        s << reg_name(rd) << " " << imm;
+        break;
+    case OP_LA:
+        s << reg_name(rd) << " ";
+        addr.print(s);
+        break;
+    case OP_MOVE:
+    case OP_NEG:
+        s << reg_name(rd) << " " << reg_name(rs);
+        break;
+    case OP_ADD:
+    case OP_ADDU:
+    case OP_DIV:
+    case OP_MUL:
+    case OP_SUB:
+    case OP_SLT:
+    case OP_SEQ:
+        s << reg_name(rd) << " " << reg_name(rs) << " " << reg_name(rt);
+        break;
+    case OP_ADDIU:
+    case OP_SLL:
+    case OP_XORI:
+    case OP_ORI:
+        s << reg_name(rd) << " " << reg_name(rs) << " " << imm;
+        break;
+    case OP_JAL:
+        if (pad)
+            s << "\t";
+        addr.print(s);
+        break;
+    case OP_JALR:
+        s << "\t" << reg_name(rs);
+        break;
+    case OP_RET:
+        break;
+    case OP_BEQZ:
+        s << reg_name(rs) << " label" << label;
+        break;
+    case OP_BEQ:
+    case OP_BNE:
+    case OP_BLE:
+    case OP_BLT:
+        s << reg_name(rs) << " " << reg_name(rt) << " label" << label;
+        break;
+    case OP_BLTI:
+    case OP_BGTI:
+        s << reg_name(rs) << " " << imm << " label" << label;
+        break;
+    case OP_B:
+        s << "label" << label;
+        break;
+    default:
+        break;
+    }
+    s << endl;
+}
+
+void InstrList::comment(const char* text, Symbol sym, Symbol sym2) {
+    Instr i(OP_COMMENT);
+    i.addr.name = text;
+    i.addr.sym = sym;
+    i.addr.sym2 = sym2;
+    instrs.push_back(i);
+}
+
+/**
+ * @brief split the routine into basic blocks
+ *
+ * @param out the blocks, in order; every instruction is in exactly one
+ */
+void InstrList::blocks(std::vector<Block>& out) const {
+    out.clear();
+    int n = instrs.size();
+    int first = 0;
+    for (int i = 0; i < n; i++) {
+        const Instr& in = instrs[i];
+        if (in.op == OP_LABEL && i > first) {
+            Block b = {first, i};
+            out.push_back(b);
+            first = i;
+        }
+        if (in.is_branch() || in.op == OP_RET) {
+            Block b = {first, i + 1};
+            out.push_back(b);
+            first = i + 1;
+        }
+    }
+    if (first < n) {
+        Block b = {first, n};
+        out.push_back(b);
+    }
+}
+
+/**
+ * @brief write the routine: its label, then every instruction
+ *
+ * @param s output stream
+ */
+void InstrList::print(AsmWriter& s) const {
+    entry.print(s);
+    s << LABEL;
+    for (size_t i = 0; i < instrs.size(); i++)
+        instrs[i].print(s);
+}
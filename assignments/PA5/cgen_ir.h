@@ -0,0 +1,196 @@
+#ifndef _CGEN_IR_H_
+#define _CGEN_IR_H_
+
+#include "asmwriter.h"
+#include <vector>
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Instruction IR
+//
+//   The code of one routine (a method or a class init) is collected as
+//   a list of Instr before it is written out.  Each Instr is one line of
+//   the code segment: a MIPS instruction, a label definition or a
+//   comment.  InstrList::print writes exactly the text the emit
+//   functions used to write directly, so passes over the list can be
+//   added without changing the output of the ones that are off.
+//
+//   Operands of an instruction, by opcode:
+//
+//     lw, sw              rd is the register loaded or stored, rs the
+//                         base register, imm the offset in bytes.
+//     li                  rd, imm
+//     la                  rd, addr
+//     move, neg           rd, rs
+//     add addu div mul sub slt seq
+//                         rd, rs, rt
+//     addiu, sll, xori, ori
+//                         rd, rs, imm
+//     jal                 addr
+//     jalr                rs
+//     beqz                rs, label
+//     beq bne ble blt     rs, rt, label
+//     blti, bgti          rs, imm, label  (blt and bgt with a constant)
+//     b                   label
+//     label               label           (labelN:)
+//     comment             addr.name, then addr.sym and addr.sym2
+//
+//   Under register allocation the code generator also uses virtual
+//   registers, numbered from NUM_REGS up: as the destination or the
+//   source of a move, and as rs and rt of the operators on raw values
+//   (add, sub, mul, div, slt, seq), whose rd is $a0.  A virtual
+//   register is never moved to another one.  One that holds a raw Int
+//   is marked as such, as the collector must not see it where it looks
+//   for pointers.  InstrList::allocate_registers replaces them before
+//   anything else looks at the code.
+//
+/////////////////////////////////////////////////////////////////////////
+
+enum Opcode {
+    OP_LW, OP_SW, OP_LI, OP_LA, OP_MOVE, OP_NEG,
+    OP_ADD, OP_ADDU, OP_ADDIU, OP_DIV, OP_MUL, OP_SUB, OP_SLL,
+    OP_SLT, OP_SEQ, OP_XORI, OP_ORI,
+    OP_JAL, OP_JALR, OP_RET,
+    OP_BEQZ, OP_BEQ, OP_BNE, OP_BLE, OP_BLT, OP_BLTI, OP_BGTI, OP_B,
+    OP_LABEL, OP_COMMENT
+};
+
+enum Reg : int {
+    NO_REG, R_ZERO, R_ACC, R_A1, R_SELF, R_T1, R_T2, R_T3, R_SP, R_FP, R_RA,
+    // only used by register allocation
+    R_S1, R_S2, R_S3, R_S4, R_S5, R_S6, R_T4, R_T5, R_T6, R_T7, R_T8, R_T9,
+    NUM_REGS
+};
+
+inline bool is_virtual(Reg r) { return r >= NUM_REGS; }
+
+// the register named by one of the strings of emit.h
+Reg ir_reg(const char* name);
+const char* reg_name(Reg r);
+
+//
+// A symbolic address.  How it is written:
+//
+//   ADDR_NAME       name
+//   ADDR_STRCONST   str_const<index>
+//   ADDR_INTCONST   int_const<index>
+//   ADDR_BOOLCONST  bool_const<index>
+//   ADDR_PROTOBJ    <sym>_protObj
+//   ADDR_DISPTAB    <sym>_dispTab
+//   ADDR_INIT       <sym>_init
+//   ADDR_METHOD     <sym>.<sym2>
+//
+enum AddrKind {
+    ADDR_NONE, ADDR_NAME, ADDR_STRCONST, ADDR_INTCONST, ADDR_BOOLCONST,
+    ADDR_PROTOBJ, ADDR_DISPTAB, ADDR_INIT, ADDR_METHOD
+};
+
+struct Address {
+    AddrKind kind;
+    int index;
+    const char* name;
+    Symbol sym;
+    Symbol sym2;
+
+    Address() : kind(ADDR_NONE), index(0), name(NULL), sym(NULL), sym2(NULL) {}
+    Address(AddrKind k, Symbol s, Symbol s2 = NULL)
+        : kind(k), index(0), name(NULL), sym(s), sym2(s2) {}
+    Address(AddrKind k, int i)
+        : kind(k), index(i), name(NULL), sym(NULL), sym2(NULL) {}
+    Address(const char* n)
+        : kind(ADDR_NAME), index(0), name(n), sym(NULL), sym2(NULL) {}
+
+    void print(AsmWriter& s) const;
+};
+
+struct Instr {
+    Opcode op;
+    Reg rd, rs, rt;
+    int imm;
+    int label;
+    Address addr;
+    bool pad; // jal written with an extra tab, as generate_new_class did
+
+    Instr(Opcode o)
+        : op(o), rd(NO_REG), rs(NO_REG), rt(NO_REG), imm(0), label(-1),
+          pad(false) {}
+
+    bool is_branch() const { return op >= OP_BEQZ && op <= OP_B; }
+    void print(AsmWriter& s) const;
+};
+
+//
+// A basic block: the instructions [first, end) of a routine.  A block
+// starts at the routine entry, at a label and after a branch or a
+// return; calls do not end a block.
+//
+struct Block {
+    int first;
+    int end;
+};
+
+class InstrList;
+
+//
+// What register allocation adds to the frame of a routine: the
+// callee-saved registers it uses, saved on entry, and the slots of the
+// values it could not keep in registers or sets aside across calls.
+// Both sit between the saved $ra (where $fp points) and the expression
+// stack, the saved registers first.
+//
+struct Frame {
+    std::vector<Reg> saved;
+    int spills;
+
+    Frame() : spills(0) {}
+    int words() const { return saved.size() + spills; }
+    void enter(InstrList& s) const;
+    void leave(InstrList& s) const;
+};
+
+class InstrList {
+  private:
+    Address entry; // the routine's label
+    std::vector<Instr> instrs;
+    int vregs;     // virtual registers handed out so far
+    std::vector<bool> raw_ints; // which of them hold a raw Int
+
+  public:
+    InstrList() : vregs(0) {}
+    void start(const Address& routine) {
+        entry = routine;
+        instrs.clear();
+        vregs = 0;
+        raw_ints.clear();
+    }
+    void append(const Instr& i) { instrs.push_back(i); }
+    void append(const InstrList& code) {
+        instrs.insert(instrs.end(), code.instrs.begin(), code.instrs.end());
+    }
+    Reg new_vreg(bool raw_int = false) {
+        raw_ints.push_back(raw_int);
+        return Reg(NUM_REGS + vregs++);
+    }
+    bool holds_raw_int(Reg r) const { return raw_ints[r - NUM_REGS]; }
+    void comment(const char* text, Symbol sym = NULL, Symbol sym2 = NULL);
+
+    int size() const { return instrs.size(); }
+    Instr& operator[](int n) { return instrs[n]; }
+    const Instr& operator[](int n) const { return instrs[n]; }
+
+    void blocks(std::vector<Block>& out) const;
+    void print(AsmWriter& s) const;
+
+    // cgen_peephole.cc
+    void peephole();
+
+    // cgen_regalloc.cc
+    void allocate_registers(Frame& frame);
+};
+
+// what peephole() has removed so far, for -O -c
+void peephole_report(ostream& s);
+// where allocate_registers() has put the values so far, for -O -c
+void regalloc_report(ostream& s);
+
+#endif
@@ -0,0 +1,346 @@
+//**************************************************************
+//
+// Peephole optimizer (-O)
+//
+// The expression code is a stack machine: every intermediate
+// value is pushed with `sw R 0($sp); addiu $sp $sp -4' and popped
+// with a load from 4($sp) and another addiu.  InstrList::peephole
+// cleans up one routine at a time, repeating two passes until
+// neither finds anything more:
+//
+//   - a window pass, which re-appends the instructions one by one
+//     and rewrites the tail of what it has kept so far:
+//       * stack adjustments are moved down past the loads and stores
+//         on $sp that follow them, and adjacent ones are added up;
+//       * a store into the part of the stack an adjustment has just
+//         given back is dropped;
+//       * a load of the word just stored or loaded becomes a move;
+//       * a move that copies a register to itself, or back where it
+//         just came from, is dropped;
+//
+//   - a control pass, which threads branches to a `b', drops
+//     branches to the next instruction and code after a `b' or
+//     return, and deletes labels nothing branches to.
+//
+// Nothing moves across a label, branch or call, so the garbage
+// collector sees the same stack at every call as without -O.
+//
+//**************************************************************
+
+#include "cgen_ir.h"
+#include <map>
+
+static struct {
+    int push_pop;    // stores to the stack that were popped right away
+    int stack;       // stack adjustments merged into others
+    int moves;
+    int loads;
+    int branches;    // branches to the next instruction
+    int threaded;    // branches sent straight on past a `b'
+    int void_checks; // tests of self or a constant against void
+    int unreachable;
+    int labels;
+} removed;
+
+void peephole_report(ostream& s) {
+    s << "peephole: " << removed.push_pop << " push/pop stores, "
+      << removed.stack << " stack adjustments, " << removed.moves
+      << " moves, " << removed.loads << " loads, " << removed.branches
+      << " branches to the next instruction, " << removed.unreachable
+      << " unreachable instructions, " << removed.labels
+      << " unused labels removed; " << removed.threaded
+      << " jumps threaded, " << removed.void_checks
+      << " void checks decided" << endl;
+}
+
+static bool is_sp_adjust(const Instr& i) {
+    return i.op == OP_ADDIU && i.rd == R_SP && i.rs == R_SP;
+}
+
+// a load or store of a word on the stack, addressed from $sp
+static bool is_sp_access(const Instr& i) {
+    return (i.op == OP_LW || i.op == OP_SW) && i.rs == R_SP && i.rd != R_SP;
+}
+
+// an instruction a stack adjustment can be moved below as it is
+static bool ignores_sp(const Instr& i) {
+    switch (i.op) {
+    case OP_LW:
+    case OP_SW:
+    case OP_LI:
+    case OP_LA:
+    case OP_MOVE:
+    case OP_NEG:
+    case OP_ADD:
+    case OP_ADDU:
+    case OP_ADDIU:
+    case OP_DIV:
+    case OP_MUL:
+    case OP_SUB:
+    case OP_SLL:
+    case OP_SLT:
+    case OP_SEQ:
+    case OP_XORI:
+    case OP_ORI:
+        return i.rd != R_SP && i.rs != R_SP && i.rt != R_SP;
+    default:
+        return false;
+    }
+}
+
+// the last instruction of out that is not a comment, or -1
+static int last_real(const std::vector<Instr>& out) {
+    for (int n = out.size() - 1; n >= 0; n--) {
+        if (out[n].op != OP_COMMENT)
+            return n;
+    }
+    return -1;
+}
+
+static Instr move_instr(Reg dest, Reg src) {
+    Instr i(OP_MOVE);
+    i.rd = dest;
+    i.rs = src;
+    return i;
+}
+
+// instructions that neither read memory nor change the flow of control
+static bool reads_no_memory(const Instr& i) {
+    switch (i.op) {
+    case OP_SW:
+    case OP_LI:
+    case OP_LA:
+    case OP_MOVE:
+    case OP_NEG:
+    case OP_ADD:
+    case OP_ADDU:
+    case OP_ADDIU:
+    case OP_DIV:
+    case OP_MUL:
+    case OP_SUB:
+    case OP_SLL:
+    case OP_SLT:
+    case OP_SEQ:
+    case OP_XORI:
+    case OP_ORI:
+    case OP_COMMENT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// Drop the stores near the end of out that went into words below
+// $sp + d, which an adjustment of $sp by d has just freed.  Nothing
+// after such a store can have read the word back.
+//
+static void drop_dead_stores(std::vector<Instr>& out, int d) {
+    for (int n = out.size() - 1; n >= 0 && reads_no_memory(out[n]); n--) {
+        const Instr& i = out[n];
+        if (i.op != OP_SW && i.rd == R_SP)
+            return;
+        if (i.op == OP_SW && i.rs == R_SP && i.imm <= d) {
+            out.erase(out.begin() + n);
+            removed.push_pop++;
+        }
+    }
+}
+
+//
+// The stack adjustment at the end of out is final: drop the stores it
+// has freed, and the adjustment itself if it came to nothing.
+//
+static void settle(std::vector<Instr>& out) {
+    Instr adjust = out.back();
+    out.pop_back();
+    drop_dead_stores(out, adjust.imm);
+    if (adjust.imm != 0)
+        out.push_back(adjust);
+    else
+        removed.stack++;
+}
+
+/**
+ * @brief append one instruction to out, simplifying its tail
+ *
+ * @param out the instructions kept so far
+ * @param in the next instruction
+ */
+static void keep(std::vector<Instr>& out, Instr in) {
+    // an adjustment at the end is only known to be final once
+    // something that has to see it follows
+    if (!out.empty() && is_sp_adjust(out.back()) && !is_sp_adjust(in) &&
+        !is_sp_access(in) && !ignores_sp(in) && in.op != OP_COMMENT)
+        settle(out);
+
+    int p = last_real(out);
+    if (in.op == OP_COMMENT || p < 0) {
+        out.push_back(in);
+        return;
+    }
+    Instr prev = out[p];
+    bool adjacent = p == (int)out.size() - 1;
+
+    // move a stack adjustment below the instruction after it, so
+    // that it can meet the next one
+    if (adjacent && is_sp_adjust(prev) &&
+        (is_sp_access(in) || ignores_sp(in))) {
+        out.pop_back();
+        if (is_sp_access(in))
+            in.imm += prev.imm;
+        keep(out, in);
+        out.push_back(prev);
+        return;
+    }
+
+    switch (in.op) {
+    case OP_ADDIU:
+        if (adjacent && is_sp_adjust(in) && is_sp_adjust(prev)) {
+            out.back().imm += in.imm;
+            removed.stack++;
+            return;
+        }
+        break;
+    case OP_LW:
+        // the word is still in the register it was stored from or
+        // loaded into, unless that load overwrote its own base
+        if ((prev.op == OP_SW || (prev.op == OP_LW && prev.rd != prev.rs)) &&
+            prev.rs == in.rs && prev.imm == in.imm) {
+            removed.loads++;
+            if (in.rd != prev.rd)
+                keep(out, move_instr(in.rd, prev.rd));
+            return;
+        }
+        break;
+    case OP_BNE: {
+        // self and the constants are never void
+        int set = p;
+        while (set > 0 && (is_sp_adjust(out[set]) || out[set].op == OP_COMMENT))
+            set--;
+        const Instr& def = out[set];
+        if (in.rt == R_ZERO && def.rd == in.rs &&
+            ((def.op == OP_MOVE && def.rs == R_SELF) || def.op == OP_LA)) {
+            in.op = OP_B;
+            in.rs = NO_REG;
+            in.rt = NO_REG;
+            removed.void_checks++;
+        }
+        break;
+    }
+    case OP_MOVE:
+        if (in.rd == in.rs ||
+            (prev.op == OP_MOVE &&
+             ((prev.rd == in.rs && prev.rs == in.rd) ||
+              (prev.rd == in.rd && prev.rs == in.rs)))) {
+            removed.moves++;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+    out.push_back(in);
+}
+
+// the first instruction at or after n that is not a label or comment
+static int next_real(const std::vector<Instr>& code, int n) {
+    while (n < (int)code.size() &&
+           (code[n].op == OP_LABEL || code[n].op == OP_COMMENT))
+        n++;
+    return n;
+}
+
+/**
+ * @brief thread jumps and remove dead branches, code and labels
+ *
+ * @param code a routine
+ * @return whether anything changed
+ */
+static bool control_pass(std::vector<Instr>& code) {
+    int n = code.size();
+    std::map<int, int> label_at;
+    for (int i = 0; i < n; i++) {
+        if (code[i].op == OP_LABEL)
+            label_at[code[i].label] = i;
+    }
+
+    std::vector<bool> dead(n, false);
+    bool changed = false;
+    for (int i = 0; i < n; i++) {
+        Instr& in = code[i];
+        if (!in.is_branch())
+            continue;
+        // a branch to a `b' can go where the `b' goes
+        for (int hops = 0; hops < n; hops++) {
+            std::map<int, int>::iterator at = label_at.find(in.label);
+            if (at == label_at.end())
+                break;
+            int target = next_real(code, at->second);
+            if (target == n || code[target].op != OP_B ||
+                code[target].label == in.label || target == i)
+                break;
+            in.label = code[target].label;
+            removed.threaded++;
+            changed = true;
+        }
+        // a branch to the next instruction does nothing
+        for (int j = i + 1; j < n && (code[j].op == OP_LABEL ||
+                                      code[j].op == OP_COMMENT); j++) {
+            if (code[j].op == OP_LABEL && code[j].label == in.label) {
+                dead[i] = true;
+                removed.branches++;
+                break;
+            }
+        }
+    }
+
+    // nothing reaches the code after a `b' or a return but a label
+    for (int i = 0; i < n; i++) {
+        if (dead[i] || (code[i].op != OP_B && code[i].op != OP_RET))
+            continue;
+        for (int j = i + 1; j < n && code[j].op != OP_LABEL; j++) {
+            if (code[j].op != OP_COMMENT && !dead[j]) {
+                dead[j] = true;
+                removed.unreachable++;
+            }
+        }
+    }
+
+    std::map<int, int> uses;
+    for (int i = 0; i < n; i++) {
+        if (!dead[i] && code[i].is_branch())
+            uses[code[i].label]++;
+    }
+    for (int i = 0; i < n; i++) {
+        if (code[i].op == OP_LABEL && uses[code[i].label] == 0) {
+            dead[i] = true;
+            removed.labels++;
+        }
+    }
+
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (!dead[i])
+            code[kept++] = code[i];
+    }
+    code.erase(code.begin() + kept, code.end());
+    return changed || kept != n;
+}
+
+void InstrList::peephole() {
+    // a few rounds are plenty; the limit only guards against branches
+    // that go round in a cycle of `b's
+    for (int round = 0; round < 8; round++) {
+        std::vector<Instr> out;
+        out.reserve(instrs.size());
+        for (size_t i = 0; i < instrs.size(); i++)
+            keep(out, instrs[i]);
+        bool changed = out.size() != instrs.size();
+        instrs.swap(out);
+        if (control_pass(instrs))
+            changed = true;
+        if (!changed)
+            break;
+    }
+}
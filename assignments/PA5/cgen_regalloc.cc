@@ -0,0 +1,444 @@
+//**************************************************************
+//
+// Register allocation (-O)
+//
+// Under -O, unless -r is given, the code generator keeps let variables
+// and the left operands of arithmetic and comparisons in virtual
+// registers instead of pushing them, and the operators take their
+// operands straight from those registers.
+// InstrList::allocate_registers maps the virtual registers of one
+// routine to real ones by linear scan:
+//
+//   - liveness is computed over the basic blocks, and each virtual
+//     register is given the interval from the first to the last
+//     instruction where it is live;
+//   - an interval with a call inside it needs a callee-saved register,
+//     $s1-$s6.  Every runtime routine preserves them, and the garbage
+//     collector treats them as roots (MemMgr_REG_MASK), so the
+//     pointers in them are kept up to date across a collection
+//     (a raw Int is the exception, below);
+//   - any other interval takes a temporary, $t4-$t9, which neither the
+//     runtime nor the rest of the code generator touches, and an $s
+//     register only when those are all in use;
+//   - when no suitable register is free, whichever of the new interval
+//     and the ones holding a register ends last goes to a frame slot.
+//     An operator reads a spilled operand through $t1 or $t2, which
+//     hold nothing else at that point.
+//
+// A raw Int is not a pointer, but the collector takes any even word
+// in $s0-$s6 or on the stack that points into the heap for one, even
+// a value left in a register after its interval has ended.  So a raw
+// Int never goes in an $s register, and it is never stored as it is:
+//
+//   - it is written to the frame as two words, v | 1, which is odd,
+//     and the 0 or 1 to take off that again, and put together again
+//     in the register that reads it;
+//   - one that lives across a call takes a temporary all the same,
+//     and is written out like that before each call inside its
+//     interval and read back after it;
+//   - one that is spilled takes two slots for the two words.
+//
+// This goes through $t3, which the rest of the code generator leaves
+// alone.
+//
+// The callee-saved registers used are saved in the frame on entry and
+// restored on exit, and the other slots are cleared on entry, since
+// the collector scans every word of the stack.  Both go below the
+// saved $ra, so the words the code addresses below $fp move down past
+// them.
+//
+//**************************************************************
+
+#include "cgen_ir.h"
+#include "emit.h"
+#include <algorithm>
+#include <map>
+
+static struct {
+    int temporaries; // values put in $t4-$t9
+    int saved;       // values put in $s1-$s6
+    int spilled;
+    int set_aside;   // raw Ints in temporaries written out at calls
+} placed;
+
+void regalloc_report(ostream& s) {
+    s << "regalloc: " << placed.temporaries << " values in temporaries, "
+      << placed.saved << " in callee-saved registers, " << placed.spilled
+      << " spilled; " << placed.set_aside
+      << " raw Ints set aside at calls" << endl;
+}
+
+static const Reg temporaries[] = {R_T4, R_T5, R_T6, R_T7, R_T8, R_T9};
+static const Reg callee_saved[] = {R_S1, R_S2, R_S3, R_S4, R_S5, R_S6};
+
+static bool is_callee_saved(Reg r) { return r >= R_S1 && r <= R_S6; }
+static bool is_temporary(Reg r) { return r >= R_T4 && r <= R_T9; }
+
+// a load or store of the nth word the allocator adds to the frame
+static Instr frame_slot(Opcode op, Reg r, int n) {
+    Instr i(op);
+    i.rd = r;
+    i.rs = R_FP;
+    i.imm = -WORD_SIZE * (n + 1);
+    return i;
+}
+
+static Instr or_one(Reg rd, Reg rs) {
+    Instr i(OP_ORI);
+    i.rd = rd;
+    i.rs = rs;
+    i.imm = 1;
+    return i;
+}
+
+static Instr subtract(Reg rd, Reg rs, Reg rt) {
+    Instr i(OP_SUB);
+    i.rd = rd;
+    i.rs = rs;
+    i.rt = rt;
+    return i;
+}
+
+// store the raw Int in r as the two words at slot n
+static void store_raw(std::vector<Instr>& out, Reg r, int n) {
+    out.push_back(or_one(R_T3, r));
+    out.push_back(frame_slot(OP_SW, R_T3, n));
+    out.push_back(subtract(R_T3, R_T3, r));
+    out.push_back(frame_slot(OP_SW, R_T3, n + 1));
+}
+
+// load the raw Int stored at slot n into r
+static void load_raw(std::vector<Instr>& out, Reg r, int n) {
+    out.push_back(frame_slot(OP_LW, r, n));
+    out.push_back(frame_slot(OP_LW, R_T3, n + 1));
+    out.push_back(subtract(r, r, R_T3));
+}
+
+void Frame::enter(InstrList& s) const {
+    for (size_t n = 0; n < saved.size(); n++)
+        s.append(frame_slot(OP_SW, saved[n], n));
+    for (int n = 0; n < spills; n++)
+        s.append(frame_slot(OP_SW, R_ZERO, saved.size() + n));
+}
+
+void Frame::leave(InstrList& s) const {
+    for (size_t n = 0; n < saved.size(); n++)
+        s.append(frame_slot(OP_LW, saved[n], n));
+}
+
+//
+// The instructions over which a virtual register is live, and where
+// it ends up: in reg, or in spill slot slot if reg is NO_REG.
+//
+struct Interval {
+    int start;
+    int end;
+    bool across_call;
+    bool raw_int;
+    Reg reg;
+    int slot;
+};
+
+// whether the call at instruction n is inside iv
+static bool inside(const Interval& iv, int n) {
+    return iv.start < n && n < iv.end;
+}
+
+// whether iv can be kept in r: across a call only in an $s register,
+// which the callee preserves, but a raw Int only in a temporary
+static bool may_take(const Interval& iv, Reg r) {
+    if (iv.raw_int)
+        return is_temporary(r);
+    return !iv.across_call || is_callee_saved(r);
+}
+
+static bool by_start(const Interval* a, const Interval* b) {
+    return a->start < b->start;
+}
+
+// stretch iv to cover instruction n
+static void touch(Interval& iv, int n) {
+    iv.start = std::min(iv.start, n);
+    iv.end = std::max(iv.end, n);
+}
+
+/**
+ * @brief the live interval of every virtual register of a routine
+ *
+ * @param code the routine
+ * @param blocks its basic blocks
+ * @param out one interval per virtual register, in order
+ */
+static void live_intervals(const InstrList& code,
+                           const std::vector<Block>& blocks,
+                           std::vector<Interval>& out) {
+    int nblocks = blocks.size();
+    int nvregs = out.size();
+
+    std::map<int, int> block_at;
+    for (int b = 0; b < nblocks; b++) {
+        if (code[blocks[b].first].op == OP_LABEL)
+            block_at[code[blocks[b].first].label] = b;
+    }
+    std::vector<std::vector<int> > succ(nblocks);
+    for (int b = 0; b < nblocks; b++) {
+        const Instr& last = code[blocks[b].end - 1];
+        if (last.is_branch() && block_at.count(last.label))
+            succ[b].push_back(block_at[last.label]);
+        if (last.op != OP_B && last.op != OP_RET && b + 1 < nblocks)
+            succ[b].push_back(b + 1);
+    }
+
+    // only a move writes a virtual register
+    typedef std::vector<bool> VSet;
+    std::vector<VSet> use(nblocks, VSet(nvregs)), def(nblocks, VSet(nvregs));
+    for (int b = 0; b < nblocks; b++) {
+        for (int n = blocks[b].first; n < blocks[b].end; n++) {
+            const Instr& in = code[n];
+            if (is_virtual(in.rs) && !def[b][in.rs - NUM_REGS])
+                use[b][in.rs - NUM_REGS] = true;
+            if (is_virtual(in.rt) && !def[b][in.rt - NUM_REGS])
+                use[b][in.rt - NUM_REGS] = true;
+            if (is_virtual(in.rd))
+                def[b][in.rd - NUM_REGS] = true;
+        }
+    }
+
+    std::vector<VSet> live_in(nblocks, VSet(nvregs)),
+        live_out(nblocks, VSet(nvregs));
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int b = nblocks - 1; b >= 0; b--) {
+            for (size_t k = 0; k < succ[b].size(); k++) {
+                const VSet& in = live_in[succ[b][k]];
+                for (int v = 0; v < nvregs; v++) {
+                    if (in[v] && !live_out[b][v]) {
+                        live_out[b][v] = true;
+                        changed = true;
+                    }
+                }
+            }
+            for (int v = 0; v < nvregs; v++) {
+                if (!live_in[b][v] &&
+                    (use[b][v] || (live_out[b][v] && !def[b][v]))) {
+                    live_in[b][v] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (int v = 0; v < nvregs; v++) {
+        out[v].start = code.size();
+        out[v].end = -1;
+        out[v].across_call = false;
+        out[v].reg = NO_REG;
+        out[v].slot = -1;
+    }
+    for (int b = 0; b < nblocks; b++) {
+        for (int v = 0; v < nvregs; v++) {
+            if (live_in[b][v])
+                touch(out[v], blocks[b].first);
+            if (live_out[b][v])
+                touch(out[v], blocks[b].end - 1);
+        }
+        for (int n = blocks[b].first; n < blocks[b].end; n++) {
+            const Instr& in = code[n];
+            if (is_virtual(in.rs))
+                touch(out[in.rs - NUM_REGS], n);
+            if (is_virtual(in.rt))
+                touch(out[in.rt - NUM_REGS], n);
+            if (is_virtual(in.rd))
+                touch(out[in.rd - NUM_REGS], n);
+        }
+    }
+
+    for (int n = 0; n < code.size(); n++) {
+        if (code[n].op != OP_JAL && code[n].op != OP_JALR)
+            continue;
+        for (int v = 0; v < nvregs; v++) {
+            if (inside(out[v], n))
+                out[v].across_call = true;
+        }
+    }
+}
+
+// a register of regs that no active interval holds, or NO_REG
+static Reg free_reg(const Reg* regs, int count,
+                    const std::vector<Interval*>& active) {
+    for (int k = 0; k < count; k++) {
+        bool taken = false;
+        for (size_t a = 0; a < active.size(); a++)
+            taken = taken || active[a]->reg == regs[k];
+        if (!taken)
+            return regs[k];
+    }
+    return NO_REG;
+}
+
+/**
+ * @brief give every interval a register, or leave it to be spilled
+ *
+ * @param intervals the intervals of a routine
+ */
+static void linear_scan(std::vector<Interval>& intervals) {
+    std::vector<Interval*> order;
+    for (size_t v = 0; v < intervals.size(); v++)
+        order.push_back(&intervals[v]);
+    std::stable_sort(order.begin(), order.end(), by_start);
+
+    std::vector<Interval*> active;
+    for (size_t k = 0; k < order.size(); k++) {
+        Interval* iv = order[k];
+        for (size_t a = 0; a < active.size();) {
+            if (active[a]->end < iv->start)
+                active.erase(active.begin() + a);
+            else
+                a++;
+        }
+
+        Reg r = NO_REG;
+        if (!iv->across_call || iv->raw_int)
+            r = free_reg(temporaries, 6, active);
+        if (r == NO_REG && !iv->raw_int)
+            r = free_reg(callee_saved, 6, active);
+        if (r == NO_REG) {
+            // take the register of the interval that ends last, if
+            // that is not iv itself
+            Interval* victim = NULL;
+            for (size_t a = 0; a < active.size(); a++) {
+                Interval* other = active[a];
+                if (may_take(*iv, other->reg) && other->end > iv->end &&
+                    (victim == NULL || other->end > victim->end))
+                    victim = other;
+            }
+            if (victim != NULL) {
+                r = victim->reg;
+                victim->reg = NO_REG;
+                active.erase(std::find(active.begin(), active.end(), victim));
+            }
+        }
+        iv->reg = r;
+        if (r != NO_REG)
+            active.push_back(iv);
+    }
+}
+
+/**
+ * @brief replace the virtual registers of the routine by real ones
+ *
+ * @param frame set to the callee-saved registers used and the number
+ *        of other slots
+ */
+void InstrList::allocate_registers(Frame& frame) {
+    if (vregs == 0)
+        return;
+
+    std::vector<Block> bs;
+    blocks(bs);
+    std::vector<Interval> intervals(vregs);
+    live_intervals(*this, bs, intervals);
+    for (int v = 0; v < vregs; v++)
+        intervals[v].raw_int = raw_ints[v];
+    linear_scan(intervals);
+
+    for (int k = 0; k < 6; k++) {
+        for (int v = 0; v < vregs; v++) {
+            if (intervals[v].reg == callee_saved[k]) {
+                frame.saved.push_back(callee_saved[k]);
+                break;
+            }
+        }
+    }
+    // the raw Ints kept in temporaries across calls, and the slots
+    // they are written to at a call, by register
+    std::vector<const Interval*> set_aside;
+    int aside_slot[6];
+    for (int v = 0; v < vregs; v++) {
+        Interval& iv = intervals[v];
+        if (iv.reg == NO_REG) {
+            iv.slot = frame.saved.size() + frame.spills;
+            frame.spills += iv.raw_int ? 2 : 1;
+            placed.spilled++;
+        } else if (is_callee_saved(iv.reg)) {
+            placed.saved++;
+        } else {
+            if (iv.across_call)
+                set_aside.push_back(&iv);
+            placed.temporaries++;
+        }
+    }
+    for (int k = 0; k < 6; k++) {
+        aside_slot[k] = -1;
+        for (size_t a = 0; a < set_aside.size(); a++) {
+            if (set_aside[a]->reg == temporaries[k]) {
+                aside_slot[k] = frame.saved.size() + frame.spills;
+                frame.spills += 2;
+                break;
+            }
+        }
+    }
+    placed.set_aside += set_aside.size();
+
+    int shift = WORD_SIZE * frame.words();
+    std::vector<Instr> out;
+    out.reserve(instrs.size());
+    for (size_t n = 0; n < instrs.size(); n++) {
+        Instr in = instrs[n];
+        bool call = in.op == OP_JAL || in.op == OP_JALR;
+        for (size_t a = 0; call && a < set_aside.size(); a++) {
+            Reg r = set_aside[a]->reg;
+            if (inside(*set_aside[a], n))
+                store_raw(out, r, aside_slot[r - R_T4]);
+        }
+        if ((in.op == OP_LW || in.op == OP_SW) && in.rs == R_FP && in.imm < 0)
+            in.imm -= shift;
+        if (is_virtual(in.rd)) {
+            const Interval& iv = intervals[in.rd - NUM_REGS];
+            if (iv.reg != NO_REG) {
+                in.rd = iv.reg;
+            } else if (iv.raw_int) {
+                store_raw(out, in.rs, iv.slot);
+                continue;
+            } else {
+                in = frame_slot(OP_SW, in.rs, iv.slot);
+            }
+        }
+        if (is_virtual(in.rs)) {
+            const Interval& iv = intervals[in.rs - NUM_REGS];
+            Reg via = in.op == OP_MOVE ? in.rd : R_T1;
+            if (iv.reg != NO_REG) {
+                in.rs = iv.reg;
+            } else if (iv.raw_int) {
+                load_raw(out, via, iv.slot);
+                if (in.op == OP_MOVE)
+                    continue;
+                in.rs = R_T1;
+            } else if (in.op == OP_MOVE) {
+                in = frame_slot(OP_LW, in.rd, iv.slot);
+            } else {
+                out.push_back(frame_slot(OP_LW, R_T1, iv.slot));
+                in.rs = R_T1;
+            }
+        }
+        if (is_virtual(in.rt)) {
+            const Interval& iv = intervals[in.rt - NUM_REGS];
+            if (iv.reg != NO_REG) {
+                in.rt = iv.reg;
+            } else if (iv.raw_int) {
+                load_raw(out, R_T2, iv.slot);
+                in.rt = R_T2;
+            } else {
+                out.push_back(frame_slot(OP_LW, R_T2, iv.slot));
+                in.rt = R_T2;
+            }
+        }
+        out.push_back(in);
+        for (size_t a = 0; call && a < set_aside.size(); a++) {
+            Reg r = set_aside[a]->reg;
+            if (inside(*set_aside[a], n))
+                load_raw(out, r, aside_slot[r - R_T4]);
+        }
+    }
+    instrs.swap(out);
+}
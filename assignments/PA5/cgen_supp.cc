@@ -2,10 +2,11 @@
 #include <stdio.h>
 #include <string.h>
 #include "stringtab.h"
+#include "asmwriter.h"
 
 static int ascii = 0;
 
-void ascii_mode(ostream& str)
+void ascii_mode(AsmWriter& str)
 {
   if (!ascii) 
     {
@@ -14,7 +15,7 @@ void ascii_mode(ostream& str)
     } 
 }
 
-void byte_mode(ostream& str)
+void byte_mode(AsmWriter& str)
 {
   if (ascii) 
     {
@@ -23,11 +24,26 @@ void byte_mode(ostream& str)
     }
 }
 
-void emit_string_constant(ostream& str, char* s)
+// characters that go into an .ascii directive as they are
+static inline int plain_char(char c)
+{
+  return c >= ' ' && ((unsigned char) c) < 128 && c != '\\' && c != '"';
+}
+
+void emit_string_constant(AsmWriter& str, char* s)
 {
   ascii = 0;
 
   while (*s) {
+    if (plain_char(*s)) {
+      /* copy the whole run of plain characters at once */
+      char *run = s;
+      while (plain_char(*s))
+        s++;
+      ascii_mode(str);
+      str.write(run, s - run);
+      continue;
+    }
     switch (*s) {
     case '\n':
       ascii_mode(str);
@@ -46,16 +62,8 @@ void emit_string_constant(ostream& str, char* s)
       str << "\\\"";
       break;
     default:
-      if (*s >= ' ' && ((unsigned char) *s) < 128) 
-	{
-	  ascii_mode(str);
-	  str << *s;
-	}
-      else 
-	{
-	  byte_mode(str);
-	  str << "\t.byte\t" << (int) ((unsigned char) *s) << endl;
-	}
+      byte_mode(str);
+      str << "\t.byte\t" << (int) ((unsigned char) *s) << endl;
       break;
     }
     s++;
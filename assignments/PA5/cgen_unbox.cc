@@ -0,0 +1,152 @@
+//**************************************************************
+//
+// Uses of a let-bound Int or Bool (-O)
+//
+// Under -O a let variable of type Int or Bool may be kept as a raw
+// word instead of a pointer to an object.  Reading it where an object
+// is needed (an argument, an attribute, the value of a method, the
+// receiver of a dispatch) then has to box it: for a
+// Bool that is a choice between the two constants, for an Int a new
+// object.  Keeping it boxed, on the other hand, allocates an Int on
+// every assignment of a sum, difference, product, quotient or
+// negation.
+//
+// count_uses walks the body of the let and tallies the two for one
+// variable, weighting a use by eight for every loop around it.
+// let_class decides from the tally which representation is cheaper.
+//
+// The `raw' argument says whether the value of the expression is
+// wanted unboxed by the code around it; a value that is thrown away
+// (in a block or the body of a loop) counts as unboxed, since it is
+// generated that way.
+//
+//**************************************************************
+
+#include "cgen.h"
+
+// the weight of a use inside one more loop
+static int in_loop(int weight) { return weight < (1 << 20) ? weight * 8 : weight; }
+
+void assign_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    if (name == x) {
+        if (allocates_int(expr))
+            uses.allocs += weight;
+        if (!raw)
+            uses.boxed += weight;
+    }
+    expr->count_uses(x, uses, name == x, weight);
+}
+
+void static_dispatch_class::count_uses(Symbol x, VarUses& uses, bool raw,
+                                       int weight) {
+    expr->count_uses(x, uses, false, weight);
+    for (int i = actual->first(); actual->more(i); i = actual->next(i))
+        actual->nth(i)->count_uses(x, uses, false, weight);
+}
+
+void dispatch_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    expr->count_uses(x, uses, false, weight);
+    for (int i = actual->first(); actual->more(i); i = actual->next(i))
+        actual->nth(i)->count_uses(x, uses, false, weight);
+}
+
+void cond_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    pred->count_uses(x, uses, true, weight);
+    then_exp->count_uses(x, uses, raw, weight);
+    else_exp->count_uses(x, uses, raw, weight);
+}
+
+void loop_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    pred->count_uses(x, uses, true, in_loop(weight));
+    body->count_uses(x, uses, true, in_loop(weight));
+}
+
+void typcase_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    expr->count_uses(x, uses, false, weight);
+    for (int i = cases->first(); cases->more(i); i = cases->next(i)) {
+        branch_class* branch = (branch_class*)cases->nth(i);
+        if (branch->name != x)
+            branch->expr->count_uses(x, uses, false, weight);
+    }
+}
+
+void block_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    for (int i = body->first(); body->more(i); i = body->next(i))
+        body->nth(i)->count_uses(x, uses, body->more(body->next(i)) || raw,
+                                 weight);
+}
+
+void let_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    init->count_uses(x, uses, is_raw_type(type_decl), weight);
+    if (identifier != x)
+        body->count_uses(x, uses, raw, weight);
+}
+
+void plus_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void sub_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void mul_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void divide_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void neg_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+}
+
+void lt_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void eq_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    // only Ints and Bools are compared by value
+    e1->count_uses(x, uses, is_raw_type(e1->type), weight);
+    e2->count_uses(x, uses, is_raw_type(e2->type), weight);
+}
+
+void leq_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+    e2->count_uses(x, uses, true, weight);
+}
+
+void comp_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, true, weight);
+}
+
+void int_const_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {}
+
+void bool_const_class::count_uses(Symbol x, VarUses& uses, bool raw,
+                                  int weight) {}
+
+void string_const_class::count_uses(Symbol x, VarUses& uses, bool raw,
+                                    int weight) {}
+
+void new__class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {}
+
+void isvoid_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    e1->count_uses(x, uses, false, weight);
+}
+
+void no_expr_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {}
+
+void object_class::count_uses(Symbol x, VarUses& uses, bool raw, int weight) {
+    if (name == x) {
+        if (raw)
+            uses.raw += weight;
+        else
+            uses.boxed += weight;
+    }
+}
@@ -15,8 +15,7 @@
 #include "map"
 #include "list"
 
-enum FeatureType { methodFeature, attrFeature };
-enum StorePos { STACK, ATTRIBUTE };
+enum StorePos { STACK, ATTRIBUTE, REGISTER };
 
 // define the class for phylum
 // define simple phylum - Program
@@ -49,9 +48,6 @@ class Class__class : public tree_node {
 typedef class Feature_class* Feature;
 
 class Feature_class : public tree_node {
-  public:
-    FeatureType feature_type;
-
   public:
     tree_node* copy() { return copy_Feature(); }
     virtual Feature copy_Feature() = 0;
@@ -78,8 +74,9 @@ class Formal_class : public tree_node {
 typedef class Expression_class* Expression;
 typedef struct VarInfo {
     StorePos storePos; // where the Var is stored 
-    int pos; // stack pos w.r.t. frame pointer if storePos=STACK, attribute offset if storePos=ATTRIBUTE
+    int pos; // stack pos w.r.t. frame pointer if storePos=STACK, attribute offset if storePos=ATTRIBUTE, virtual register if storePos=REGISTER
     bool isFormal; // true if variable is a formal param, false otherwise
+    bool unboxed = false; // Int or Bool held as a raw word (-O)
     Formal detail;
 } VarInfo;
 
@@ -143,7 +140,7 @@ class program_class : public Program_class {
     Classes classes;
 
   public:
-    program_class(Classes a1) { classes = a1; }
+    program_class(Classes a1) { kind = AST_program; classes = a1; }
     Program copy_Program();
     void dump(ostream& stream, int n);
 
@@ -165,6 +162,7 @@ class class__class : public Class__class {
 
   public:
     class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+        kind = AST_class_;
         name = a1;
         parent = a2;
         features = a3;
@@ -195,15 +193,15 @@ class method_class : public Feature_class {
 
   public:
     method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+        kind = AST_method;
         name = a1;
         formals = a2;
         return_type = a3;
         expr = a4;
-        feature_type = methodFeature;
     }
     Feature copy_Feature();
     void dump(ostream& stream, int n);
-    void code(ostream& stream);
+    void code(AsmWriter& stream);
 
 #ifdef Feature_SHARED_EXTRAS
     Feature_SHARED_EXTRAS
@@ -223,10 +221,10 @@ class attr_class : public Feature_class {
 
   public:
     attr_class(Symbol a1, Symbol a2, Expression a3) {
+        kind = AST_attr;
         name = a1;
         type_decl = a2;
         init = a3;
-        feature_type = attrFeature;
     }
     Feature copy_Feature();
     void dump(ostream& stream, int n);
@@ -247,6 +245,7 @@ class formal_class : public Formal_class {
 
   public:
     formal_class(Symbol a1, Symbol a2) {
+        kind = AST_formal;
         name = a1;
         type_decl = a2;
     }
@@ -270,6 +269,7 @@ class branch_class : public Case_class {
 
   public:
     branch_class(Symbol a1, Symbol a2, Expression a3) {
+        kind = AST_branch;
         name = a1;
         type_decl = a2;
         expr = a3;
@@ -293,6 +293,7 @@ class assign_class : public Expression_class {
 
   public:
     assign_class(Symbol a1, Expression a2) {
+        kind = AST_assign;
         name = a1;
         expr = a2;
     }
@@ -317,6 +318,7 @@ class static_dispatch_class : public Expression_class {
 
   public:
     static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+        kind = AST_static_dispatch;
         expr = a1;
         type_name = a2;
         name = a3;
@@ -342,6 +344,7 @@ class dispatch_class : public Expression_class {
 
   public:
     dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+        kind = AST_dispatch;
         expr = a1;
         name = a2;
         actual = a3;
@@ -366,6 +369,7 @@ class cond_class : public Expression_class {
 
   public:
     cond_class(Expression a1, Expression a2, Expression a3) {
+        kind = AST_cond;
         pred = a1;
         then_exp = a2;
         else_exp = a3;
@@ -389,6 +393,7 @@ class loop_class : public Expression_class {
 
   public:
     loop_class(Expression a1, Expression a2) {
+        kind = AST_loop;
         pred = a1;
         body = a2;
     }
@@ -411,6 +416,7 @@ class typcase_class : public Expression_class {
 
   public:
     typcase_class(Expression a1, Cases a2) {
+        kind = AST_typcase;
         expr = a1;
         cases = a2;
     }
@@ -431,7 +437,7 @@ class block_class : public Expression_class {
     Expressions body;
 
   public:
-    block_class(Expressions a1) { body = a1; }
+    block_class(Expressions a1) { kind = AST_block; body = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -453,6 +459,7 @@ class let_class : public Expression_class {
 
   public:
     let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+        kind = AST_let;
         identifier = a1;
         type_decl = a2;
         init = a3;
@@ -477,6 +484,7 @@ class plus_class : public Expression_class {
 
   public:
     plus_class(Expression a1, Expression a2) {
+        kind = AST_plus;
         e1 = a1;
         e2 = a2;
     }
@@ -499,6 +507,7 @@ class sub_class : public Expression_class {
 
   public:
     sub_class(Expression a1, Expression a2) {
+        kind = AST_sub;
         e1 = a1;
         e2 = a2;
     }
@@ -521,6 +530,7 @@ class mul_class : public Expression_class {
 
   public:
     mul_class(Expression a1, Expression a2) {
+        kind = AST_mul;
         e1 = a1;
         e2 = a2;
     }
@@ -543,6 +553,7 @@ class divide_class : public Expression_class {
 
   public:
     divide_class(Expression a1, Expression a2) {
+        kind = AST_divide;
         e1 = a1;
         e2 = a2;
     }
@@ -563,7 +574,7 @@ class neg_class : public Expression_class {
     Expression e1;
 
   public:
-    neg_class(Expression a1) { e1 = a1; }
+    neg_class(Expression a1) { kind = AST_neg; e1 = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -583,6 +594,7 @@ class lt_class : public Expression_class {
 
   public:
     lt_class(Expression a1, Expression a2) {
+        kind = AST_lt;
         e1 = a1;
         e2 = a2;
     }
@@ -605,6 +617,7 @@ class eq_class : public Expression_class {
 
   public:
     eq_class(Expression a1, Expression a2) {
+        kind = AST_eq;
         e1 = a1;
         e2 = a2;
     }
@@ -627,6 +640,7 @@ class leq_class : public Expression_class {
 
   public:
     leq_class(Expression a1, Expression a2) {
+        kind = AST_leq;
         e1 = a1;
         e2 = a2;
     }
@@ -647,7 +661,7 @@ class comp_class : public Expression_class {
     Expression e1;
 
   public:
-    comp_class(Expression a1) { e1 = a1; }
+    comp_class(Expression a1) { kind = AST_comp; e1 = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -665,7 +679,7 @@ class int_const_class : public Expression_class {
     Symbol token;
 
   public:
-    int_const_class(Symbol a1) { token = a1; }
+    int_const_class(Symbol a1) { kind = AST_int_const; token = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -683,7 +697,7 @@ class bool_const_class : public Expression_class {
     Boolean val;
 
   public:
-    bool_const_class(Boolean a1) { val = a1; }
+    bool_const_class(Boolean a1) { kind = AST_bool_const; val = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -701,7 +715,7 @@ class string_const_class : public Expression_class {
     Symbol token;
 
   public:
-    string_const_class(Symbol a1) { token = a1; }
+    string_const_class(Symbol a1) { kind = AST_string_const; token = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -719,7 +733,7 @@ class new__class : public Expression_class {
     Symbol type_name;
 
   public:
-    new__class(Symbol a1) { type_name = a1; }
+    new__class(Symbol a1) { kind = AST_new_; type_name = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -737,7 +751,7 @@ class isvoid_class : public Expression_class {
     Expression e1;
 
   public:
-    isvoid_class(Expression a1) { e1 = a1; }
+    isvoid_class(Expression a1) { kind = AST_isvoid; e1 = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -753,7 +767,7 @@ class isvoid_class : public Expression_class {
 class no_expr_class : public Expression_class {
   public:
   public:
-    no_expr_class() {}
+    no_expr_class() { kind = AST_no_expr; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
@@ -771,7 +785,7 @@ class object_class : public Expression_class {
     Symbol name;
 
   public:
-    object_class(Symbol a1) { name = a1; }
+    object_class(Symbol a1) { kind = AST_object; name = a1; }
     Expression copy_Expression();
     void dump(ostream& stream, int n);
 
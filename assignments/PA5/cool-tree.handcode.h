@@ -8,6 +8,9 @@
 #include "tree.h"
 #include "cool.h"
 #include "stringtab.h"
+
+class InstrList;
+struct VarUses;
 #define yylineno curr_lineno;
 extern int yylineno;
 
@@ -20,6 +23,8 @@ void dump_Symbol(ostream& stream, int padding, Symbol b);
 void assert_Symbol(Symbol b);
 Symbol copy_Symbol(Symbol b);
 
+class AstWriter;
+
 class Program_class;
 typedef Program_class *Program;
 class Class__class;
@@ -45,65 +50,98 @@ typedef list_node<Case> Cases_class;
 typedef Cases_class *Cases;
 
 #define Program_EXTRAS                          \
-virtual void cgen(ostream&) = 0;		\
-virtual void dump_with_types(ostream&, int) = 0; 
+virtual void cgen(AsmWriter&) = 0;		\
+virtual void dump_with_types(ostream&, int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 
 #define program_EXTRAS                          \
-void cgen(ostream&);     			\
-void dump_with_types(ostream&, int);            
+void cgen(AsmWriter&);   			\
+void dump_with_types(ostream&, int);            \
+void dump_binary(AstWriter&);
 
 #define Class__EXTRAS                   \
 virtual Symbol get_name() = 0;  	\
 virtual Symbol get_parent() = 0;    	\
 virtual Symbol get_filename() = 0;      \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define class__EXTRAS                                  \
 Symbol get_name()   { return name; }		       \
 Symbol get_parent() { return parent; }     	       \
 Symbol get_filename() { return filename; }             \
-void dump_with_types(ostream&,int);                    
+void dump_with_types(ostream&,int);                    \
+void dump_binary(AstWriter&);
 
 
 #define Feature_EXTRAS                                        \
-virtual void dump_with_types(ostream&,int) = 0; 
+virtual void dump_with_types(ostream&,int) = 0;               \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define Feature_SHARED_EXTRAS                                       \
-void dump_with_types(ostream&,int);    
+void dump_with_types(ostream&,int);                                 \
+void dump_binary(AstWriter&);
 
 
 #define Formal_EXTRAS                              \
-virtual void dump_with_types(ostream&,int) = 0;
+virtual void dump_with_types(ostream&,int) = 0;    \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define formal_EXTRAS                           \
-void dump_with_types(ostream&,int);
+void dump_with_types(ostream&,int);             \
+void dump_binary(AstWriter&);
 
 
 #define Case_EXTRAS                             \
-virtual void dump_with_types(ostream& ,int) = 0;
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
 
 
 #define branch_EXTRAS                                   \
-void dump_with_types(ostream& ,int);
+void dump_with_types(ostream& ,int);                    \
+void dump_binary(AstWriter&);
 
 
 #define Expression_EXTRAS                    \
 Symbol type;                                 \
 Symbol get_type() { return type; }           \
 Expression set_type(Symbol s) { type = s; return this; } \
-virtual void code(ostream&) = 0; \
-virtual void dump_with_types(ostream&,int) = 0;  \
+virtual void code(InstrList&) = 0; \
+virtual void code_unboxed(InstrList&); \
+virtual void count_uses(Symbol, VarUses&, bool, int) = 0; \
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;    \
 void dump_type(ostream&, int);               \
 Expression_class() { type = (Symbol) NULL; }
 
 #define Expression_SHARED_EXTRAS           \
-void code(ostream&); 			   \
-void dump_with_types(ostream&,int); 
-
+void code(InstrList&); 			   \
+void count_uses(Symbol, VarUses&, bool, int); \
+void dump_with_types(ostream&,int);        \
+void dump_binary(AstWriter&);
+
+
+// the expressions with their own code for an unboxed value
+#define assign_EXTRAS void code_unboxed(InstrList&);
+#define cond_EXTRAS void code_unboxed(InstrList&); void code_cond(InstrList&, bool);
+#define block_EXTRAS void code_unboxed(InstrList&);
+#define let_EXTRAS void code_unboxed(InstrList&); void code_let(InstrList&, bool);
+#define plus_EXTRAS void code_unboxed(InstrList&);
+#define sub_EXTRAS void code_unboxed(InstrList&);
+#define mul_EXTRAS void code_unboxed(InstrList&);
+#define divide_EXTRAS void code_unboxed(InstrList&);
+#define neg_EXTRAS void code_unboxed(InstrList&);
+#define lt_EXTRAS void code_unboxed(InstrList&);
+#define eq_EXTRAS void code_unboxed(InstrList&);
+#define leq_EXTRAS void code_unboxed(InstrList&);
+#define comp_EXTRAS void code_unboxed(InstrList&);
+#define int_const_EXTRAS void code_unboxed(InstrList&);
+#define bool_const_EXTRAS void code_unboxed(InstrList&);
+#define object_EXTRAS void code_unboxed(InstrList&);
 
 #endif
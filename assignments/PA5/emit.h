@@ -97,6 +97,10 @@
 #define MUL   "\tmul\t"
 #define SUB   "\tsub\t"
 #define SLL   "\tsll\t"
+#define SLT   "\tslt\t"
+#define SEQ   "\tseq\t"
+#define XORI  "\txori\t"
+#define ORI   "\tori\t"
 #define BEQZ  "\tbeqz\t"
 #define BRANCH   "\tb\t"
 #define BEQ      "\tbeq\t"
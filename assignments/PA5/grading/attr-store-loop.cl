@@ -0,0 +1,21 @@
+(*  Stores to attributes in a loop that hardly allocates.  Only the
+ *  generational collector may be told about the stores: under the
+ *  default collector, recording them takes heap space that is never
+ *  given back.
+ *)
+class Main inherits IO {
+    a : Bool;
+    b : Bool;
+    c : Bool;
+    d : Bool;
+    i : Int;
+    main() : Object {{
+        while i < 20000 loop {
+            a <- true; b <- a; c <- b; d <- c;
+            a <- false; b <- a; c <- b; d <- c;
+            i <- i + 1;
+        } pool;
+        out_int(i);
+        out_string("\n");
+    }};
+};
@@ -0,0 +1,31 @@
+(*  Sums that run through addresses inside the heap, computed while
+ *  the Int that will hold them is allocated.  The collector (-g) must
+ *  neither take them for objects nor change them.
+ *)
+class Main inherits IO {
+    main() : Object {
+        let base : Int <- 268435456,     (* 0x10000000, the data segment *)
+            a : Int <- base,
+            b : Int <- base,
+            c : Int <- base,
+            d : Int <- base,
+            n : Int <- 0
+        in {
+            while n < 30000 loop {
+                a <- a + 4;
+                b <- b + 16;
+                c <- c + 64;
+                d <- d + 256;
+                n <- n + 1;
+            } pool;
+            out_int((a - base) / 4);
+            out_string(" ");
+            out_int((b - base) / 16);
+            out_string(" ");
+            out_int((c - base) / 64);
+            out_string(" ");
+            out_int((d - base) / 256);
+            out_string("\n");
+        }
+    };
+};
@@ -0,0 +1,44 @@
+(*  Int values kept raw under -O in callee-saved registers and spill
+ *  slots, live across calls that allocate, while they run through
+ *  addresses inside the heap.  The collector (-g) scans those
+ *  registers and the stack, and must neither take the values for
+ *  objects nor change them.
+ *)
+class Cell {
+    v : Int;
+    get() : Int { v };
+    set(x : Int) : Cell {{ v <- x; self; }};
+};
+
+class Main inherits IO {
+    step(k : Int) : Int { (new Cell).set(k).get() };
+
+    main() : Object {
+        let base : Int <- 268435456,     (* 0x10000000, the data segment *)
+            a : Int <- base,
+            b : Int <- base,
+            c : Int <- base,
+            d : Int <- base,
+            n : Int <- 0,
+            cells : Cell
+        in {
+            while n < 12000 loop {
+                cells <- new Cell;
+                cells.set(a);
+                a <- a + step(4);
+                b <- b + step(16);
+                c <- c + step(64);
+                d <- d + step(256);
+                n <- n + 1;
+            } pool;
+            out_int((a - base) / 4);
+            out_string(" ");
+            out_int((b - base) / 16);
+            out_string(" ");
+            out_int((c - base) / 64);
+            out_string(" ");
+            out_int((d - base) / 256);
+            out_string("\n");
+        }
+    };
+};
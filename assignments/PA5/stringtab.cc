@@ -7,6 +7,7 @@
 #include <assert.h>
 #include "stringtab_functions.h"
 #include "stringtab.h"
+#include "arena.h"
 
 extern char *pad(int n);
 
@@ -19,14 +20,12 @@ template class StringTable<StringEntry>;
 template class StringTable<IntEntry>;
 
 Entry::Entry(char *s, int l, int i) : len(l), index(i) {
-  str = new char [len+1];
-  strncpy(str, s, len);
-  str[len] = '\0';
+  str = string_arena.copy_string(s, len);
 }
 
 int Entry::equal_string(char *string, int length) const
 {
-  return (len == length) && (strncmp(str,string,len) == 0);
+  return (len == length) && (memcmp(str,string,len) == 0);
 }
 
 ostream& Entry::print(ostream& s) const
@@ -77,3 +76,22 @@ IntEntry::IntEntry(char *s, int l, int i) : Entry(s,l,i) { }
 IdTable idtable;
 IntTable inttable;
 StrTable stringtable;
+
+//
+// Each thread's current task and the number of strings it has added to
+// any table since, which together order the strings added during a
+// concurrent section.
+//
+static thread_local unsigned long long intern_task_order = 0;
+
+std::mutex intern_arena_lock;
+
+void intern_task(unsigned task)
+{
+  intern_task_order = (unsigned long long) task << 32;
+}
+
+unsigned long long intern_order()
+{
+  return intern_task_order++;
+}
@@ -0,0 +1,431 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  bench.cc
+//
+//  coolbench times the phases of the compiler.  It either compiles the
+//  files named on the command line or writes a synthetic program whose
+//  shape is set by the options below, and runs
+//
+//     lex      the scanner alone over all the input, counting tokens
+//     parse    the parser, which lexes the input again
+//     semant   the semantic analyzer
+//     cgen     the code generator, writing to /dev/null unless -o is given
+//
+//  in one process, as coolc does.  For each phase it prints the time,
+//  the throughput (tokens per second for the lexer, AST nodes per second
+//  for the rest), and the peak resident set size of the process so far.
+//  The last line covers parse, semant and cgen together, which is the
+//  work coolc does.
+//
+//  The generator's options, with their defaults:
+//
+//     -n 200    classes
+//     -d 5      depth of each inheritance chain
+//     -m 10     methods per class
+//     -l 20     variables bound by the let in each method
+//     -e 30     nesting depth of the expression in each method
+//     -k 1000   Int and String attributes in the constant pool class
+//
+//  -w file saves the generated program.  -r n repeats the lex pass n
+//  times and reports the fastest.  -j n checks classes on n threads, as
+//  coolc -j does.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <string>
+#include "cool-io.h"  //includes iostream
+#include "cool-tree.h"
+#include "cool-parse.h"
+#include "astbinary.h"
+#include "asmwriter.h"
+
+char *curr_filename = "<stdin>";
+FILE *fin;                    // the lexer reads its input from this file
+
+extern int curr_lineno;
+extern int yy_flex_debug;
+extern Program ast_root;
+extern int omerrs;
+extern int compile_jobs;      // threads semant checks classes on (-j)
+
+extern int cool_yylex();
+extern int cool_yyparse();
+extern int cool_map_file(FILE *f);
+
+static int file_index;        // as in coolc.cc
+static int file_count;
+static char **file_names;
+
+static int open_next_file()
+{
+    if (fin != NULL) {
+	fclose(fin);
+	fin = NULL;
+    }
+    if (file_index >= file_count)
+	return 0;
+
+    curr_filename = file_names[file_index++];
+    fin = fopen(curr_filename, "r");
+    if (fin == NULL) {
+	cerr << "Could not open input file " << curr_filename << endl;
+	exit(1);
+    }
+    curr_lineno = 1;
+    cool_map_file(fin);
+    return 1;
+}
+
+extern "C" int yywrap()
+{
+    return open_next_file() ? 0 : 1;
+}
+
+// start the lexer over at the first input file
+static void rewind_input(int first)
+{
+    file_index = first;
+    open_next_file();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  The program generator
+//
+//  Class Ci inherits from C(i-1), except that every d'th class starts a
+//  new chain under Object.  Each class has an attribute and the methods
+//  f0 .. f(m-1), all taking and returning Ints, so each class overrides
+//  the methods of the one above it.  A method body is a let binding l
+//  variables around an expression nested e deep, which mixes arithmetic,
+//  comparisons, conditionals and dispatches to the other methods.  Class
+//  Constants holds the constant pool, and Main makes one of everything.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+struct GenParams {
+    int classes, depth, methods, lets, nesting, pool;
+};
+
+static void leaf(std::string& s, int cls, int n, int lets)
+{
+    char buf[32];
+    switch (n % 5) {
+    case 0: s += "x"; break;
+    case 1: s += "y"; break;
+    case 2: snprintf(buf, sizeof buf, "a%d", cls); s += buf; break;
+    case 3:
+	if (lets > 0) {
+	    snprintf(buf, sizeof buf, "v%d", n % lets);
+	    s += buf;
+	    break;
+	}
+	// fall through
+    default: snprintf(buf, sizeof buf, "%d", n * 7 % 1000); s += buf; break;
+    }
+}
+
+static void nested(std::string& s, const GenParams& g, int cls, int meth, int d)
+{
+    if (d == 0) {
+	leaf(s, cls, meth, g.lets);
+	return;
+    }
+    char buf[64];
+    switch (d % 6) {
+    case 0:
+	s += "(";
+	nested(s, g, cls, meth, d - 1);
+	s += " + ";
+	leaf(s, cls, d, g.lets);
+	s += ")";
+	break;
+    case 1:
+	s += "(";
+	nested(s, g, cls, meth, d - 1);
+	s += " * ";
+	leaf(s, cls, d + 1, g.lets);
+	s += ")";
+	break;
+    case 2:
+	s += "(if ";
+	leaf(s, cls, d, g.lets);
+	s += " < ";
+	leaf(s, cls, d + 2, g.lets);
+	s += " then ";
+	nested(s, g, cls, meth, d - 1);
+	s += " else ";
+	leaf(s, cls, d + 3, g.lets);
+	s += " fi)";
+	break;
+    case 3:
+	snprintf(buf, sizeof buf, "f%d(", (meth + d) % g.methods);
+	s += buf;
+	nested(s, g, cls, meth, d - 1);
+	s += ", ";
+	leaf(s, cls, d, g.lets);
+	s += ")";
+	break;
+    case 4:
+	s += "(";
+	leaf(s, cls, d + 1, g.lets);
+	s += " - ~";
+	nested(s, g, cls, meth, d - 1);
+	s += ")";
+	break;
+    default:
+	s += "{ ";
+	leaf(s, cls, d, g.lets);
+	s += " = ";
+	leaf(s, cls, d + 4, g.lets);
+	s += "; ";
+	nested(s, g, cls, meth, d - 1);
+	s += "; }";
+	break;
+    }
+}
+
+static std::string generate(const GenParams& g)
+{
+    std::string s;
+    char buf[128];
+
+    s += "(* generated by coolbench *)\n\n";
+    for (int c = 0; c < g.classes; c++) {
+	if (c % g.depth == 0)
+	    snprintf(buf, sizeof buf, "class C%d {\n", c);
+	else
+	    snprintf(buf, sizeof buf, "class C%d inherits C%d {\n", c, c - 1);
+	s += buf;
+	snprintf(buf, sizeof buf, "  a%d : Int <- %d;\n", c, c);
+	s += buf;
+	for (int m = 0; m < g.methods; m++) {
+	    snprintf(buf, sizeof buf, "  -- method %d of class %d\n", m, c);
+	    s += buf;
+	    snprintf(buf, sizeof buf, "  f%d(x : Int, y : Int) : Int {\n", m);
+	    s += buf;
+	    if (g.lets > 0) {
+		s += "    let";
+		for (int v = 0; v < g.lets; v++) {
+		    snprintf(buf, sizeof buf, "%s\n      v%d : Int <- ",
+			     v == 0 ? "" : ",", v);
+		    s += buf;
+		    if (v == 0)
+			s += "x";
+		    else {
+			snprintf(buf, sizeof buf, "v%d + %d", v - 1, v);
+			s += buf;
+		    }
+		}
+		s += "\n    in\n      ";
+	    } else
+		s += "    ";
+	    nested(s, g, c, m, g.nesting);
+	    s += "\n  };\n";
+	}
+	s += "};\n\n";
+    }
+
+    s += "(* the constant pool *)\nclass Constants {\n";
+    for (int k = 0; k < g.pool; k++) {
+	snprintf(buf, sizeof buf, "  i%d : Int <- %d;\n", k, 1000000 + k);
+	s += buf;
+	if (k % 8 == 7)
+	    snprintf(buf, sizeof buf,
+		     "  s%d : String <- \"pool string %d\\n\\twith \\\"escapes\\\"\";\n",
+		     k, k);
+	else
+	    snprintf(buf, sizeof buf,
+		     "  s%d : String <- \"pool string %d of the generated program\";\n",
+		     k, k);
+	s += buf;
+    }
+    s += "};\n\n";
+
+    s += "class Main inherits IO {\n  consts : Constants <- new Constants;\n";
+    s += "  main() : Object {\n    {\n";
+    for (int c = 0; c < g.classes; c++) {
+	snprintf(buf, sizeof buf, "      out_int((new C%d).f0(%d, 1));\n", c, c);
+	s += buf;
+    }
+    s += "    }\n  };\n};\n";
+    return s;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Measurement
+//
+//////////////////////////////////////////////////////////////////////////////
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// the high-water mark of the resident set, in kilobytes
+static long peak_rss()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static void report(const char *phase, double secs, double count, const char *unit)
+{
+    char buf[128];
+    snprintf(buf, sizeof buf, "%-8s %10.4f s %14.0f %-9s %10ld KB\n",
+	     phase, secs, secs > 0 ? count / secs : 0.0, unit, peak_rss());
+    cout << buf;
+}
+
+static void usage()
+{
+    cerr << "usage: coolbench [-n classes] [-d depth] [-m methods] [-l lets]\n"
+	 << "                 [-e nesting] [-k pool] [-r repeats] [-w file]\n"
+	 << "                 [-o file] [-j threads] [file.cl ...]" << endl;
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    GenParams g = { 200, 5, 10, 20, 30, 1000 };
+    int repeats = 1;
+    char *save_name = NULL;
+    char *asm_name = "/dev/null";
+    int c;
+
+    compile_jobs = 1;
+    while ((c = getopt(argc, argv, "n:d:m:l:e:k:r:w:o:j:")) != -1) {
+	switch (c) {
+	case 'n': g.classes = atoi(optarg); break;
+	case 'd': g.depth = atoi(optarg); break;
+	case 'm': g.methods = atoi(optarg); break;
+	case 'l': g.lets = atoi(optarg); break;
+	case 'e': g.nesting = atoi(optarg); break;
+	case 'k': g.pool = atoi(optarg); break;
+	case 'r': repeats = atoi(optarg); break;
+	case 'w': save_name = optarg; break;
+	case 'o': asm_name = optarg; break;
+	case 'j': compile_jobs = atoi(optarg); break;
+	default: usage();
+	}
+    }
+    if (g.classes < 1 || g.depth < 1 || g.methods < 1 || g.lets < 0 ||
+	g.nesting < 0 || g.pool < 0 || repeats < 1 || compile_jobs < 1)
+	usage();
+    yy_flex_debug = 0;
+
+    //
+    // Without file arguments, compile a generated program; it goes in a
+    // temporary file unless -w names one.
+    //
+    char tmp_name[] = "/tmp/coolbenchXXXXXX";
+    char *gen_argv[1];
+    int first = optind;
+    if (optind == argc) {
+	std::string prog = generate(g);
+	FILE *out;
+	if (save_name != NULL)
+	    out = fopen(save_name, "w");
+	else {
+	    int fd = mkstemp(tmp_name);
+	    out = fd < 0 ? NULL : fdopen(fd, "w");
+	    save_name = tmp_name;
+	}
+	if (out == NULL || fwrite(prog.data(), 1, prog.size(), out) != prog.size()) {
+	    cerr << "Cannot write " << save_name << endl;
+	    exit(1);
+	}
+	fclose(out);
+	gen_argv[0] = save_name;
+	file_names = gen_argv;
+	file_count = 1;
+	first = 0;
+	cout << "generated " << save_name << ": " << g.classes << " classes, depth "
+	     << g.depth << ", " << g.methods << " methods, " << g.lets << " lets, nesting "
+	     << g.nesting << ", pool " << g.pool << endl;
+    } else {
+	file_names = argv;
+	file_count = argc;
+    }
+
+    long bytes = 0;
+    for (int i = first; i < file_count; i++) {
+	FILE *f = fopen(file_names[i], "r");
+	if (f == NULL) {
+	    cerr << "Could not open input file " << file_names[i] << endl;
+	    exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	bytes += ftell(f);
+	fclose(f);
+    }
+
+    // as in coolc, the string table starts with the first file's name
+    stringtable.add_string(file_names[first]);
+
+    double best = 0;
+    long tokens = 0;
+    for (int r = 0; r < repeats; r++) {
+	rewind_input(first);
+	double start = now();
+	long n = 0;
+	while (cool_yylex() != 0)
+	    n++;
+	double secs = now() - start;
+	if (r == 0 || secs < best)
+	    best = secs;
+	tokens = n;
+    }
+
+    rewind_input(first);
+    double start = now();
+    cool_yyparse();
+    double parse_secs = now() - start;
+    if (omerrs != 0) {
+	cerr << "Compilation halted due to lex and parse errors\n";
+	exit(1);
+    }
+    AstWriter w;
+    ast_root->dump_binary(w);
+    double nodes = w.nodes();
+
+    cout << bytes << " bytes, " << tokens << " tokens, " << w.nodes() << " nodes\n";
+    cout << "phase          time             rate             peak RSS\n";
+    report("lex", best, tokens, "tokens/s");
+    report("parse", parse_secs, nodes, "nodes/s");
+
+    start = now();
+    ast_root->semant();
+    double semant_secs = now() - start;
+    report("semant", semant_secs, nodes, "nodes/s");
+
+    AsmWriter s(asm_name);
+    if (!s.ok()) {
+	cerr << "Cannot open output file " << asm_name << endl;
+	exit(1);
+    }
+    start = now();
+    ast_root->cgen(s);
+    s.flush();
+    double cgen_secs = now() - start;
+    report("cgen", cgen_secs, nodes, "nodes/s");
+    report("total", parse_secs + semant_secs + cgen_secs, nodes, "nodes/s");
+
+    if (save_name == tmp_name)
+	unlink(tmp_name);
+    return 0;
+}
@@ -0,0 +1,169 @@
+//
+// The following include files must come first.
+
+#ifndef COOL_TREE_HANDCODE_H
+#define COOL_TREE_HANDCODE_H
+
+#include <iostream>
+#include "tree.h"
+#include "cool.h"
+#include "stringtab.h"
+
+class InstrList;
+struct VarUses;
+#define yylineno curr_lineno;
+extern int yylineno;
+
+inline Boolean copy_Boolean(Boolean b) {return b; }
+inline void assert_Boolean(Boolean) {}
+inline void dump_Boolean(ostream& stream, int padding, Boolean b)
+	{ stream << pad(padding) << (int) b << "\n"; }
+
+void dump_Symbol(ostream& stream, int padding, Symbol b);
+void assert_Symbol(Symbol b);
+Symbol copy_Symbol(Symbol b);
+
+class AstWriter;
+
+class Program_class;
+typedef Program_class *Program;
+class Class__class;
+typedef Class__class *Class_;
+class Feature_class;
+typedef Feature_class *Feature;
+class Formal_class;
+typedef Formal_class *Formal;
+class Expression_class;
+typedef Expression_class *Expression;
+class Case_class;
+typedef Case_class *Case;
+
+typedef list_node<Class_> Classes_class;
+typedef Classes_class *Classes;
+typedef list_node<Feature> Features_class;
+typedef Features_class *Features;
+typedef list_node<Formal> Formals_class;
+typedef Formals_class *Formals;
+typedef list_node<Expression> Expressions_class;
+typedef Expressions_class *Expressions;
+typedef list_node<Case> Cases_class;
+typedef Cases_class *Cases;
+
+// coolc links the semantic analyzer in with the code generator, so the
+// AST classes of PA5 also get the members semant.cc uses
+#include "semant-tree.h"
+
+#define Program_EXTRAS                          \
+Program_SEMANT_EXTRAS                           \
+virtual void semant() = 0;			\
+virtual void cgen(AsmWriter&) = 0;		\
+virtual void dump_with_types(ostream&, int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
+
+
+
+#define program_EXTRAS                          \
+program_SEMANT_EXTRAS                           \
+void semant();     				\
+void cgen(AsmWriter&);   			\
+void dump_with_types(ostream&, int);            \
+void dump_binary(AstWriter&);
+
+#define Class__EXTRAS                   \
+Class__SEMANT_EXTRAS                    \
+virtual Symbol get_name() = 0;  	\
+virtual Symbol get_parent() = 0;    	\
+virtual Symbol get_filename() = 0;      \
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
+
+
+#define class__EXTRAS                                  \
+class__SEMANT_EXTRAS                                   \
+Symbol get_name()   { return name; }		       \
+Symbol get_parent() { return parent; }     	       \
+Symbol get_filename() { return filename; }             \
+void dump_with_types(ostream&,int);                    \
+void dump_binary(AstWriter&);
+
+
+#define Feature_EXTRAS                                        \
+Feature_SEMANT_EXTRAS                                         \
+virtual void dump_with_types(ostream&,int) = 0;               \
+virtual void dump_binary(AstWriter&) = 0;
+
+
+#define Feature_SHARED_EXTRAS                                       \
+void dump_with_types(ostream&,int);                                 \
+void dump_binary(AstWriter&);
+
+#define method_EXTRAS method_SEMANT_EXTRAS
+#define attr_EXTRAS attr_SEMANT_EXTRAS
+
+
+
+
+
+#define Formal_EXTRAS                              \
+Formal_SEMANT_EXTRAS                               \
+virtual void dump_with_types(ostream&,int) = 0;    \
+virtual void dump_binary(AstWriter&) = 0;
+
+
+#define formal_EXTRAS                           \
+formal_SEMANT_EXTRAS                            \
+void dump_with_types(ostream&,int);             \
+void dump_binary(AstWriter&);
+
+
+#define Case_EXTRAS                             \
+Case_SEMANT_EXTRAS                              \
+virtual void dump_with_types(ostream& ,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;
+
+
+#define branch_EXTRAS                                   \
+branch_SEMANT_EXTRAS                                    \
+void dump_with_types(ostream& ,int);                    \
+void dump_binary(AstWriter&);
+
+
+#define Expression_EXTRAS                    \
+Expression_SEMANT_EXTRAS                     \
+Symbol type;                                 \
+Symbol get_type() { return type; }           \
+Expression set_type(Symbol s) { type = s; return this; } \
+virtual void code(InstrList&) = 0; \
+virtual void code_unboxed(InstrList&); \
+virtual void count_uses(Symbol, VarUses&, bool, int) = 0; \
+virtual void dump_with_types(ostream&,int) = 0; \
+virtual void dump_binary(AstWriter&) = 0;    \
+void dump_type(ostream&, int);               \
+Expression_class() { type = (Symbol) NULL; }
+
+#define Expression_SHARED_EXTRAS           \
+Expression_SHARED_SEMANT_EXTRAS            \
+void code(InstrList&); 			   \
+void count_uses(Symbol, VarUses&, bool, int); \
+void dump_with_types(ostream&,int);        \
+void dump_binary(AstWriter&);
+
+// the expressions with their own code for an unboxed value
+#define assign_EXTRAS void code_unboxed(InstrList&);
+#define cond_EXTRAS void code_unboxed(InstrList&); void code_cond(InstrList&, bool);
+#define block_EXTRAS void code_unboxed(InstrList&);
+#define let_EXTRAS void code_unboxed(InstrList&); void code_let(InstrList&, bool);
+#define plus_EXTRAS void code_unboxed(InstrList&);
+#define sub_EXTRAS void code_unboxed(InstrList&);
+#define mul_EXTRAS void code_unboxed(InstrList&);
+#define divide_EXTRAS void code_unboxed(InstrList&);
+#define neg_EXTRAS void code_unboxed(InstrList&);
+#define lt_EXTRAS void code_unboxed(InstrList&);
+#define eq_EXTRAS void code_unboxed(InstrList&);
+#define leq_EXTRAS void code_unboxed(InstrList&);
+#define comp_EXTRAS void code_unboxed(InstrList&);
+#define int_const_EXTRAS void code_unboxed(InstrList&);
+#define bool_const_EXTRAS void code_unboxed(InstrList&);
+#define object_EXTRAS void code_unboxed(InstrList&);
+
+#endif
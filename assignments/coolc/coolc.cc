@@ -0,0 +1,421 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  coolc.cc
+//
+//  The whole compiler in one process.  The source files named on the
+//  command line are lexed and parsed into a single Program, which is
+//  handed directly to the semantic analyzer and then the code generator.
+//  This does the same job as `mycoolc', which runs the four phases as a
+//  pipeline and passes the program between them as text.
+//
+//  With -j n the files are parsed in n worker processes instead; see
+//  parse_in_parallel below.  The semantic analyzer then checks the
+//  classes on n threads (see ClassTable::checkClasses).
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <sstream>
+#include "cool-io.h"  //includes iostream
+#include "cool-tree.h"
+#include "cool-parse.h"
+#include "cgen_gc.h"
+#include "astbinary.h"
+#include "asmwriter.h"
+
+//
+// These globals keep everything working.
+//
+char *curr_filename = "<stdin>";
+FILE *fin;                    // the lexer reads its input from this file
+
+extern int curr_lineno;       // the parser's location; kept up by the lexer
+
+extern int optind;            // for option processing
+extern char *out_filename;    // name of output assembly
+extern Program ast_root;      // the AST produced by the parse
+extern int omerrs;            // a count of lex and parse errors
+extern int compile_jobs;      // processes to parse in (-j)
+extern int node_lineno;
+
+extern int cool_yyparse();
+extern int cool_map_file(FILE *f); // have the lexer scan f from a mapping
+void handle_flags(int argc, char *argv[]);
+
+static int file_index;        // argv index of the file being lexed
+static int file_count;        // index one past the last input file
+static char **file_names;
+static bool one_file_only;    // set in parse workers; see yywrap
+
+//
+// Open the next input file for the lexer.  Returns 0 when there are no
+// files left.
+//
+static int open_next_file()
+{
+    if (fin != NULL) {
+	fclose(fin);
+	fin = NULL;
+    }
+    if (file_index >= file_count)
+	return 0;
+
+    curr_filename = file_names[file_index++];
+    fin = fopen(curr_filename, "r");
+    if (fin == NULL) {
+	cerr << "Could not open input file " << curr_filename << endl;
+	exit(1);
+    }
+    // like the stand-alone lexer, count lines from 1 in every file
+    curr_lineno = 1;
+    cool_map_file(fin);
+    return 1;
+}
+
+//
+// Flex calls yywrap at the end of each input.  Returning 0 makes the
+// lexer carry on with the next file, so the parser sees all the files
+// as one token stream.
+//
+extern "C" int yywrap()
+{
+    if (one_file_only)
+	return 1;
+    return open_next_file() ? 0 : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//
+//  Parallel parsing
+//
+//  With -j n coolc forks n workers, and worker w parses input files w,
+//  w+n, w+2n, ... each on its own, with its own error count.  For each
+//  file it sends the parent a record over a pipe:
+//
+//     begin      where its error messages start, sent before parsing
+//     end        where its error messages end, and its error count
+//     strings    the strings the file added to the worker's idtable,
+//                inttable and stringtable, in the order they were added
+//     program    the file's classes as a binary AST (see astbinary.h),
+//                or nothing if there were errors
+//
+//  The parent reads each worker's records on a thread of its own, which
+//  enters the strings of file i into the tables as task i (see
+//  intern_task in stringtab.h).  Once the threads are done, every table
+//  is numbered as a sequential parse would have numbered it, so the
+//  constants in the generated code are the same either way.  Then the
+//  parent takes the records in file order, and the classes are joined
+//  in file order into a single program.
+//
+//  Each worker writes its error messages to a temporary file, which the
+//  parent copies to stderr a file at a time, so messages come out in
+//  file order too.  A worker that exits in the middle of a file (the
+//  parser gives up after too many errors) leaves its messages in the
+//  temporary file; the parent copies what is there and stops.
+//
+//  Unlike the sequential parse, which runs all the files together as one
+//  token stream, each file has to be made of whole classes.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+static void put_int(std::string& s, long v)
+{
+    s.append((const char *) &v, sizeof v);
+}
+
+// append the entries of tbl from index *sent on, and move *sent past them
+template <class Elem> static void put_strings(std::string& s, StringTable<Elem>& tbl, int *sent)
+{
+    int n = 0;
+    while (tbl.more(*sent + n))
+	n++;
+    put_int(s, n);
+    for (int i = 0; i < n; i++) {
+	Elem *e = tbl.lookup(*sent + i);
+	put_int(s, e->get_len());
+	s.append(e->get_string(), e->get_len());
+    }
+    *sent += n;
+}
+
+static void write_all(int fd, const std::string& s)
+{
+    const char *p = s.data();
+    size_t left = s.size();
+    while (left > 0) {
+	ssize_t n = write(fd, p, left);
+	if (n <= 0)
+	    _exit(1);
+	p += n;
+	left -= n;
+    }
+}
+
+static void parse_worker(int first, int step, int fd)
+{
+    int sent[3] = { 0, 0, 0 };
+    while (idtable.more(sent[0])) sent[0]++;
+    while (inttable.more(sent[1])) sent[1]++;
+    while (stringtable.more(sent[2])) sent[2]++;
+
+    one_file_only = true;
+    for (int i = first; i < file_count; i += step) {
+	std::string rec;
+	put_int(rec, lseek(2, 0, SEEK_CUR));
+	write_all(fd, rec);
+
+	file_index = i;
+	open_next_file();
+	omerrs = 0;
+	cool_yyparse();
+
+	rec.clear();
+	put_int(rec, lseek(2, 0, SEEK_CUR));
+	put_int(rec, omerrs);
+	put_strings(rec, idtable, &sent[0]);
+	put_strings(rec, inttable, &sent[1]);
+	put_strings(rec, stringtable, &sent[2]);
+	if (omerrs == 0) {
+	    std::ostringstream ast;
+	    dump_binary(ast, ast_root);
+	    put_int(rec, ast.str().size());
+	    rec += ast.str();
+	} else
+	    put_int(rec, 0);
+	write_all(fd, rec);
+    }
+    _exit(0);
+}
+
+// read exactly n bytes; false at the end of the input
+static bool read_all(FILE *f, void *buf, size_t n)
+{
+    return n == 0 || fread(buf, n, 1, f) == 1;
+}
+
+static bool get_int(FILE *f, long *v)
+{
+    return read_all(f, v, sizeof *v);
+}
+
+template <class Elem> static bool get_strings(FILE *f, StringTable<Elem>& tbl)
+{
+    long n;
+    if (!get_int(f, &n))
+	return false;
+    std::vector<char> s;
+    for (long i = 0; i < n; i++) {
+	long len;
+	if (!get_int(f, &len))
+	    return false;
+	s.resize(len + 1);
+	if (!read_all(f, s.data(), len))
+	    return false;
+	tbl.add_string(s.data(), len);
+    }
+    return true;
+}
+
+// the record of a file, as far as the parent could read it
+struct FileRecord {
+    enum { LOST, STOPPED, READ } state;   // STOPPED: the worker quit in it
+    long start, stop;                     // its error messages
+    long errors;
+    std::vector<unsigned char> ast;
+    FileRecord() : state(LOST) { }
+};
+
+// read the records of files first, first + step, ... from a worker,
+// entering the strings of file i as task i
+static void read_records(FILE *f, int first, int step, std::vector<FileRecord>& recs)
+{
+    for (int i = first; i < file_count; i += step) {
+	FileRecord& r = recs[i - file_index];
+	long size;
+	if (!get_int(f, &r.start))
+	    return;
+	r.state = FileRecord::STOPPED;
+	if (!get_int(f, &r.stop))
+	    return;
+	r.state = FileRecord::LOST;
+	intern_task(i);
+	if (!get_int(f, &r.errors) ||
+	    !get_strings(f, idtable) ||
+	    !get_strings(f, inttable) ||
+	    !get_strings(f, stringtable) ||
+	    !get_int(f, &size))
+	    return;
+	r.ast.resize(size);
+	if (!read_all(f, r.ast.data(), size))
+	    return;
+	r.state = FileRecord::READ;
+    }
+}
+
+// copy bytes [from, to) of a worker's error file to stderr; to < 0 for all
+static void copy_errors(FILE *errs, long from, long to)
+{
+    char buf[4096];
+    while (to < 0 || from < to) {
+	size_t want = sizeof buf;
+	if (to >= 0 && (size_t) (to - from) < want)
+	    want = to - from;
+	ssize_t n = pread(fileno(errs), buf, want, from);
+	if (n <= 0)
+	    break;
+	cerr.write(buf, n);
+	from += n;
+    }
+}
+
+static void parse_in_parallel(int jobs)
+{
+    std::vector<FILE *> records(jobs), errs(jobs);
+    std::vector<pid_t> pids(jobs);
+
+    fflush(NULL);
+    for (int w = 0; w < jobs; w++) {
+	int fds[2];
+	errs[w] = tmpfile();
+	if (errs[w] == NULL || pipe(fds) != 0) {
+	    cerr << "coolc: cannot start parse workers" << endl;
+	    exit(1);
+	}
+	pids[w] = fork();
+	if (pids[w] < 0) {
+	    cerr << "coolc: cannot start parse workers" << endl;
+	    exit(1);
+	}
+	if (pids[w] == 0) {
+	    close(fds[0]);
+	    dup2(fileno(errs[w]), 2);
+	    parse_worker(file_index + w, jobs, fds[1]);
+	}
+	close(fds[1]);
+	records[w] = fdopen(fds[0], "r");
+    }
+
+    std::vector<FileRecord> recs(file_count - file_index);
+    std::vector<std::thread> readers;
+    idtable.begin_concurrent();
+    inttable.begin_concurrent();
+    stringtable.begin_concurrent();
+    for (int w = 0; w < jobs; w++)
+	readers.push_back(std::thread(read_records, records[w],
+				      file_index + w, jobs, std::ref(recs)));
+    for (int w = 0; w < jobs; w++)
+	readers[w].join();
+    idtable.end_concurrent();
+    inttable.end_concurrent();
+    stringtable.end_concurrent();
+
+    std::vector<Class_> classes;
+    int errors = 0;
+    int lineno = 0;
+    for (int i = file_index; i < file_count; i++) {
+	int w = (i - file_index) % jobs;
+	FileRecord& r = recs[i - file_index];
+	if (r.state == FileRecord::LOST) {
+	    cerr << "coolc: lost a parse worker" << endl;
+	    exit(1);
+	}
+	if (r.state == FileRecord::STOPPED) {
+	    copy_errors(errs[w], r.start, -1);
+	    exit(1);
+	}
+	copy_errors(errs[w], r.start, r.stop);
+	errors += r.errors;
+	if (r.errors == 0 && errors == 0) {
+	    program_class *p = (program_class *) read_binary_ast(r.ast.data(), r.ast.size());
+	    for (int j = 0; j < p->classes->len(); j++)
+		classes.push_back(p->classes->nth(j));
+	    lineno = p->get_line_number();
+	}
+    }
+    for (int w = 0; w < jobs; w++) {
+	fclose(records[w]);
+	fclose(errs[w]);
+	waitpid(pids[w], NULL, 0);
+    }
+
+    omerrs = errors;
+    if (errors == 0) {
+	Class_ *elems = (Class_ *) node_arena.alloc((classes.size() ? classes.size() : 1) * sizeof(Class_));
+	for (size_t j = 0; j < classes.size(); j++)
+	    elems[j] = classes[j];
+	node_lineno = lineno;
+	ast_root = program(list_node<Class_>::array(elems, classes.size()));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    handle_flags(argc,argv);
+
+    file_index = optind;
+    file_count = argc;
+    file_names = argv;
+    if (!open_next_file()) {
+	cerr << "coolc: no input files" << endl;
+	exit(1);
+    }
+
+    if (!out_filename) {   // no -o option
+	out_filename = new char[strlen(argv[optind])+8];
+	strcpy(out_filename, argv[optind]);
+	char *dot = strrchr(out_filename, '.');
+	if (dot) *dot = '\0'; // strip off file extension
+	strcat(out_filename, ".s");
+    }
+
+    //
+    // In the pipeline the code generator's string table starts with the
+    // file name of the first class, and cgen relies on entry 0 being a
+    // file name for its runtime error messages.  Keep it that way.
+    //
+    stringtable.add_string(curr_filename);
+
+    int jobs = compile_jobs < file_count - optind ? compile_jobs : file_count - optind;
+    if (jobs > 1) {
+	fclose(fin);
+	fin = NULL;
+	file_index = optind;
+	parse_in_parallel(jobs);
+    } else
+	cool_yyparse();
+    if (omerrs != 0) {
+	cerr << "Compilation halted due to lex and parse errors\n";
+	exit(1);
+    }
+
+    ast_root->semant();
+
+    //
+    // Don't touch the output file until we know that earlier phases of the
+    // compiler have succeeded.
+    //
+    AsmWriter s(out_filename);
+    if (!s.ok()) {
+	cerr << "Cannot open output file " << out_filename << endl;
+	exit(1);
+    }
+    ast_root->cgen(s);
+    s.flush();
+    if (!s.ok()) {
+	cerr << "Cannot write output file " << out_filename << endl;
+	exit(1);
+    }
+    return 0;
+}
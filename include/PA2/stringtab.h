@@ -11,11 +11,14 @@
 
 #include <assert.h>
 #include <string.h>
+#include <mutex>
+#include <vector>
 #include "list.h"    // list template
 #include "cool-io.h"
 
 class Entry;
 typedef Entry* Symbol;
+template <class Elem> class StringTable;
 
 extern ostream& operator<<(ostream& s, const Entry& sym);
 extern ostream& operator<<(ostream& s, Symbol sym);
@@ -31,6 +34,7 @@ protected:
   char *str;     // the string
   int  len;      // the length of the string (without trailing \0)
   int index;     // a unique index for each string
+  template <class Elem> friend class StringTable;
 public:
   Entry(char *s, int l, int i);
 
@@ -89,14 +93,63 @@ typedef IntEntry *IntEntryP;
 //
 //////////////////////////////////////////////////////////////////////////
 
+//
+//  A table is split into STRTAB_SHARDS shards by the hash of the string,
+//  each with its own lock and open addressing hash index, so that
+//  threads interning different strings seldom wait for each other.
+//
+//  Indices are given out in the order strings are added, and the
+//  generated code names constants by index, so they must not depend on
+//  how threads happen to be scheduled.  Between begin_concurrent() and
+//  end_concurrent() the table may be used from several threads; a new
+//  Entry gets its index only in end_concurrent(), which numbers the
+//  Entries added since begin_concurrent() as if the threads' work had
+//  been done one task at a time.  Each thread says which task it is
+//  working on with intern_task(); the tasks are ordered by number, and
+//  the strings a task adds are ordered by when it added them.  Lookups
+//  by index and the iterator only see Entries that have their indices.
+//  Outside that section the locks are not taken.
+//
+#define STRTAB_SHARD_BITS 4
+#define STRTAB_SHARDS (1 << STRTAB_SHARD_BITS)
+
+// make this thread's interning part of the given task (see above)
+void intern_task(unsigned task);
+
 template <class Elem> 
 class StringTable
 {
 protected:
+   struct Pending {   // an Entry added during a concurrent section
+      Elem *e;
+      unsigned long long order;   // earliest (task, sequence) to add it
+   };
+   struct Shard {
+      std::mutex lock;
+      Elem **slots;   // open addressing hash index over the shard
+      int nslots;     // number of slots; zero or a power of two
+      int count;      // entries in the shard
+      std::vector<Pending> pending;
+      Shard() : slots((Elem **) NULL), nslots(0), count(0) { }
+   };
+
    List<Elem> *tbl;   // a string table is a list
    int index;         // the current index
+   Shard shards[STRTAB_SHARDS];
+   Elem **entries;    // entries by index, for constant time lookup(int)
+   int nentries;      // room in entries
+   bool concurrent;   // between begin_concurrent and end_concurrent
+
+   static unsigned hash_string(char *s, int len);
+   Shard& shard_of(unsigned h) { return shards[h >> (32 - STRTAB_SHARD_BITS)]; }
+   Elem **find_slot(Shard& sh, char *s, int len, unsigned h);  // slot holding s, or empty slot
+   void grow(Shard& sh);                // double the shard's slots
+   void number(Elem *e);                // give e the next index
+   Elem *add_locked(Shard& sh, char *s, int len, unsigned h);
 public:
-   StringTable(): tbl((List<Elem> *) NULL), index(0) { }   // an empty table
+   StringTable(): tbl((List<Elem> *) NULL), index(0),
+                  entries((Elem **) NULL), nentries(0),
+                  concurrent(false) { }   // an empty table
    // The following methods each add a string to the string table.  
    // Only one copy of each string is maintained.  
    // Returns a pointer to the string table entry with the string.
@@ -110,6 +163,9 @@ public:
    // add the string representation of an integer
    Elem *add_int(int i);
 
+   // allow, and then finish, adding strings from several threads
+   void begin_concurrent();
+   void end_concurrent();
 
    // An iterator.
    int first();       // first index
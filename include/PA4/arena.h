@@ -0,0 +1,110 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  Arena
+//
+//   A bump allocator.  Memory is carved out of large chunks obtained
+//   from calloc; individual allocations are never freed.  Instead the
+//   whole arena is given back at once with release().  The interface is:
+//
+//     void *alloc(size_t size)
+//       returns size bytes aligned to ARENA_ALIGN, filled with zeros.
+//       Tree nodes rely on this: some of the fields the code generator
+//       adds to them are not set by their constructors.
+//
+//     char *copy_string(const char *s, int len)
+//       returns a null terminated copy of the first len characters of s.
+//
+//     void release()
+//       frees every chunk.  Anything allocated from the arena is dead
+//       afterwards; the arena itself may be used again.
+//
+//     size_t size()
+//       returns the number of bytes handed out since the last release.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define ARENA_ALIGN 16
+#define ARENA_CHUNK (64 * 1024)
+
+class Arena {
+private:
+  struct Chunk {
+    Chunk *next;
+    size_t pad;       // keeps the data that follows ARENA_ALIGN aligned
+  };
+  Chunk *chunks;      // chunks in use, most recent first
+  char *cur;          // next free byte in the current chunk
+  char *limit;        // end of the current chunk
+  size_t used;        // bytes handed out
+
+  void *alloc_chunk(size_t size);
+public:
+  Arena() : chunks(NULL), cur(NULL), limit(NULL), used(0) { }
+
+  void *alloc(size_t size)
+  {
+    size = (size + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    used += size;
+    if ((size_t) (limit - cur) < size)
+      return alloc_chunk(size);
+    void *p = cur;
+    cur += size;
+    return p;
+  }
+
+  char *copy_string(const char *s, int len);
+  void release();
+  size_t size() const { return used; }
+};
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  NodeArena
+//
+//   The allocator behind tree_node::operator new.  Requests are sorted
+//   into pools by size class so that nodes of the same class end up
+//   next to each other in memory; requests too big for any pool go to
+//   a shared overflow arena.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define NODE_POOLS 16   // pools for sizes up to NODE_POOLS * ARENA_ALIGN
+
+class NodeArena {
+private:
+  Arena pools[NODE_POOLS];
+  Arena large;
+public:
+  void *alloc(size_t size)
+  {
+    size_t pool = (size + ARENA_ALIGN - 1) / ARENA_ALIGN;
+    if (pool > 0 && pool <= NODE_POOLS)
+      return pools[pool - 1].alloc(size);
+    return large.alloc(size);
+  }
+
+  void release();
+  size_t size() const;
+};
+
+//
+// node_arena holds every AST node; string_arena holds the characters
+// of every string table Entry.  Releasing string_arena invalidates the
+// Symbols in idtable, inttable and stringtable.
+//
+extern NodeArena node_arena;
+extern Arena string_arena;
+
+#endif
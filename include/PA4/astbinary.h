@@ -0,0 +1,86 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _ASTBINARY_H_
+#define _ASTBINARY_H_
+
+//
+//  A compact binary form of the AST, used in place of the text written
+//  by dump_with_types when the -b flag is given.  A phase reading its
+//  input from another phase checks for the magic bytes and loads the
+//  program directly, without running the AST lexer and parser.
+//
+//  The layout is
+//
+//     magic      the four bytes AST_MAGIC
+//     version    varint AST_VERSION
+//     symbols    varint count, then for each symbol its table
+//                (AST_IDTABLE, AST_INTTABLE or AST_STRTABLE) as one
+//                byte, a varint length and the characters
+//     program    the tree, in preorder
+//
+//  Each node is its NodeKind (see tree.h) as one byte and its line number as a
+//  varint, followed by its components in the order the constructor
+//  takes them (but a class_ has its filename before its features).
+//  A Symbol is a varint: 0 for NULL, otherwise one plus its position
+//  in the symbol section.  A list is a varint count followed by the
+//  elements.  An Expression ends with its type.
+//
+//  Varints are unsigned, seven bits per byte, low bits first; the high
+//  bit of a byte is set when more bytes follow.
+//
+//  Symbols are listed in the order they are first referenced in the
+//  tree, which is the order the AST lexer would have entered them in
+//  the string tables.
+//
+
+#include <string>
+#include <unordered_map>
+#include "cool-tree.h"
+
+#define AST_MAGIC    "\177AST"
+#define AST_MAGIC_LEN 4
+#define AST_VERSION  1
+
+enum AstTable { AST_IDTABLE, AST_INTTABLE, AST_STRTABLE };
+
+//
+//  AstWriter collects the tree in memory while the dump_binary methods
+//  walk it, numbering symbols as they are met; `write' then puts out the
+//  header, the symbol section and the tree.
+//
+class AstWriter {
+private:
+  std::string syms;        // the symbol section, without its count
+  std::string body;        // the tree
+  int nsyms;
+  int nnodes;
+  std::unordered_map<Symbol, int> ids;
+
+  static void put_varint(std::string& s, unsigned v);
+public:
+  AstWriter() : nsyms(0), nnodes(0) {}
+  void node(NodeKind kind, int line);
+  void symbol(Symbol s, AstTable table);
+  void boolean(Boolean b) { body += (char) (b ? 1 : 0); }
+  void length(int n) { put_varint(body, n); }
+  void write(ostream& stream);
+  int nodes() const { return nnodes; }   // how many nodes have been met
+};
+
+// write the program in binary form
+void dump_binary(ostream& stream, Program p);
+
+// true if the next byte of `f' starts a binary AST
+bool is_binary_ast(FILE *f);
+
+// read a binary AST from `f', entering its symbols in the string tables
+Program read_binary_ast(FILE *f);
+
+// the same, from the size bytes at buf
+Program read_binary_ast(const unsigned char *buf, int size);
+
+#endif
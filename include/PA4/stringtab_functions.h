@@ -5,6 +5,9 @@
 #include "copyright.h"
 
 #include "cool-io.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
 #define MAXSIZE 1000000
 #define min(a,b) (a > b ? b : a)
 
@@ -13,9 +16,17 @@
 
 //
 // A string table is implemented a linked list of Entrys.  Each Entry
-// in the list has a unique string.
+// in the list has a unique string.  The list is kept for iteration and
+// printing; searches go through open addressing hash tables keyed by
+// the length and bytes of the string, one per shard, and lookups by
+// index go through a dense array of the entries.
 //
 
+// the (task, sequence) of the calling thread's next string; see intern_task
+extern unsigned long long intern_order();
+// held while an Entry copies its string during a concurrent section
+extern std::mutex intern_arena_lock;
+
 template <class Elem>
 Elem *StringTable<Elem>::add_string(char *s)
 {
@@ -23,26 +34,168 @@ Elem *StringTable<Elem>::add_string(char *s)
 }
 
 //
-// Add a string requires two steps.  First, the list is searched; if the
+// FNV-1a over the first len characters of s.
+//
+template <class Elem>
+unsigned StringTable<Elem>::hash_string(char *s, int len)
+{
+  unsigned h = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char) s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+//
+// Linear probing.  A shard is never more than half full, so the
+// probe always ends at either the matching Entry or an empty slot.
+// The top bits of the hash pick the shard, so the low bits pick the slot.
+//
+template <class Elem>
+Elem **StringTable<Elem>::find_slot(Shard& sh, char *s, int len, unsigned h)
+{
+  unsigned mask = sh.nslots - 1;
+  h &= mask;
+  while (sh.slots[h] && !sh.slots[h]->equal_string(s,len))
+    h = (h + 1) & mask;
+  return &sh.slots[h];
+}
+
+//
+// Double the shard's hash table and rehash its Entries into it.
+//
+template <class Elem>
+void StringTable<Elem>::grow(Shard& sh)
+{
+  int size = sh.nslots ? 2 * sh.nslots : 16;
+  Elem **old_slots = sh.slots;
+  int old_size = sh.nslots;
+
+  sh.slots = new Elem *[size];
+  sh.nslots = size;
+  for (int i = 0; i < size; i++)
+    sh.slots[i] = NULL;
+
+  for (int i = 0; i < old_size; i++)
+    if (Elem *e = old_slots[i])
+      *find_slot(sh, e->get_string(), e->get_len(),
+                 hash_string(e->get_string(), e->get_len())) = e;
+  delete [] old_slots;
+}
+
+//
+// Give e the next index and put it at the head of the list.
+//
+template <class Elem>
+void StringTable<Elem>::number(Elem *e)
+{
+  if (index == nentries) {
+    int size = nentries ? 2 * nentries : 64;
+    Elem **old_entries = entries;
+    entries = new Elem *[size];
+    for (int i = 0; i < index; i++)
+      entries[i] = old_entries[i];
+    delete [] old_entries;
+    nentries = size;
+  }
+  e->index = index;
+  entries[index++] = e;
+  tbl = new List<Elem>(e, tbl);
+}
+
+//
+// Add a string requires two steps.  First, the shard is searched; if the
 // string is found, a pointer to the existing Entry for that string is 
 // returned.  If the string is not found, a new Entry is created and added
-// to the list.
+// to the table.  The caller holds the shard's lock if there is a need.
+//
+// During a concurrent section a new Entry is not numbered yet; its index
+// is -1 - (its place in the shard's pending list) until end_concurrent.
 //
 template <class Elem>
-Elem *StringTable<Elem>::add_string(char *s, int maxchars)
+Elem *StringTable<Elem>::add_locked(Shard& sh, char *s, int len, unsigned h)
 {
-  int len = min((int) strlen(s),maxchars);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
+  if (2 * sh.count >= sh.nslots)
+    grow(sh);
 
-  Elem *e = new Elem(s,len,index++);
-  tbl = new List<Elem>(e, tbl);
+  Elem **slot = find_slot(sh,s,len,h);
+  if (!concurrent) {
+    if (*slot)
+      return *slot;
+    Elem *e = new Elem(s,len,0);
+    number(e);
+    sh.count++;
+    *slot = e;
+    return e;
+  }
+
+  unsigned long long order = intern_order();
+  if (Elem *e = *slot) {
+    if (e->index < 0) {   // added in this section; keep the earliest adder
+      Pending& p = sh.pending[-1 - e->index];
+      if (order < p.order)
+        p.order = order;
+    }
+    return e;
+  }
+
+  Elem *e;
+  {
+    std::lock_guard<std::mutex> guard(intern_arena_lock);
+    e = new Elem(s,len,-1 - (int) sh.pending.size());
+  }
+  Pending p = { e, order };
+  sh.pending.push_back(p);
+  sh.count++;
+  *slot = e;
   return e;
 }
 
+template <class Elem>
+Elem *StringTable<Elem>::add_string(char *s, int maxchars)
+{
+  int len = strnlen(s,maxchars);   // s need not be terminated
+  unsigned h = hash_string(s,len);
+  Shard& sh = shard_of(h);
+  if (!concurrent)
+    return add_locked(sh,s,len,h);
+  std::lock_guard<std::mutex> guard(sh.lock);
+  return add_locked(sh,s,len,h);
+}
+
+template <class Elem>
+void StringTable<Elem>::begin_concurrent()
+{
+  assert(!concurrent);
+  concurrent = true;
+}
+
+//
+// Number the Entries added during the concurrent section in the order a
+// sequential run of the tasks would have added them: by the task and
+// sequence of the first add of each string.  No thread may be using the
+// table while this runs.
+//
+template <class Elem>
+void StringTable<Elem>::end_concurrent()
+{
+  assert(concurrent);
+  std::vector<Pending> added;
+  for (int i = 0; i < STRTAB_SHARDS; i++) {
+    added.insert(added.end(), shards[i].pending.begin(),
+                 shards[i].pending.end());
+    shards[i].pending.clear();
+  }
+  std::sort(added.begin(), added.end(),
+            [](const Pending& a, const Pending& b) { return a.order < b.order; });
+  for (size_t i = 0; i < added.size(); i++)
+    number(added[i].e);
+  concurrent = false;
+}
+
 //
-// To look up a string, the list is scanned until a matching Entry is located.
+// To look up a string, the hash table is probed for a matching Entry.
 // If no such entry is found, an assertion failure occurs.  Thus, this function
 // is used only for strings that one expects to find in the table.
 //
@@ -50,11 +203,15 @@ template <class Elem>
 Elem *StringTable<Elem>::lookup_string(char *s)
 {
   int len = strlen(s);
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_string(s,len))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  unsigned h = hash_string(s,len);
+  Shard& sh = shard_of(h);
+  std::unique_lock<std::mutex> guard(sh.lock, std::defer_lock);
+  if (concurrent)
+    guard.lock();
+  assert(sh.nslots > 0);   // fail if the table is empty
+  Elem *e = *find_slot(sh,s,len,h);
+  assert(e);               // fail if string is not found
+  return e;
 }
 
 //
@@ -64,11 +221,8 @@ Elem *StringTable<Elem>::lookup_string(char *s)
 template <class Elem>
 Elem *StringTable<Elem>::lookup(int ind)
 {
-  for(List<Elem> *l = tbl; l; l = l->tl())
-    if (l->hd()->equal_index(ind))
-      return l->hd();
-  assert(0);   // fail if string is not found
-  return NULL; // to avoid compiler warning
+  assert(ind >= 0 && ind < index);   // fail if string is not found
+  return entries[ind];
 }
 
 //
@@ -77,7 +231,7 @@ Elem *StringTable<Elem>::lookup(int ind)
 template <class Elem>
 Elem *StringTable<Elem>::add_int(int i)
 {
-  static char *buf = new char[20];
+  char buf[20];
   snprintf(buf, 20, "%d", i);
   return add_string(buf);
 }
@@ -14,6 +14,9 @@
 #ifndef _SYMTAB_H_
 #define _SYMTAB_H_
 
+#include <deque>
+#include <vector>
+#include <unordered_map>
 #include "list.h"
 
 //
@@ -36,38 +39,47 @@ public:
 //
 // SymbolTable<SYM,DAT> describes a symbol table mapping symbols of
 //    type `SYM' to data of type `DAT *'.  It is implemented as a
-//    list of lists of `SymtabEntry<SYM,DAT> *'.  The inner list is
-//    a scope, a mapping from symbols to data, and the outer list is
-//    a list of scopes.
+//    hash map from each symbol to its innermost entry, plus a stack
+//    of every entry in the order it was added.  Each entry remembers
+//    the entry for the same symbol that it shadows, and each scope
+//    remembers where its entries start on the stack, so the stack
+//    doubles as the undo log for `exitscope'.
 //
-//    `tbl' points to the current top scope.
+//    `enterscope' starts a new scope on top of the current one.
 //
-//    `enterscope' makes the table point to a new scope whose parent
-//       is the scope it pointed to previously.
-//
-//    `exitscope' makes the table point to the parent scope of the
-//        current scope.  Note that the old child scope is not
-//        deallocated.  One may save the state of a symbol table
-//        at a given point by copying it with `operator ='
+//    `exitscope' drops the entries of the top scope, restoring the
+//        entries they shadowed.  The cost is proportional to the
+//        number of entries dropped.
 //
 //    `addid(s,i)' adds a symbol table entry to the current scope of
-//        the symbol table mapping symbol `s' to data `d'.  The old
-//        top scope isn't modified; a new scope is created whose
-//        entry list is the new entry followed by the old entry list,
-//        and whose tail is the old top scope's parent.  The table
-//        is made to point to this new scope.
-//
-//    `lookup(s)' looks for the symbol `s', starting at the top scope
-//        and proceeding down the list of scopes until either an
-//        entry is found whose `get_id()' equals `s', or the end of
-//        the root scope is reached.  It returns the data item
-//        associated with the entry, or NULL if no such entry exists.
+//        the symbol table mapping symbol `s' to data `d'.  The entry
+//        returned stays valid until its scope is exited.
 //
+//    `lookup(s)' returns the data of the innermost entry for `s', or,
+//        if there is none, the result of looking `s' up in the outer
+//        table (see `inherit').  It returns NULL if no such entry
+//        exists.  Each table on the way costs one hash probe, so a
+//        lookup that misses is proportional to the number of outer
+//        tables, e.g. the inheritance depth of a class environment.
 //
 //    `probe(s)' checks the top scope for an entry whose `get_id()'
 //        equals `s', and returns the entry's `get_info()' if
 //        found, and NULL otherwise.
 //
+//    `inherit(t)' empties the table, makes `t' its outer table and
+//        enters a fresh scope.  The outer table is not copied: entries
+//        added to `t' later are visible through this table's `lookup',
+//        while entries added to this table are invisible to `t'.  This
+//        is how a class environment sits on top of its parent's: semant
+//        makes the class tables inherit before it registers any
+//        features, so the outer tables cannot be flattened into this
+//        one at this point, and keeping them shared keeps the memory
+//        for a hierarchy proportional to its number of features.
+//
+//    `operator =' copies the contents of a table.  The copy and the
+//        original are independent afterwards, except that they share
+//        the same outer table.
+//
 //    `dump()' prints the symbols in the symbol table.
 //
 
@@ -75,19 +87,21 @@ template <class SYM, class DAT>
 class SymbolTable
 {
     typedef SymtabEntry<SYM, DAT> ScopeEntry;
-    typedef List<ScopeEntry> Scope;
-    typedef List<Scope> ScopeList;
 
-public:
-    ScopeList *tbl;
-    SymbolTable() : tbl(NULL) {} // create a new symbol table
-
-    // Create pointer to current symbol table.
-    SymbolTable &operator=(const SymbolTable &s)
+    struct Binding
     {
-        tbl = s.tbl;
-        return *this;
-    }
+        ScopeEntry entry;
+        int shadowed;   // index of the entry for the same symbol, or -1
+        Binding(SYM s, DAT *i, int sh) : entry(s, i), shadowed(sh) {}
+    };
+
+    std::unordered_map<SYM, int> innermost;   // symbol -> index in entries
+    std::deque<Binding> entries;              // every live entry, oldest first
+    std::vector<int> scopes;                  // first entry of each scope
+    SymbolTable *outer;                       // consulted when lookup misses
+
+public:
+    SymbolTable() : outer(NULL) {} // create a new symbol table
 
     void fatal_error(char *msg)
     {
@@ -95,55 +109,76 @@ public:
         exit(1);
     }
 
-    // Enter a new scope.  A symbol table is organized as a list of
-    // lists.  The head of the list is the innermost scope, the tail
-    // holds the outer scopes.  A scope must be entered before anything
+    // Enter a new scope.  A scope must be entered before anything
     // can be added to the table.
-
     void enterscope()
     {
-        // The cast of NULL is required for template instantiation to work
-        // correctly.
-        tbl = new ScopeList((Scope *)NULL, tbl);
+        scopes.push_back(entries.size());
     }
 
     // Pop the first scope off of the symbol table.
     void exitscope()
     {
         // It is an error to exit a scope that doesn't exist.
-        if (tbl == NULL)
+        if (scopes.empty())
         {
             fatal_error("exitscope: Can't remove scope from an empty symbol table.");
         }
-        tbl = tbl->tl();
+        int mark = scopes.back();
+        scopes.pop_back();
+        while ((int)entries.size() > mark)
+        {
+            Binding &b = entries.back();
+            if (b.shadowed < 0)
+                innermost.erase(b.entry.get_id());
+            else
+                innermost[b.entry.get_id()] = b.shadowed;
+            entries.pop_back();
+        }
+    }
+
+    // Make this table an empty scope on top of a live view of `t'.
+    void inherit(SymbolTable &t)
+    {
+        innermost.clear();
+        entries.clear();
+        scopes.clear();
+        outer = &t;
+        enterscope();
     }
 
     // Add an item to the symbol table.
     ScopeEntry *addid(SYM s, DAT *i)
     {
         // There must be at least one scope to add a symbol.
-        if (tbl == NULL)
+        if (scopes.empty())
             fatal_error("addid: Can't add a symbol without a scope.");
-        ScopeEntry *se = new ScopeEntry(s, i);
-        tbl->head = new Scope(se, tbl->hd());
-        tbl->tail = tbl->tl();
-        return (se);
+        int index = entries.size();
+        typename std::unordered_map<SYM, int>::iterator it = innermost.find(s);
+        if (it == innermost.end())
+        {
+            entries.push_back(Binding(s, i, -1));
+            innermost[s] = index;
+        }
+        else
+        {
+            entries.push_back(Binding(s, i, it->second));
+            it->second = index;
+        }
+        return &entries.back().entry;
     }
 
     // Lookup an item through all scopes of the symbol table.  If found
     // it returns the associated information field, if not it returns
     // NULL.
-
     DAT *lookup(SYM s)
     {
-        for (ScopeList *i = tbl; i != NULL; i = i->tl())
+        for (SymbolTable *t = this; t != NULL; t = t->outer)
         {
-            for (Scope *j = i->hd(); j != NULL; j = j->tl())
+            typename std::unordered_map<SYM, int>::iterator it = t->innermost.find(s);
+            if (it != t->innermost.end())
             {
-                if (s == j->hd()->get_id())
-                {
-                    return (j->hd()->get_info());
-                }
+                return t->entries[it->second].entry.get_info();
             }
         }
         return NULL;
@@ -153,16 +188,14 @@ public:
     // 's'.  If found, return the information field.  If not return NULL.
     DAT *probe(SYM s)
     {
-        if (tbl == NULL)
+        if (scopes.empty())
         {
             fatal_error("probe: No scope in symbol table.");
         }
-        for (Scope *i = tbl->hd(); i != NULL; i = i->tl())
+        typename std::unordered_map<SYM, int>::iterator it = innermost.find(s);
+        if (it != innermost.end() && it->second >= scopes.back())
         {
-            if (s == i->hd()->get_id())
-            {
-                return (i->hd()->get_info());
-            }
+            return entries[it->second].entry.get_info();
         }
         return (NULL);
     }
@@ -170,12 +203,17 @@ public:
     // Prints out the contents of the symbol table
     void dump()
     {
-        for (ScopeList *i = tbl; i != NULL; i = i->tl())
+        for (SymbolTable *t = this; t != NULL; t = t->outer)
         {
-            cerr << "\nScope: \n";
-            for (Scope *j = i->hd(); j != NULL; j = j->tl())
+            int end = t->entries.size();
+            for (int i = t->scopes.size() - 1; i >= 0; i--)
             {
-                cerr << "  " << j->hd()->get_id() << endl;
+                cerr << "\nScope: \n";
+                for (int j = end - 1; j >= t->scopes[i]; j--)
+                {
+                    cerr << "  " << t->entries[j].entry.get_id() << endl;
+                }
+                end = t->scopes[i];
             }
         }
     }
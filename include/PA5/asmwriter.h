@@ -0,0 +1,116 @@
+// -*-Mode: C++;-*-
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#ifndef _ASMWRITER_H_
+#define _ASMWRITER_H_
+
+#include <string.h>
+#include "cool-io.h"
+#include "stringtab.h"
+
+/////////////////////////////////////////////////////////////////////////
+//
+//  AsmWriter
+//
+//   The output of the code generator.  Everything is collected in one
+//   large buffer, which is written out with write(2) when it fills up
+//   and when the writer is destroyed; numbers and symbols are formatted
+//   by hand rather than by iostream.  It takes the << operators the
+//   emit functions use on ostreams:
+//
+//     const char *, char, int, Symbol
+//       appended as an ostream would format them.
+//
+//     endl
+//       ends the line.  Unlike on an ostream it does not flush: the
+//       buffer is only written out when it is full.
+//
+//   A writer made from a file name owns the file; one made from an
+//   ostream (cout when there is no output file) writes the buffer to
+//   the stream instead.  ok() is false if the file could not be opened
+//   or a write failed.
+//
+/////////////////////////////////////////////////////////////////////////
+
+#define ASM_BUFFER (1024 * 1024)
+
+class AsmWriter {
+private:
+  char *buf;
+  char *cur;          // next free byte of buf
+  char *limit;        // end of buf
+  int fd;             // file written to, or -1
+  ostream *stream;    // stream written to if fd is -1
+  bool failed;
+
+  void drain();
+  void write_long(const char *s, size_t len);
+
+  AsmWriter(const AsmWriter &);              // not copied
+  AsmWriter &operator=(const AsmWriter &);
+public:
+  AsmWriter(const char *filename);
+  AsmWriter(ostream &s);
+  ~AsmWriter();
+
+  void write(const char *s, size_t len)
+  {
+    if ((size_t) (limit - cur) < len) {
+      write_long(s, len);
+      return;
+    }
+    memcpy(cur, s, len);
+    cur += len;
+  }
+
+  AsmWriter &operator<<(const char *s)
+  {
+    write(s, strlen(s));
+    return *this;
+  }
+
+  AsmWriter &operator<<(char c)
+  {
+    if (cur == limit)
+      drain();
+    *cur++ = c;
+    return *this;
+  }
+
+  AsmWriter &operator<<(int n)
+  {
+    char digits[12];
+    char *p = digits + sizeof(digits);
+    unsigned int u = n < 0 ? 0u - (unsigned int) n : (unsigned int) n;
+    do {
+      *--p = '0' + u % 10;
+      u /= 10;
+    } while (u != 0);
+    if (n < 0)
+      *--p = '-';
+    write(p, digits + sizeof(digits) - p);
+    return *this;
+  }
+
+  AsmWriter &operator<<(Symbol sym)
+  {
+    write(sym->get_string(), sym->get_len());
+    return *this;
+  }
+
+  AsmWriter &operator<<(ostream &(*manip)(ostream &))
+  {
+    if (manip == (ostream &(*)(ostream &)) std::endl)
+      *this << '\n';
+    return *this;
+  }
+
+  void flush();
+  bool ok() const { return !failed; }
+};
+
+#endif
@@ -131,6 +131,7 @@ protected:
    Classes classes;
 public:
    program_class(Classes a1) {
+      kind = AST_program;
       classes = a1;
    }
    Program copy_Program();
@@ -154,6 +155,7 @@ protected:
    Symbol filename;
 public:
    class__class(Symbol a1, Symbol a2, Features a3, Symbol a4) {
+      kind = AST_class_;
       name = a1;
       parent = a2;
       features = a3;
@@ -180,6 +182,7 @@ protected:
    Expression expr;
 public:
    method_class(Symbol a1, Formals a2, Symbol a3, Expression a4) {
+      kind = AST_method;
       name = a1;
       formals = a2;
       return_type = a3;
@@ -205,6 +208,7 @@ protected:
    Expression init;
 public:
    attr_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = AST_attr;
       name = a1;
       type_decl = a2;
       init = a3;
@@ -228,6 +232,7 @@ protected:
    Symbol type_decl;
 public:
    formal_class(Symbol a1, Symbol a2) {
+      kind = AST_formal;
       name = a1;
       type_decl = a2;
    }
@@ -251,6 +256,7 @@ protected:
    Expression expr;
 public:
    branch_class(Symbol a1, Symbol a2, Expression a3) {
+      kind = AST_branch;
       name = a1;
       type_decl = a2;
       expr = a3;
@@ -274,6 +280,7 @@ protected:
    Expression expr;
 public:
    assign_class(Symbol a1, Expression a2) {
+      kind = AST_assign;
       name = a1;
       expr = a2;
    }
@@ -298,6 +305,7 @@ protected:
    Expressions actual;
 public:
    static_dispatch_class(Expression a1, Symbol a2, Symbol a3, Expressions a4) {
+      kind = AST_static_dispatch;
       expr = a1;
       type_name = a2;
       name = a3;
@@ -323,6 +331,7 @@ protected:
    Expressions actual;
 public:
    dispatch_class(Expression a1, Symbol a2, Expressions a3) {
+      kind = AST_dispatch;
       expr = a1;
       name = a2;
       actual = a3;
@@ -347,6 +356,7 @@ protected:
    Expression else_exp;
 public:
    cond_class(Expression a1, Expression a2, Expression a3) {
+      kind = AST_cond;
       pred = a1;
       then_exp = a2;
       else_exp = a3;
@@ -370,6 +380,7 @@ protected:
    Expression body;
 public:
    loop_class(Expression a1, Expression a2) {
+      kind = AST_loop;
       pred = a1;
       body = a2;
    }
@@ -392,6 +403,7 @@ protected:
    Cases cases;
 public:
    typcase_class(Expression a1, Cases a2) {
+      kind = AST_typcase;
       expr = a1;
       cases = a2;
    }
@@ -413,6 +425,7 @@ protected:
    Expressions body;
 public:
    block_class(Expressions a1) {
+      kind = AST_block;
       body = a1;
    }
    Expression copy_Expression();
@@ -436,6 +449,7 @@ protected:
    Expression body;
 public:
    let_class(Symbol a1, Symbol a2, Expression a3, Expression a4) {
+      kind = AST_let;
       identifier = a1;
       type_decl = a2;
       init = a3;
@@ -460,6 +474,7 @@ protected:
    Expression e2;
 public:
    plus_class(Expression a1, Expression a2) {
+      kind = AST_plus;
       e1 = a1;
       e2 = a2;
    }
@@ -482,6 +497,7 @@ protected:
    Expression e2;
 public:
    sub_class(Expression a1, Expression a2) {
+      kind = AST_sub;
       e1 = a1;
       e2 = a2;
    }
@@ -504,6 +520,7 @@ protected:
    Expression e2;
 public:
    mul_class(Expression a1, Expression a2) {
+      kind = AST_mul;
       e1 = a1;
       e2 = a2;
    }
@@ -526,6 +543,7 @@ protected:
    Expression e2;
 public:
    divide_class(Expression a1, Expression a2) {
+      kind = AST_divide;
       e1 = a1;
       e2 = a2;
    }
@@ -547,6 +565,7 @@ protected:
    Expression e1;
 public:
    neg_class(Expression a1) {
+      kind = AST_neg;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -568,6 +587,7 @@ protected:
    Expression e2;
 public:
    lt_class(Expression a1, Expression a2) {
+      kind = AST_lt;
       e1 = a1;
       e2 = a2;
    }
@@ -590,6 +610,7 @@ protected:
    Expression e2;
 public:
    eq_class(Expression a1, Expression a2) {
+      kind = AST_eq;
       e1 = a1;
       e2 = a2;
    }
@@ -612,6 +633,7 @@ protected:
    Expression e2;
 public:
    leq_class(Expression a1, Expression a2) {
+      kind = AST_leq;
       e1 = a1;
       e2 = a2;
    }
@@ -633,6 +655,7 @@ protected:
    Expression e1;
 public:
    comp_class(Expression a1) {
+      kind = AST_comp;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -653,6 +676,7 @@ protected:
    Symbol token;
 public:
    int_const_class(Symbol a1) {
+      kind = AST_int_const;
       token = a1;
    }
    Expression copy_Expression();
@@ -673,6 +697,7 @@ protected:
    Boolean val;
 public:
    bool_const_class(Boolean a1) {
+      kind = AST_bool_const;
       val = a1;
    }
    Expression copy_Expression();
@@ -693,6 +718,7 @@ protected:
    Symbol token;
 public:
    string_const_class(Symbol a1) {
+      kind = AST_string_const;
       token = a1;
    }
    Expression copy_Expression();
@@ -713,6 +739,7 @@ protected:
    Symbol type_name;
 public:
    new__class(Symbol a1) {
+      kind = AST_new_;
       type_name = a1;
    }
    Expression copy_Expression();
@@ -733,6 +760,7 @@ protected:
    Expression e1;
 public:
    isvoid_class(Expression a1) {
+      kind = AST_isvoid;
       e1 = a1;
    }
    Expression copy_Expression();
@@ -752,6 +780,7 @@ class no_expr_class : public Expression_class {
 protected:
 public:
    no_expr_class() {
+      kind = AST_no_expr;
    }
    Expression copy_Expression();
    void dump(ostream& stream, int n);
@@ -771,6 +800,7 @@ protected:
    Symbol name;
 public:
    object_class(Symbol a1) {
+      kind = AST_object;
       name = a1;
    }
    Expression copy_Expression();
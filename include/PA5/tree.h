@@ -17,16 +17,20 @@
 
 #include "stringtab.h"
 #include "cool-io.h"
+#include "arena.h"
+#include <vector>
 
 /////////////////////////////////////////////////////////////////////
 //
 //  tree_node
 //
-//   All APS nodes are derived from tree_node.  There is a
-//   protected field:
+//   All APS nodes are derived from tree_node.  There are two
+//   protected fields:
 //       int line_number     line in the source file from which this node came;
 //                           this is read from a global variable when the
 //                           node is created.
+//       NodeKind kind       which constructor made the node; AST_list for
+//                           the list nodes.
 //      
 //
 //
@@ -41,23 +45,52 @@
 //         the number of spaces to indent the output.
 //
 //       int get_line_number();  return the line number
+//       NodeKind get_kind();    return the kind
 //       Symbol get_type();      return the type 
 //
 //       tree_node *set(tree_node *t)
 //           sets the line number and type of "this" to the values in
 //           the argument tree_node.  Returns "this".
 //
+//   Nodes are allocated from node_arena and are never deleted one at
+//   a time; node_arena.release() frees the whole tree at once.
+//
 //
 ////////////////////////////////////////////////////////////////////////////
+//
+//   A node's kind lets a pass test for a constructor, or switch over
+//   them, without a virtual call or a string compare:
+//
+//       switch (feature->get_kind()) {
+//       case AST_method: ... ((method_class *) feature) ...
+//       case AST_attr:   ... ((attr_class *) feature) ...
+//       }
+//
+//   The values are also the node tags of the binary AST (astbinary.h),
+//   so they must not be renumbered.
+//
+enum NodeKind {
+  AST_list = 0,
+  AST_program = 1, AST_class_, AST_method, AST_attr, AST_formal, AST_branch,
+  AST_assign, AST_static_dispatch, AST_dispatch, AST_cond, AST_loop,
+  AST_typcase, AST_block, AST_let, AST_plus, AST_sub, AST_mul, AST_divide,
+  AST_neg, AST_lt, AST_eq, AST_leq, AST_comp, AST_int_const, AST_bool_const,
+  AST_string_const, AST_new_, AST_isvoid, AST_no_expr, AST_object
+};
+
 class tree_node {
 protected:
     int line_number;            // stash the line number when node is made
+    NodeKind kind;              // set by the constructor of each node
 public:
     tree_node();
+    static void *operator new(size_t size) { return node_arena.alloc(size); }
+    static void operator delete(void *) { }
     virtual tree_node *copy() = 0;
     virtual ~tree_node() { }
     virtual void dump(ostream& stream, int n) = 0;
     int get_line_number();
+    NodeKind get_kind() { return kind; }
     tree_node *set(tree_node *);
 };
 
@@ -93,29 +126,64 @@ public:
 //     int len()
 //     returns the length of the list
 //
+//     iterator begin();
+//     iterator end();
+//     An iterator is a pointer into a contiguous array of the list
+//     elements, so a list may also be traversed as
+//
+//     for(list_node<Elem>::iterator p = l->begin(); p != l->end(); p++)
+//         ... operate on *p ...
+//
 //     nth_length(int n, int &len);
 //     Returns the nth element of the list or NULL if there are not n elements.
 //     "len" is set to the length of the list.  This method is used internally
 //     by the APS package to efficiently traverse the list representation.  
 //
+//     int count();
+//     Elem *copy_into(Elem *out);
+//     count returns the length of the list and copy_into copies its
+//     elements to out, in order, returning the position just past the
+//     last one.  Neither flattens anything; they are used to flatten
+//     append_nodes.  Both walk a chain of append_nodes with a stack of
+//     their own rather than by recursion, so a list built by appending
+//     one element at a time cannot overflow the C stack.
+//
+//     append_node<Elem> *unflattened();
+//     returns the list itself if it is an append_node that has not been
+//     flattened yet, and NULL otherwise.
+//
+//     An append_node is flattened into an array of its elements the first
+//     time it is indexed, so nth, len and the iterators are constant time
+//     once a list has been built.  Lists must not change after they are
+//     first traversed.
+//
 //     static list_node<Elem> *nil();
 //     static list_node<Elem> *single(Elem);
 //     static list_node<Elem> *append(list_node<Elem> *, list_node<Elem> *);
+//     static list_node<Elem> *array(Elem *elems, int n);
 //
-//     These three functions construct an empty list, a list of one element,
-//     and append two lists, respectively.  Note that the functions are static;
-//     there is no "this" parameter.  Example uses:
+//     These functions construct an empty list, a list of one element,
+//     the append of two lists, and a list of the n elements at elems,
+//     respectively.  The array is not copied, so it must live as long as
+//     the list; allocate it from node_arena.  Note that the functions are
+//     static; there is no "this" parameter.  Example uses:
 //
 //     list_node<Elem>::nil();
 //     list_node<Elem>::single(e);     where "e" has type Elem
 //     list_node<Elem>::append(l1,l2);
+//     list_node<Elem>::array(a,n);    where "a" has type Elem *
 //
 //////////////////////////////////////////////////////////////////////////////
 
+template <class Elem> class append_node;
+
 template <class Elem> class list_node : public tree_node {
 public:
+    typedef Elem *iterator;
+
     tree_node *copy()            { return copy_list(); }
     Elem nth(int n);
+    iterator end()   { return begin() + len(); }
     //
     // The next three define a simple iterator.
     //
@@ -126,11 +194,16 @@ public:
     virtual list_node<Elem> *copy_list() = 0;
     virtual ~list_node() { }
     virtual int len() = 0;
+    virtual iterator begin() = 0;
     virtual Elem nth_length(int n, int &len) = 0;
+    virtual int count() = 0;
+    virtual Elem *copy_into(Elem *out) = 0;
+    virtual append_node<Elem> *unflattened() { return NULL; }
 
     static list_node<Elem> *nil();
     static list_node<Elem> *single(Elem);
     static list_node<Elem> *append(list_node<Elem> *l1,list_node<Elem> *l2);
+    static list_node<Elem> *array(Elem *elems, int n);
 };
 
 char *pad(int n);
@@ -141,7 +214,10 @@ template <class Elem> class nil_node : public list_node<Elem> {
 public:
     list_node<Elem> *copy_list();
     int len();
+    Elem *begin()    { return NULL; }
     Elem nth_length(int n, int &len);
+    int count()      { return 0; }
+    Elem *copy_into(Elem *out)  { return out; }
     void dump(ostream& stream, int n);
 };
 
@@ -153,7 +229,10 @@ public:
     }
     list_node<Elem> *copy_list();
     int len();
+    Elem *begin()    { return &elem; }
     Elem nth_length(int n, int &len);
+    int count()      { return 1; }
+    Elem *copy_into(Elem *out)  { *out = elem; return out + 1; }
     void dump(ostream& stream, int n);
 };
 
@@ -161,19 +240,50 @@ public:
 template <class Elem> class append_node : public list_node<Elem> {
 private:
     list_node<Elem> *some, *rest;
+    Elem *elems;     // the flattened list, or NULL until first needed
+    int length;      // the number of elements in elems
+    void flatten();
 public:
     append_node(list_node<Elem> *l1, list_node<Elem> *l2) {
 	some = l1;
 	rest = l2;
+	elems = NULL;
+	length = 0;
     }
     list_node<Elem> *copy_list();
     int len();
+    Elem *begin()    { if (!elems) flatten(); return elems; }
     Elem nth(int n);
     Elem nth_length(int n, int &len);
+    int count();
+    Elem *copy_into(Elem *out);
+    append_node<Elem> *unflattened()  { return elems ? NULL : this; }
     void dump(ostream& stream, int n);
 };
 
 
+//
+// An array_node is a list built all at once, such as one the parser
+// has collected; it is a single node over a contiguous array.
+//
+template <class Elem> class array_node : public list_node<Elem> {
+private:
+    Elem *elems;
+    int length;
+public:
+    array_node(Elem *e, int n) {
+	elems = e;
+	length = n;
+    }
+    list_node<Elem> *copy_list();
+    int len()        { return length; }
+    Elem *begin()    { return elems; }
+    Elem nth_length(int n, int &len);
+    int count()      { return length; }
+    Elem *copy_into(Elem *out);
+    void dump(ostream& stream, int n);
+};
+
 template <class Elem> single_list_node<Elem> *list(Elem x);
 template <class Elem> append_node<Elem> *cons(Elem x, list_node<Elem> *l);
 template <class Elem> append_node<Elem> *xcons(list_node<Elem> *l, Elem x);
@@ -184,6 +294,9 @@ template <class Elem> list_node<Elem> *list_node<Elem>::single(Elem e) { return
 template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *l1,list_node<Elem> *l2) {
    return new append_node<Elem>(l1,l2);
 }
+template <class Elem> list_node<Elem> *list_node<Elem>::array(Elem *elems, int n) {
+   return new array_node<Elem>(elems,n);
+}
 
 
 ///////////////////////////////////////////////////////////////////////////
@@ -196,11 +309,8 @@ template <class Elem> list_node<Elem> *list_node<Elem>::append(list_node<Elem> *
 
 template <class Elem> Elem list_node<Elem>::nth(int n)
 {
-    int len;
-    Elem tmp = nth_length(n ,len);
-
-    if (tmp)
-	return tmp;
+    if (n >= 0 && n < len() && begin()[n])
+	return begin()[n];
     else {
 	cerr << "error: outside the range of the list\n";
 	exit(1);
@@ -210,11 +320,10 @@ template <class Elem> Elem list_node<Elem>::nth(int n)
 // added 10/30/06 cgs
 template <class Elem> Elem append_node<Elem>::nth(int n)
 {
-    int len;
-    Elem tmp = nth_length(n ,len);
-
-    if (tmp)
-	return tmp;
+    if (!elems)
+	flatten();
+    if (n >= 0 && n < length && elems[n])
+	return elems[n];
     else {
 	cerr << "error: outside the range of the list\n";
 	exit(1);
@@ -335,12 +444,17 @@ template <class Elem> void single_list_node<Elem>::dump(ostream& stream, int n)
 //
 // append_node::copy_list
 //
-// return the deep copy of the append_node
+// return the deep copy of the append_node, as one array_node so that
+// copying a long append chain does not recurse down it
 //
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
 {
-    return new append_node<Elem>(some->copy_list(), rest->copy_list());
+    int n = len();
+    Elem *copy = (Elem *) node_arena.alloc((n ? n : 1) * sizeof(Elem));
+    for (int i = 0; i < n; i++)
+	copy[i] = (Elem) elems[i]->copy();
+    return new array_node<Elem>(copy, n);
 }
 
 
@@ -353,7 +467,81 @@ template <class Elem> list_node<Elem> *append_node<Elem>::copy_list()
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> int append_node<Elem>::len()
 {
-    return some->len() + rest->len();
+    if (!elems)
+	flatten();
+    return length;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// append_node::flatten
+//
+// copy the elements of both sublists into one array in node_arena;
+// the sublists themselves are left alone
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> void append_node<Elem>::flatten()
+{
+    length = count();
+    elems = (Elem *) node_arena.alloc((length ? length : 1) * sizeof(Elem));
+    rest->copy_into(some->copy_into(elems));
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// append_node::count
+//
+// add up the lengths of the sublists that are not unflattened
+// append_nodes themselves, taking those apart on a stack
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> int append_node<Elem>::count()
+{
+    if (elems)
+	return length;
+    int n = 0;
+    std::vector<list_node<Elem> *> todo(1, this);
+    while (!todo.empty()) {
+	list_node<Elem> *l = todo.back();
+	todo.pop_back();
+	append_node<Elem> *a = l->unflattened();
+	if (a) {
+	    todo.push_back(a->rest);
+	    todo.push_back(a->some);
+	} else
+	    n += l->count();
+    }
+    return n;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// append_node::copy_into
+//
+// the same walk as count, copying the sublists in order
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> Elem *append_node<Elem>::copy_into(Elem *out)
+{
+    if (elems) {
+	memcpy(out, elems, length * sizeof(Elem));
+	return out + length;
+    }
+    std::vector<list_node<Elem> *> todo(1, this);
+    while (!todo.empty()) {
+	list_node<Elem> *l = todo.back();
+	todo.pop_back();
+	append_node<Elem> *a = l->unflattened();
+	if (a) {
+	    todo.push_back(a->rest);
+	    todo.push_back(a->some);
+	} else
+	    out = l->copy_into(out);
+    }
+    return out;
 }
 
 
@@ -366,14 +554,11 @@ template <class Elem> int append_node<Elem>::len()
 ///////////////////////////////////////////////////////////////////////////
 template <class Elem> Elem append_node<Elem>::nth_length(int n, int &len)
 {
-    int rlen;
-    Elem tmp = some->nth_length(n, len);
-
-    if (!tmp) {
-	tmp = rest->nth_length(n-len, rlen);
-	len += rlen;
-    }
-    return tmp;
+    len = this->len();
+    if (n >= 0 && n < len)
+	return elems[n];
+    else
+	return NULL;
 }
 
 
@@ -396,6 +581,67 @@ template <class Elem> void append_node<Elem>::dump(ostream& stream, int n)
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+//
+// array_node::copy_list
+//
+// return the deep copy of the array_node
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> list_node<Elem> *array_node<Elem>::copy_list()
+{
+    Elem *copy = (Elem *) node_arena.alloc((length ? length : 1) * sizeof(Elem));
+    for (int i = 0; i < length; i++)
+	copy[i] = (Elem) elems[i]->copy();
+    return new array_node<Elem>(copy, length);
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// array_node::copy_into
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> Elem *array_node<Elem>::copy_into(Elem *out)
+{
+    memcpy(out, elems, length * sizeof(Elem));
+    return out + length;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// array_node::nth_length
+//
+// return the nth element on the list
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> Elem array_node<Elem>::nth_length(int n, int &len)
+{
+    len = length;
+    if (n >= 0 && n < len)
+	return elems[n];
+    else
+	return NULL;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// array_node::dump
+//
+// dump for list node
+//
+///////////////////////////////////////////////////////////////////////////
+template <class Elem> void array_node<Elem>::dump(ostream& stream, int n)
+{
+    stream << pad(n) << "list\n";
+    for (int i = 0; i < length; i++)
+      elems[i]->dump(stream, n+2);
+    stream << pad(n) << "(end_of_list)\n";
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // list
@@ -31,6 +31,11 @@ extern int cool_yydebug;        // for the parser
 
        int cgen_optimize;       // optimize switch for code generator 
        char *out_filename;      // file name for generated code
+       int binary_ast;          // pass the AST between phases in binary form
+       int compile_jobs;        // processes coolc parses its input files in,
+                                // and threads semant checks classes on
+       char *semant_cache_file; // file semant keeps its incremental cache in
+       char *dep_graph_file;    // file semant writes the class dependencies to
        Memmgr cgen_Memmgr = GC_NOGC;      // enable/disable garbage collection
        Memmgr_Test cgen_Memmgr_Test = GC_NORMAL;  // normal/test GC
        Memmgr_Debug cgen_Memmgr_Debug = GC_QUICK; // check heap frequently
@@ -51,9 +56,13 @@ void handle_flags(int argc, char *argv[]) {
   cgen_debug = 0;
   cgen_optimize = 0;
   disable_reg_alloc = 0;
+  binary_ast = 0;
+  compile_jobs = 1;
+  semant_cache_file = NULL;
+  dep_graph_file = NULL;
   
 
-  while ((c = getopt(argc, argv, "lpscvrOo:gtT")) != -1) {
+  while ((c = getopt(argc, argv, "lpscvrOo:gtTbj:i:d:")) != -1) {
     switch (c) {
 #ifdef DEBUG
     case 'l':
@@ -99,6 +108,20 @@ void handle_flags(int argc, char *argv[]) {
     case 'O':  // enable optimization
       cgen_optimize = 1;
       break;
+    case 'b':  // write the AST in binary form (see astbinary.h)
+      binary_ast = 1;
+      break;
+    case 'j':  // parse the input files (coolc) and check classes in parallel
+      compile_jobs = atoi(optarg);
+      if (compile_jobs < 1)
+	unknownopt = 1;
+      break;
+    case 'i':  // check only the classes that changed since the last run
+      semant_cache_file = optarg;
+      break;
+    case 'd':  // write the class dependency graph (see semant.cc)
+      dep_graph_file = optarg;
+      break;
     case '?':
       unknownopt = 1;
       break;
@@ -111,9 +134,9 @@ void handle_flags(int argc, char *argv[]) {
   if (unknownopt) {
       cerr << "usage: " << argv[0] << 
 #ifdef DEBUG
-	  " [-lvpscOgtTr -o outname] [input-files]\n";
+	  " [-lvpscOgtTrb -o outname -j jobs -i cache -d depfile] [input-files]\n";
 #else
-      " [-OgtT -o outname] [input-files]\n";
+      " [-OgtTb -o outname -j jobs -i cache -d depfile] [input-files]\n";
 #endif
       exit(1);
   }
@@ -0,0 +1,104 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+///////////////////////////////////////////////////////////////////////////
+//
+// file: arena.cc
+//
+// Bump allocators for AST nodes and string table characters.
+//
+///////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "utilities.h"   // for fatal_error
+
+NodeArena node_arena;
+Arena string_arena;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Arena::alloc_chunk
+//
+// Start a new chunk big enough for size bytes and allocate from it.
+// Oversized requests get a chunk of their own, which is linked in
+// behind the current chunk so the rest of that chunk is not wasted.
+//
+///////////////////////////////////////////////////////////////////////////
+void *Arena::alloc_chunk(size_t size)
+{
+    size_t bytes = size > ARENA_CHUNK / 4 ? size : ARENA_CHUNK;
+    Chunk *c = (Chunk *) calloc(1, sizeof(Chunk) + bytes);
+    if (c == NULL)
+	fatal_error("out of memory\n");
+
+    char *data = (char *) (c + 1);
+    if (bytes != ARENA_CHUNK && chunks != NULL) {
+	c->next = chunks->next;
+	chunks->next = c;
+	return data;
+    }
+    c->next = chunks;
+    chunks = c;
+    cur = data + size;
+    limit = data + bytes;
+    return data;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Arena::copy_string
+//
+///////////////////////////////////////////////////////////////////////////
+char *Arena::copy_string(const char *s, int len)
+{
+    char *str = (char *) alloc(len + 1);
+    memcpy(str, s, len);
+    str[len] = '\0';
+    return str;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Arena::release
+//
+///////////////////////////////////////////////////////////////////////////
+void Arena::release()
+{
+    while (chunks) {
+	Chunk *next = chunks->next;
+	free(chunks);
+	chunks = next;
+    }
+    cur = limit = NULL;
+    used = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// NodeArena::release
+//
+///////////////////////////////////////////////////////////////////////////
+void NodeArena::release()
+{
+    for (int i = 0; i < NODE_POOLS; i++)
+	pools[i].release();
+    large.release();
+}
+
+///////////////////////////////////////////////////////////////////////////
+//
+// NodeArena::size
+//
+///////////////////////////////////////////////////////////////////////////
+size_t NodeArena::size() const
+{
+    size_t total = large.size();
+    for (int i = 0; i < NODE_POOLS; i++)
+	total += pools[i].size();
+    return total;
+}
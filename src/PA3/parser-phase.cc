@@ -18,6 +18,7 @@
 #include "cool-tree.h"
 #include "utilities.h"  // for fatal_error
 #include "cool-parse.h"
+#include "astbinary.h"
 
 //
 // These globals keep everything working.
@@ -29,6 +30,7 @@ extern Program ast_root;	 // the AST produced by the parse
 char *curr_filename = "<stdin>";
 
 extern int omerrs;             // a count of lex and parse errors
+extern int binary_ast;         // write the AST in binary form
 
 extern int cool_yyparse();
 void handle_flags(int argc, char *argv[]);
@@ -40,7 +42,10 @@ int main(int argc, char *argv[]) {
 	cerr << "Compilation halted due to lex and parse errors\n";
 	exit(1);
     }
-    ast_root->dump_with_types(cout,0);
+    if (binary_ast)
+	dump_binary(cout, ast_root);
+    else
+	ast_root->dump_with_types(cout,0);
     return 0;
 }
 
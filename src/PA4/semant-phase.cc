@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include "cool-tree.h"
+#include "astbinary.h"
 
 extern Program ast_root;      // root of the abstract syntax tree
 FILE *ast_file = stdin;       // we read the AST from standard input
 extern int ast_yyparse(void); // entry point to the AST parser
+extern int binary_ast;        // write the AST in binary form
 
 int cool_yydebug;     // not used, but needed to link with handle_flags
 char *curr_filename;
@@ -12,8 +14,14 @@ void handle_flags(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
   handle_flags(argc,argv);
-  ast_yyparse();
+  if (is_binary_ast(ast_file))
+    ast_root = read_binary_ast(ast_file);
+  else
+    ast_yyparse();
   ast_root->semant();
-  ast_root->dump_with_types(cout,0);
+  if (binary_ast)
+    dump_binary(cout, ast_root);
+  else
+    ast_root->dump_with_types(cout,0);
 }
 
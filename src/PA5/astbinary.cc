@@ -0,0 +1,637 @@
+//
+// See copyright.h for copyright notice and limitation of liability
+// and disclaimer of warranty provisions.
+//
+#include "copyright.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "cool.h"
+#include "tree.h"
+#include "cool-tree.h"
+#include "astbinary.h"
+#include "utilities.h"
+
+// defined in tree.cc; the line number given to each new node
+extern int node_lineno;
+
+//////////////////////////////////////////////////////////////////
+//
+//  astbinary.cc
+//
+//  The writer and reader for the binary AST described in astbinary.h.
+//
+//  The writer is a recursive traversal like dump_with_types: each
+//  node's dump_binary method records the node and its components with
+//  the AstWriter.  The reader is a recursive descent over the bytes
+//  that rebuilds the tree with the usual constructor functions, setting
+//  node_lineno before each one so that the new node gets the line
+//  number that was written.
+//
+//////////////////////////////////////////////////////////////////
+
+void AstWriter::put_varint(std::string& s, unsigned v)
+{
+  while (v >= 0x80) {
+    s += (char) (v | 0x80);
+    v >>= 7;
+  }
+  s += (char) v;
+}
+
+void AstWriter::node(NodeKind kind, int line)
+{
+  body += (char) kind;
+  put_varint(body, line);
+  nnodes++;
+}
+
+void AstWriter::symbol(Symbol s, AstTable table)
+{
+  if (s == NULL) {
+    put_varint(body, 0);
+    return;
+  }
+  std::unordered_map<Symbol, int>::iterator it = ids.find(s);
+  int id;
+  if (it != ids.end()) {
+    id = it->second;
+  } else {
+    id = ++nsyms;
+    ids[s] = id;
+    syms += (char) table;
+    put_varint(syms, s->get_len());
+    syms.append(s->get_string(), s->get_len());
+  }
+  put_varint(body, id);
+}
+
+void AstWriter::write(ostream& stream)
+{
+  std::string head(AST_MAGIC, AST_MAGIC_LEN);
+  put_varint(head, AST_VERSION);
+  put_varint(head, nsyms);
+  stream.write(head.data(), head.size());
+  stream.write(syms.data(), syms.size());
+  stream.write(body.data(), body.size());
+  stream.flush();
+}
+
+void dump_binary(ostream& stream, Program p)
+{
+  AstWriter w;
+  p->dump_binary(w);
+  w.write(stream);
+}
+
+//
+//  The dump_binary methods.  Components go out in constructor order,
+//  except that a class gives its file name before its features, as
+//  dump_with_types does.  That way the first string entered in the
+//  string table is still the file name of the first class.
+//
+
+template <class Elem>
+static void dump_binary_list(AstWriter& w, list_node<Elem> *l)
+{
+  w.length(l->len());
+  for (int i = l->first(); l->more(i); i = l->next(i))
+    l->nth(i)->dump_binary(w);
+}
+
+void program_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_program, line_number);
+  dump_binary_list(w, classes);
+}
+
+void class__class::dump_binary(AstWriter& w)
+{
+  w.node(AST_class_, line_number);
+  w.symbol(name, AST_IDTABLE);
+  w.symbol(parent, AST_IDTABLE);
+  w.symbol(filename, AST_STRTABLE);
+  dump_binary_list(w, features);
+}
+
+void method_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_method, line_number);
+  w.symbol(name, AST_IDTABLE);
+  dump_binary_list(w, formals);
+  w.symbol(return_type, AST_IDTABLE);
+  expr->dump_binary(w);
+}
+
+void attr_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_attr, line_number);
+  w.symbol(name, AST_IDTABLE);
+  w.symbol(type_decl, AST_IDTABLE);
+  init->dump_binary(w);
+}
+
+void formal_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_formal, line_number);
+  w.symbol(name, AST_IDTABLE);
+  w.symbol(type_decl, AST_IDTABLE);
+}
+
+void branch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_branch, line_number);
+  w.symbol(name, AST_IDTABLE);
+  w.symbol(type_decl, AST_IDTABLE);
+  expr->dump_binary(w);
+}
+
+void assign_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_assign, line_number);
+  w.symbol(name, AST_IDTABLE);
+  expr->dump_binary(w);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void static_dispatch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_static_dispatch, line_number);
+  expr->dump_binary(w);
+  w.symbol(type_name, AST_IDTABLE);
+  w.symbol(name, AST_IDTABLE);
+  dump_binary_list(w, actual);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void dispatch_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_dispatch, line_number);
+  expr->dump_binary(w);
+  w.symbol(name, AST_IDTABLE);
+  dump_binary_list(w, actual);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void cond_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_cond, line_number);
+  pred->dump_binary(w);
+  then_exp->dump_binary(w);
+  else_exp->dump_binary(w);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void loop_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_loop, line_number);
+  pred->dump_binary(w);
+  body->dump_binary(w);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void typcase_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_typcase, line_number);
+  expr->dump_binary(w);
+  dump_binary_list(w, cases);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void block_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_block, line_number);
+  dump_binary_list(w, body);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void let_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_let, line_number);
+  w.symbol(identifier, AST_IDTABLE);
+  w.symbol(type_decl, AST_IDTABLE);
+  init->dump_binary(w);
+  body->dump_binary(w);
+  w.symbol(type, AST_IDTABLE);
+}
+
+#define DUMP_BINARY_ARITH(cls, kind)          \
+void cls::dump_binary(AstWriter& w)           \
+{                                             \
+  w.node(kind, line_number);                  \
+  e1->dump_binary(w);                         \
+  e2->dump_binary(w);                         \
+  w.symbol(type, AST_IDTABLE);                \
+}
+
+DUMP_BINARY_ARITH(plus_class, AST_plus)
+DUMP_BINARY_ARITH(sub_class, AST_sub)
+DUMP_BINARY_ARITH(mul_class, AST_mul)
+DUMP_BINARY_ARITH(divide_class, AST_divide)
+DUMP_BINARY_ARITH(lt_class, AST_lt)
+DUMP_BINARY_ARITH(eq_class, AST_eq)
+DUMP_BINARY_ARITH(leq_class, AST_leq)
+
+#define DUMP_BINARY_UNARY(cls, kind)          \
+void cls::dump_binary(AstWriter& w)           \
+{                                             \
+  w.node(kind, line_number);                  \
+  e1->dump_binary(w);                         \
+  w.symbol(type, AST_IDTABLE);                \
+}
+
+DUMP_BINARY_UNARY(neg_class, AST_neg)
+DUMP_BINARY_UNARY(comp_class, AST_comp)
+DUMP_BINARY_UNARY(isvoid_class, AST_isvoid)
+
+void int_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_int_const, line_number);
+  w.symbol(token, AST_INTTABLE);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void bool_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_bool_const, line_number);
+  w.boolean(val);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void string_const_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_string_const, line_number);
+  w.symbol(token, AST_STRTABLE);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void new__class::dump_binary(AstWriter& w)
+{
+  w.node(AST_new_, line_number);
+  w.symbol(type_name, AST_IDTABLE);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void no_expr_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_no_expr, line_number);
+  w.symbol(type, AST_IDTABLE);
+}
+
+void object_class::dump_binary(AstWriter& w)
+{
+  w.node(AST_object, line_number);
+  w.symbol(name, AST_IDTABLE);
+  w.symbol(type, AST_IDTABLE);
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  The reader.
+//
+//////////////////////////////////////////////////////////////////
+
+class AstReader {
+private:
+  const unsigned char *p, *end;
+  std::vector<Symbol> syms;
+
+  void error(char *msg);
+  unsigned byte();
+  unsigned varint();
+  Symbol symbol();
+  int line(NodeKind kind);
+  void read_symbols();
+
+  Class_ read_class();
+  Feature read_feature();
+  Formal read_formal();
+  Case read_case();
+  Expression read_expression();
+  Expressions read_expressions();
+public:
+  AstReader(const unsigned char *buf, int size) : p(buf), end(buf + size) {}
+  Program read_program();
+};
+
+void AstReader::error(char *msg)
+{
+  cerr << "binary AST: " << msg << endl;
+  exit(1);
+}
+
+unsigned AstReader::byte()
+{
+  if (p == end)
+    error("unexpected end of input");
+  return *p++;
+}
+
+unsigned AstReader::varint()
+{
+  unsigned v = 0;
+  int shift = 0;
+  unsigned b;
+  do {
+    if (shift > 28)
+      error("bad number");
+    b = byte();
+    v |= (b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return v;
+}
+
+Symbol AstReader::symbol()
+{
+  unsigned id = varint();
+  if (id == 0)
+    return NULL;
+  if (id > syms.size())
+    error("bad symbol reference");
+  return syms[id - 1];
+}
+
+//
+//  Check the kind of the next node and return its line number.
+//
+int AstReader::line(NodeKind kind)
+{
+  if (byte() != (unsigned) kind)
+    error("unexpected node");
+  return varint();
+}
+
+void AstReader::read_symbols()
+{
+  if (end - p < AST_MAGIC_LEN || memcmp(p, AST_MAGIC, AST_MAGIC_LEN) != 0)
+    error("bad magic number");
+  p += AST_MAGIC_LEN;
+  if (varint() != AST_VERSION)
+    error("unsupported version");
+
+  unsigned n = varint();
+  syms.reserve(n);
+  std::string s;
+  for (unsigned i = 0; i < n; i++) {
+    unsigned table = byte();
+    unsigned len = varint();
+    if (len > (unsigned) (end - p))
+      error("unexpected end of input");
+    s.assign((const char *) p, len);
+    p += len;
+    switch (table) {
+    case AST_IDTABLE:
+      syms.push_back(idtable.add_string((char *) s.c_str(), len));
+      break;
+    case AST_INTTABLE:
+      syms.push_back(inttable.add_string((char *) s.c_str(), len));
+      break;
+    case AST_STRTABLE:
+      syms.push_back(stringtable.add_string((char *) s.c_str(), len));
+      break;
+    default:
+      error("bad symbol table");
+    }
+  }
+}
+
+Program AstReader::read_program()
+{
+  read_symbols();
+  int lineno = line(AST_program);
+  unsigned n = varint();
+  Classes classes = nil_Classes();
+  for (unsigned i = 0; i < n; i++)
+    classes = append_Classes(classes, single_Classes(read_class()));
+  node_lineno = lineno;
+  return program(classes);
+}
+
+Class_ AstReader::read_class()
+{
+  int lineno = line(AST_class_);
+  Symbol name = symbol();
+  Symbol parent = symbol();
+  Symbol filename = symbol();
+  unsigned n = varint();
+  Features features = nil_Features();
+  for (unsigned i = 0; i < n; i++)
+    features = append_Features(features, single_Features(read_feature()));
+  node_lineno = lineno;
+  return class_(name, parent, features, filename);
+}
+
+Feature AstReader::read_feature()
+{
+  unsigned kind = byte();
+  int lineno = varint();
+  Symbol name = symbol();
+  if (kind == AST_method) {
+    unsigned n = varint();
+    Formals formals = nil_Formals();
+    for (unsigned i = 0; i < n; i++)
+      formals = append_Formals(formals, single_Formals(read_formal()));
+    Symbol return_type = symbol();
+    Expression expr = read_expression();
+    node_lineno = lineno;
+    return method(name, formals, return_type, expr);
+  }
+  if (kind != AST_attr)
+    error("unexpected node");
+  Symbol type_decl = symbol();
+  Expression init = read_expression();
+  node_lineno = lineno;
+  return attr(name, type_decl, init);
+}
+
+Formal AstReader::read_formal()
+{
+  int lineno = line(AST_formal);
+  Symbol name = symbol();
+  Symbol type_decl = symbol();
+  node_lineno = lineno;
+  return formal(name, type_decl);
+}
+
+Case AstReader::read_case()
+{
+  int lineno = line(AST_branch);
+  Symbol name = symbol();
+  Symbol type_decl = symbol();
+  Expression expr = read_expression();
+  node_lineno = lineno;
+  return branch(name, type_decl, expr);
+}
+
+Expressions AstReader::read_expressions()
+{
+  unsigned n = varint();
+  Expressions l = nil_Expressions();
+  for (unsigned i = 0; i < n; i++)
+    l = append_Expressions(l, single_Expressions(read_expression()));
+  return l;
+}
+
+Expression AstReader::read_expression()
+{
+  unsigned kind = byte();
+  int lineno = varint();
+  Expression e = NULL, e1, e2, e3;
+  Symbol s1, s2;
+  Expressions l;
+
+  switch (kind) {
+  case AST_assign:
+    s1 = symbol();
+    e1 = read_expression();
+    node_lineno = lineno;
+    e = assign(s1, e1);
+    break;
+  case AST_static_dispatch:
+    e1 = read_expression();
+    s1 = symbol();
+    s2 = symbol();
+    l = read_expressions();
+    node_lineno = lineno;
+    e = static_dispatch(e1, s1, s2, l);
+    break;
+  case AST_dispatch:
+    e1 = read_expression();
+    s1 = symbol();
+    l = read_expressions();
+    node_lineno = lineno;
+    e = dispatch(e1, s1, l);
+    break;
+  case AST_cond:
+    e1 = read_expression();
+    e2 = read_expression();
+    e3 = read_expression();
+    node_lineno = lineno;
+    e = cond(e1, e2, e3);
+    break;
+  case AST_loop:
+    e1 = read_expression();
+    e2 = read_expression();
+    node_lineno = lineno;
+    e = loop(e1, e2);
+    break;
+  case AST_typcase: {
+    e1 = read_expression();
+    unsigned n = varint();
+    Cases cases = nil_Cases();
+    for (unsigned i = 0; i < n; i++)
+      cases = append_Cases(cases, single_Cases(read_case()));
+    node_lineno = lineno;
+    e = typcase(e1, cases);
+    break;
+  }
+  case AST_block:
+    l = read_expressions();
+    node_lineno = lineno;
+    e = block(l);
+    break;
+  case AST_let:
+    s1 = symbol();
+    s2 = symbol();
+    e1 = read_expression();
+    e2 = read_expression();
+    node_lineno = lineno;
+    e = let(s1, s2, e1, e2);
+    break;
+  case AST_plus:
+  case AST_sub:
+  case AST_mul:
+  case AST_divide:
+  case AST_lt:
+  case AST_eq:
+  case AST_leq:
+    e1 = read_expression();
+    e2 = read_expression();
+    node_lineno = lineno;
+    switch (kind) {
+    case AST_plus:   e = plus(e1, e2);   break;
+    case AST_sub:    e = sub(e1, e2);    break;
+    case AST_mul:    e = mul(e1, e2);    break;
+    case AST_divide: e = divide(e1, e2); break;
+    case AST_lt:     e = lt(e1, e2);     break;
+    case AST_eq:     e = eq(e1, e2);     break;
+    default:         e = leq(e1, e2);    break;
+    }
+    break;
+  case AST_neg:
+    e1 = read_expression();
+    node_lineno = lineno;
+    e = neg(e1);
+    break;
+  case AST_comp:
+    e1 = read_expression();
+    node_lineno = lineno;
+    e = comp(e1);
+    break;
+  case AST_isvoid:
+    e1 = read_expression();
+    node_lineno = lineno;
+    e = isvoid(e1);
+    break;
+  case AST_int_const:
+    s1 = symbol();
+    node_lineno = lineno;
+    e = int_const(s1);
+    break;
+  case AST_bool_const: {
+    Boolean b = byte();
+    node_lineno = lineno;
+    e = bool_const(b);
+    break;
+  }
+  case AST_string_const:
+    s1 = symbol();
+    node_lineno = lineno;
+    e = string_const(s1);
+    break;
+  case AST_new_:
+    s1 = symbol();
+    node_lineno = lineno;
+    e = new_(s1);
+    break;
+  case AST_no_expr:
+    node_lineno = lineno;
+    e = no_expr();
+    break;
+  case AST_object:
+    s1 = symbol();
+    node_lineno = lineno;
+    e = object(s1);
+    break;
+  default:
+    error("unexpected node");
+  }
+  return e->set_type(symbol());
+}
+
+bool is_binary_ast(FILE *f)
+{
+  int c = getc(f);
+  if (c == EOF)
+    return false;
+  ungetc(c, f);
+  return c == AST_MAGIC[0];
+}
+
+Program read_binary_ast(FILE *f)
+{
+  std::vector<unsigned char> buf;
+  unsigned char chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    buf.insert(buf.end(), chunk, chunk + n);
+  return read_binary_ast(buf.data(), buf.size());
+}
+
+Program read_binary_ast(const unsigned char *buf, int size)
+{
+  AstReader r(buf, size);
+  return r.read_program();
+}
@@ -4,6 +4,8 @@
 #include "cool-io.h"  //includes iostream
 #include "cool-tree.h"
 #include "cgen_gc.h"
+#include "astbinary.h"
+#include "asmwriter.h"
 
 extern int optind;            // for option processing
 extern char *out_filename;    // name of output assembly
@@ -34,17 +36,26 @@ int main(int argc, char *argv[]) {
   // Don't touch the output file until we know that earlier phases of the
   // compiler have succeeded.
   //
-  ast_yyparse();
+  if (is_binary_ast(ast_file))
+    ast_root = read_binary_ast(ast_file);
+  else
+    ast_yyparse();
 
   if (out_filename) {
-      ofstream s(out_filename);
-      if (!s) {
+      AsmWriter s(out_filename);
+      if (!s.ok()) {
 	  cerr << "Cannot open output file " << out_filename << endl;
 	  exit(1);
       }
       ast_root->cgen(s);
+      s.flush();
+      if (!s.ok()) {
+	  cerr << "Cannot write output file " << out_filename << endl;
+	  exit(1);
+      }
   } else {
-      ast_root->cgen(cout);
+      AsmWriter s(cout);
+      ast_root->cgen(s);
   }
 }
 